@@ -16,8 +16,9 @@ struct Route {
     regex pathPattern;
     vector<string> paramNames;
     RouteHandler handler;
+    bool streamsBody;  // the handler reads the body itself, see HttpRequest::readBody
 
-    Route(HttpMethod m, const string& p, RouteHandler h);
+    Route(HttpMethod m, const string& p, RouteHandler h, bool streaming = false);
     bool matches(HttpMethod m, const string& requestPath) const;
     void extractParams(const string& requestPath, HttpRequest& request) const;
 };
@@ -37,7 +38,11 @@ public:
     void post(const string& path, RouteHandler handler);
     void put(const string& path, RouteHandler handler);
     void del(const string& path, RouteHandler handler);
-    void registerRoute(HttpMethod method, const string& path, RouteHandler handler);
+    // POST route whose body is streamed to the handler rather than buffered
+    void postStream(const string& path, RouteHandler handler);
+    void registerRoute(HttpMethod method, const string& path, RouteHandler handler, bool streaming = false);
+
+    bool streamsBody(HttpMethod method, const string& path) const;
 
     HttpResponse handleRequest(const HttpRequest& request);
     HttpResponse routeRequest(HttpMethod method, const string& path, const HttpRequest& request);
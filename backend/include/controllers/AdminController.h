@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include "../storage/Snapshot.h"
+#include "../http/HttpModels.h"
+
+using namespace std;
+
+class AdminController {
+private:
+    SnapshotManager* snapshots;
+
+public:
+    AdminController(SnapshotManager* manager);
+
+    HttpResponse createSnapshot(const HttpRequest& req);
+};
@@ -11,16 +11,23 @@ class BookController {
 private:
     Library* library;
 
+    map<string, string> bookFields(const Book& book);
     string bookToJson(const Book& book);
     string booksToJson(const vector<Book>& books);
 
+    HttpResponse rankedSearch(const HttpRequest& request);
+
 public:
     BookController(Library* lib);
 
     HttpResponse getAllBooks(const HttpRequest& request);
     HttpResponse getBookById(const HttpRequest& request);
     HttpResponse searchBooks(const HttpRequest& request);
+    HttpResponse suggestBooks(const HttpRequest& request);
+    HttpResponse getRecommendations(const HttpRequest& request);
     HttpResponse createBook(const HttpRequest& request);
+    // NDJSON or CSV, read from the body as it arrives
+    HttpResponse bulkImport(const HttpRequest& request);
     HttpResponse updateBook(const HttpRequest& request);
     HttpResponse deleteBook(const HttpRequest& request);
     HttpResponse getBorrowHistory(const HttpRequest& request);
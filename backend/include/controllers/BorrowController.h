@@ -17,4 +17,6 @@ public:
     HttpResponse borrowBook(const HttpRequest& req);
     HttpResponse returnBook(const HttpRequest& req);
     HttpResponse getBorrowHistory(const HttpRequest& req);
+    HttpResponse getOverdueLoans(const HttpRequest& req);
+    HttpResponse getBookBorrowers(const HttpRequest& req);
 };
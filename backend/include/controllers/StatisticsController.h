@@ -16,4 +16,12 @@ public:
     HttpResponse getMostBorrowedBooks(const HttpRequest& req);
     HttpResponse getMostActiveUsers(const HttpRequest& req);
     HttpResponse getCategoryDistribution(const HttpRequest& req);
+
+    // event=borrows|returns|registrations, resolution=minute|hour|day, n, category
+    HttpResponse getWindowedCounts(const HttpRequest& req);
+
+    // Sketch-backed estimates; cost and memory do not grow with history
+    HttpResponse getApproxBorrows(const HttpRequest& req);
+    HttpResponse getApproxUniqueBorrowers(const HttpRequest& req);
+    HttpResponse getApproxHeavyHitters(const HttpRequest& req);
 };
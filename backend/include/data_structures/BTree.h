@@ -25,6 +25,14 @@ public:
 
     void splitChild(int i, BTreeNode* child);
 
+    int findKey(const T& key, function<int(const T&, const T&)> compare);
+    bool remove(const T& key, function<int(const T&, const T&)> compare);
+    void removeFromNonLeaf(int idx, function<int(const T&, const T&)> compare);
+    void fill(int idx);
+    void borrowFromPrev(int idx);
+    void borrowFromNext(int idx);
+    void merge(int idx);
+
     void traverse(function<void(const T&)> visit);
 
     void searchByPredicate(function<bool(const T&)> predicate, vector<T>& results);
@@ -39,6 +47,9 @@ private:
     int t;
     function<int(const T&, const T&)> compareFunc;
 
+    BTreeNode<T>* buildSubtree(const vector<T>& sortedKeys, size_t lo, size_t hi, int height, bool isRoot);
+    size_t maxKeysForHeight(int height) const;
+
 public:
 
     BTree(int degree, function<int(const T&, const T&)> compare);
@@ -46,6 +57,10 @@ public:
 
     void insert(const T& key);
 
+    bool remove(const T& key);
+
+    void bulkLoad(const vector<T>& sortedKeys);
+
     T* search(const T& key);
 
     void traverse(function<void(const T&)> visit);
@@ -142,6 +157,134 @@ void BTreeNode<T>::splitChild(int i, BTreeNode* child) {
     children.insert(children.begin() + i + 1, newNode);
 }
 
+// Index of the first key that is >= key.
+template <typename T>
+int BTreeNode<T>::findKey(const T& key, function<int(const T&, const T&)> compare) {
+    int idx = 0;
+    while (idx < (int)keys.size() && compare(keys[idx], key) < 0) {
+        idx++;
+    }
+    return idx;
+}
+
+// Deletes key from the subtree rooted here. Every child we descend into is
+// first topped up to at least t keys, so the removal never underflows.
+template <typename T>
+bool BTreeNode<T>::remove(const T& key, function<int(const T&, const T&)> compare) {
+    int idx = findKey(key, compare);
+
+    if (idx < (int)keys.size() && compare(keys[idx], key) == 0) {
+        if (isLeaf) {
+            keys.erase(keys.begin() + idx);
+        } else {
+            removeFromNonLeaf(idx, compare);
+        }
+        return true;
+    }
+
+    if (isLeaf) {
+        return false;
+    }
+
+    bool inLastChild = (idx == (int)keys.size());
+    if ((int)children[idx]->keys.size() < t) {
+        fill(idx);
+    }
+
+    if (inLastChild && idx > (int)keys.size()) {
+        return children[idx - 1]->remove(key, compare);
+    }
+    return children[idx]->remove(key, compare);
+}
+
+template <typename T>
+void BTreeNode<T>::removeFromNonLeaf(int idx, function<int(const T&, const T&)> compare) {
+    T key = keys[idx];
+
+    if ((int)children[idx]->keys.size() >= t) {
+        BTreeNode* cur = children[idx];
+        while (!cur->isLeaf) {
+            cur = cur->children.back();
+        }
+        T predecessor = cur->keys.back();
+        keys[idx] = predecessor;
+        children[idx]->remove(predecessor, compare);
+    } else if ((int)children[idx + 1]->keys.size() >= t) {
+        BTreeNode* cur = children[idx + 1];
+        while (!cur->isLeaf) {
+            cur = cur->children.front();
+        }
+        T successor = cur->keys.front();
+        keys[idx] = successor;
+        children[idx + 1]->remove(successor, compare);
+    } else {
+        merge(idx);
+        children[idx]->remove(key, compare);
+    }
+}
+
+template <typename T>
+void BTreeNode<T>::fill(int idx) {
+    if (idx != 0 && (int)children[idx - 1]->keys.size() >= t) {
+        borrowFromPrev(idx);
+    } else if (idx != (int)keys.size() && (int)children[idx + 1]->keys.size() >= t) {
+        borrowFromNext(idx);
+    } else if (idx != (int)keys.size()) {
+        merge(idx);
+    } else {
+        merge(idx - 1);
+    }
+}
+
+template <typename T>
+void BTreeNode<T>::borrowFromPrev(int idx) {
+    BTreeNode* child = children[idx];
+    BTreeNode* sibling = children[idx - 1];
+
+    child->keys.insert(child->keys.begin(), keys[idx - 1]);
+    if (!child->isLeaf) {
+        child->children.insert(child->children.begin(), sibling->children.back());
+        sibling->children.pop_back();
+    }
+
+    keys[idx - 1] = sibling->keys.back();
+    sibling->keys.pop_back();
+}
+
+template <typename T>
+void BTreeNode<T>::borrowFromNext(int idx) {
+    BTreeNode* child = children[idx];
+    BTreeNode* sibling = children[idx + 1];
+
+    child->keys.push_back(keys[idx]);
+    if (!child->isLeaf) {
+        child->children.push_back(sibling->children.front());
+        sibling->children.erase(sibling->children.begin());
+    }
+
+    keys[idx] = sibling->keys.front();
+    sibling->keys.erase(sibling->keys.begin());
+}
+
+// Folds keys[idx] and children[idx + 1] into children[idx].
+template <typename T>
+void BTreeNode<T>::merge(int idx) {
+    BTreeNode* child = children[idx];
+    BTreeNode* sibling = children[idx + 1];
+
+    child->keys.push_back(keys[idx]);
+    child->keys.insert(child->keys.end(), sibling->keys.begin(), sibling->keys.end());
+    if (!child->isLeaf) {
+        child->children.insert(child->children.end(), sibling->children.begin(), sibling->children.end());
+    }
+
+    keys.erase(keys.begin() + idx);
+    children.erase(children.begin() + idx + 1);
+
+    sibling->children.clear();
+    delete sibling;
+}
+
 template <typename T>
 void BTreeNode<T>::traverse(function<void(const T&)> visit) {
     int i;
@@ -212,6 +355,95 @@ void BTree<T>::insert(const T& key) {
     }
 }
 
+template <typename T>
+bool BTree<T>::remove(const T& key) {
+    if (root == nullptr) {
+        return false;
+    }
+
+    bool removed = root->remove(key, compareFunc);
+
+    if (root->keys.empty()) {
+        BTreeNode<T>* oldRoot = root;
+        if (root->isLeaf) {
+            root = nullptr;
+        } else {
+            root = root->children[0];
+            oldRoot->children.clear();
+        }
+        delete oldRoot;
+    }
+    return removed;
+}
+
+// Largest number of keys a subtree of the given height can hold: (2t)^h - 1.
+template <typename T>
+size_t BTree<T>::maxKeysForHeight(int height) const {
+    size_t capacity = 1;
+    for (int h = 0; h < height; h++) {
+        capacity *= 2 * t;
+    }
+    return capacity - 1;
+}
+
+// Builds a subtree over sortedKeys[lo, hi) with all leaves at `height`.
+// Keys are spread evenly over the children, so every non-root node ends up
+// with between t-1 and 2t-1 keys.
+template <typename T>
+BTreeNode<T>* BTree<T>::buildSubtree(const vector<T>& sortedKeys, size_t lo, size_t hi, int height, bool isRoot) {
+    BTreeNode<T>* node = new BTreeNode<T>(t, height == 1);
+    size_t n = hi - lo;
+
+    if (height == 1) {
+        node->keys.assign(sortedKeys.begin() + lo, sortedKeys.begin() + hi);
+        return node;
+    }
+
+    size_t childCapacity = maxKeysForHeight(height - 1) + 1;
+    size_t childCount = (n + 1 + childCapacity - 1) / childCapacity;
+    if (!isRoot && childCount < (size_t)t) {
+        childCount = t;
+    }
+    if (childCount < 2) {
+        childCount = 2;
+    }
+
+    size_t childKeys = n - (childCount - 1);
+    size_t base = childKeys / childCount;
+    size_t extra = childKeys % childCount;
+
+    size_t pos = lo;
+    for (size_t c = 0; c < childCount; c++) {
+        size_t count = base + (c < extra ? 1 : 0);
+        node->children.push_back(buildSubtree(sortedKeys, pos, pos + count, height - 1, false));
+        pos += count;
+        if (c + 1 < childCount) {
+            node->keys.push_back(sortedKeys[pos]);
+            pos++;
+        }
+    }
+    return node;
+}
+
+// Replaces the tree's contents with keys that are already in comparator
+// order, building nodes bottom-up instead of inserting one key at a time.
+template <typename T>
+void BTree<T>::bulkLoad(const vector<T>& sortedKeys) {
+    if (root) {
+        delete root;
+        root = nullptr;
+    }
+    if (sortedKeys.empty()) {
+        return;
+    }
+
+    int height = 1;
+    while (maxKeysForHeight(height) < sortedKeys.size()) {
+        height++;
+    }
+    root = buildSubtree(sortedKeys, 0, sortedKeys.size(), height, true);
+}
+
 template <typename T>
 T* BTree<T>::search(const T& key) {
     if (root == nullptr) {
@@ -62,6 +62,25 @@ public:
         }
     }
 
+    void reserve(int expectedSize) {
+        int needed = (int)(expectedSize / 0.75) + 1;
+        if (needed <= capacity) {
+            return;
+        }
+
+        vector<list<Entry>> oldTable;
+        oldTable.swap(table);
+        capacity = needed;
+        table.resize(capacity);
+        size = 0;
+
+        for (auto& bucket : oldTable) {
+            for (auto& entry : bucket) {
+                insert(entry.key, entry.value);
+            }
+        }
+    }
+
     optional<V> find(const K& key) const {
         int index = getHash(key);
         for (const auto& entry : table[index]) {
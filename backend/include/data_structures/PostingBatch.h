@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+using namespace std;
+
+// Inserts into sorted ID posting lists. Outside a batch an out-of-order ID is
+// placed with lower_bound (shifting the tail); between begin() and end() it
+// is appended instead and every list touched that way is sorted and merged
+// once at end(), so a batch costs one pass per list rather than one shift
+// per insert. Lists must stay at a stable address while a batch is open.
+class PostingBatch {
+private:
+    bool active = false;
+    unordered_map<vector<int>*, size_t> unsorted;  // list -> length of its sorted prefix
+
+public:
+    void begin() { active = true; }
+
+    void end() {
+        settle();
+        active = false;
+    }
+
+    // Restores the order of the lists appended to so far; the batch stays open.
+    void settle() {
+        for (auto& entry : unsorted) {
+            vector<int>& list = *entry.first;
+            auto middle = list.begin() + entry.second;
+            sort(middle, list.end());
+            inplace_merge(list.begin(), middle, list.end());
+            list.erase(unique(list.begin(), list.end()), list.end());
+        }
+        unsorted.clear();
+    }
+
+    bool pending() const { return !unsorted.empty(); }
+
+    void insert(vector<int>& list, int id) {
+        if (list.empty() || list.back() < id) {
+            list.push_back(id);
+        } else if (active) {
+            if (list.back() == id) return;
+            unsorted.try_emplace(&list, list.size());
+            list.push_back(id);
+        } else {
+            auto pos = lower_bound(list.begin(), list.end(), id);
+            if (pos == list.end() || *pos != id) list.insert(pos, id);
+        }
+    }
+
+    // Forgets the lists without merging them, e.g. when they are cleared.
+    void reset() { unsorted.clear(); }
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+using namespace std;
+
+// Counters kept in rank order. Keys sharing a count live in one bucket and
+// buckets form a list sorted by descending count, so a +1/-1 step only moves
+// a key into a neighbouring bucket (O(1)) and the top K are read straight off
+// the front of the list (O(K)). Within a bucket keys are in arrival order.
+template <typename K>
+class RankedCounter {
+private:
+    struct Bucket {
+        int count;
+        list<K> keys;
+    };
+    using BucketIt = typename list<Bucket>::iterator;
+
+    struct Position {
+        BucketIt bucket;
+        typename list<K>::iterator key;
+    };
+
+    list<Bucket> buckets;
+    unordered_map<K, Position> positions;
+
+    // Bucket holding `count`, created if needed, searching outward from `from`.
+    BucketIt bucketFor(BucketIt from, int count) {
+        while (from != buckets.begin() && prev(from)->count <= count) --from;
+        while (from != buckets.end() && from->count > count) ++from;
+        if (from != buckets.end() && from->count == count) return from;
+        return buckets.insert(from, Bucket{count, {}});
+    }
+
+    void moveTo(Position& pos, BucketIt target) {
+        target->keys.splice(target->keys.end(), pos.bucket->keys, pos.key);
+        if (pos.bucket->keys.empty()) buckets.erase(pos.bucket);
+        pos.bucket = target;
+    }
+
+public:
+    // Positions point into `buckets`, so copies would alias; moves are safe.
+    RankedCounter() = default;
+    RankedCounter(const RankedCounter&) = delete;
+    RankedCounter& operator=(const RankedCounter&) = delete;
+    RankedCounter(RankedCounter&&) = default;
+    RankedCounter& operator=(RankedCounter&&) = default;
+
+    void set(const K& key, int count) {
+        auto it = positions.find(key);
+        if (it == positions.end()) {
+            // New keys usually start low, so search from the tail
+            BucketIt bucket = bucketFor(buckets.end(), count);
+            bucket->keys.push_back(key);
+            positions[key] = {bucket, prev(bucket->keys.end())};
+            return;
+        }
+
+        Position& pos = it->second;
+        if (pos.bucket->count == count) return;
+        moveTo(pos, bucketFor(pos.bucket, count));
+    }
+
+    void add(const K& key, int delta) {
+        auto it = positions.find(key);
+        set(key, (it == positions.end() ? 0 : it->second.bucket->count) + delta);
+    }
+
+    void erase(const K& key) {
+        auto it = positions.find(key);
+        if (it == positions.end()) return;
+
+        BucketIt bucket = it->second.bucket;
+        bucket->keys.erase(it->second.key);
+        if (bucket->keys.empty()) buckets.erase(bucket);
+        positions.erase(it);
+    }
+
+    // Replaces the contents with the given counts in one sort.
+    void assign(vector<pair<K, int>> counts) {
+        clear();
+        stable_sort(counts.begin(), counts.end(),
+                    [](const pair<K, int>& a, const pair<K, int>& b) { return a.second > b.second; });
+        for (const auto& entry : counts) {
+            if (positions.count(entry.first)) continue;
+            if (buckets.empty() || buckets.back().count != entry.second) {
+                buckets.push_back(Bucket{entry.second, {}});
+            }
+            Bucket& bucket = buckets.back();
+            bucket.keys.push_back(entry.first);
+            positions[entry.first] = {prev(buckets.end()), prev(bucket.keys.end())};
+        }
+    }
+
+    void clear() {
+        buckets.clear();
+        positions.clear();
+    }
+
+    bool contains(const K& key) const {
+        return positions.count(key) > 0;
+    }
+
+    int count(const K& key) const {
+        auto it = positions.find(key);
+        return it == positions.end() ? 0 : it->second.bucket->count;
+    }
+
+    int size() const {
+        return (int)positions.size();
+    }
+
+    // A key with the lowest count; the counter must not be empty.
+    pair<K, int> lowest() const {
+        const Bucket& bucket = buckets.back();
+        return {bucket.keys.front(), bucket.count};
+    }
+
+    // The n highest counts as (key, count), highest first.
+    vector<pair<K, int>> top(int n) const {
+        vector<pair<K, int>> result;
+        for (const auto& bucket : buckets) {
+            for (const auto& key : bucket.keys) {
+                if ((int)result.size() >= n) return result;
+                result.push_back({key, bucket.count});
+            }
+        }
+        return result;
+    }
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <algorithm>
+using namespace std;
+
+// Event counts for the most recent fixed-width time windows, kept in a ring
+// buffer. Window w (= time / width) lives in slot w % slots; moving to a
+// newer window zeroes the slots skipped over, so recording is O(1) amortized
+// and memory is fixed.
+class RollingCounter {
+private:
+    int64_t width;
+    vector<uint32_t> slots;
+    int64_t newest;  // window index held by the newest slot, -1 before any event
+
+    bool holds(int64_t window) const {
+        return newest >= 0 && window <= newest && window > newest - (int64_t)slots.size();
+    }
+
+public:
+    RollingCounter(int64_t windowSeconds, int windowCount)
+        : width(windowSeconds), slots(windowCount, 0), newest(-1) {}
+
+    void add(time_t now, uint32_t count = 1) {
+        int64_t window = (int64_t)now / width;
+        if (newest < 0 || window > newest) {
+            int64_t stale = newest < 0 ? (int64_t)slots.size() : min<int64_t>(window - newest, slots.size());
+            for (int64_t w = window - stale + 1; w <= window; w++) {
+                slots[w % slots.size()] = 0;
+            }
+            newest = window;
+        }
+        // Events older than the retained windows are dropped
+        if (holds(window)) slots[window % slots.size()] += count;
+    }
+
+    // Counts of the `count` windows ending with the one containing `now`,
+    // newest first.
+    vector<uint32_t> recent(time_t now, int count) const {
+        vector<uint32_t> result;
+        int64_t window = (int64_t)now / width;
+        for (int i = 0; i < count && i < (int)slots.size(); i++) {
+            result.push_back(holds(window - i) ? slots[(window - i) % slots.size()] : 0);
+        }
+        return result;
+    }
+
+    int64_t windowSeconds() const { return width; }
+    int windowCount() const { return (int)slots.size(); }
+
+    void clear() {
+        fill(slots.begin(), slots.end(), 0);
+        newest = -1;
+    }
+};
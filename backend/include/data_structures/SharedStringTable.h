@@ -0,0 +1,114 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include "../utils/TextUtils.h"
+
+using namespace std;
+
+// Intern table for strings with many distinct values that still repeat
+// (authors). Like StringPool, each distinct string is stored once and equal
+// strings get the same id, here the address of the shared entry, so equality
+// is a pointer compare. Unlike StringPool, entries are reference counted:
+// holders keep a Ref, and an entry is freed with the last Ref to it, so a
+// catalog that is reloaded or edited does not leave its old strings behind.
+//
+// Every entry also holds a Ref to the entry for its lowercase form (or none
+// when it is already lowercase), which keeps case-insensitive equality a
+// pointer compare too.
+class SharedStringTable {
+public:
+    struct Entry {
+        string text;
+        shared_ptr<const Entry> lower;  // null when text is already lowercase
+
+        const Entry* folded() const { return lower ? lower.get() : this; }
+        const string& key() const { return folded()->text; }
+    };
+    using Ref = shared_ptr<const Entry>;
+    using Id = const Entry*;
+
+private:
+    static const size_t SHARDS = 16;
+
+    struct Shard {
+        // Keys view the text of the entry they name
+        unordered_map<string_view, weak_ptr<const Entry>> entries;
+        mutex lock;
+    };
+
+    mutable Shard shards[SHARDS];
+
+    Shard& shardFor(string_view s) const {
+        return shards[hash<string_view>()(s) % SHARDS];
+    }
+
+    // Unlinks the entry before freeing it. A dead entry may already have been
+    // replaced by a new one for the same text, which is left alone.
+    struct Release {
+        SharedStringTable* table;
+
+        void operator()(const Entry* e) const {
+            {
+                Shard& shard = table->shardFor(e->text);
+                lock_guard<mutex> guard(shard.lock);
+                auto it = shard.entries.find(e->text);
+                if (it != shard.entries.end() && it->first.data() == e->text.data()) {
+                    shard.entries.erase(it);
+                }
+            }
+            // Outside the lock: this may release the lowercase entry in turn
+            delete e;
+        }
+    };
+
+    static Ref lookup(Shard& shard, string_view s) {
+        auto it = shard.entries.find(s);
+        return it == shard.entries.end() ? nullptr : it->second.lock();
+    }
+
+public:
+    SharedStringTable() = default;
+    SharedStringTable(const SharedStringTable&) = delete;
+    SharedStringTable& operator=(const SharedStringTable&) = delete;
+
+    // Never destroyed, so Books in static storage can outlive it safely.
+    static SharedStringTable& authors() {
+        static SharedStringTable* table = new SharedStringTable();
+        return *table;
+    }
+
+    // Null for the empty string.
+    Ref intern(string_view s) {
+        if (s.empty()) return nullptr;
+        Shard& shard = shardFor(s);
+        {
+            lock_guard<mutex> guard(shard.lock);
+            if (Ref found = lookup(shard, s)) return found;
+        }
+
+        // The lowercase form goes in first (possibly in another shard), with no lock held
+        string lowerText = TextUtils::toLower(s);
+        Ref lower = lowerText == s ? nullptr : intern(lowerText);
+
+        lock_guard<mutex> guard(shard.lock);
+        if (Ref found = lookup(shard, s)) return found;  // another thread won the race
+        Ref entry(new Entry{string(s), move(lower)}, Release{this});
+        // A dead entry's key views text about to be freed, so it is replaced, not assigned to
+        shard.entries.erase(s);
+        shard.entries.emplace(string_view(entry->text), entry);
+        return entry;
+    }
+
+    // Live entries, lowercase forms included.
+    size_t size() const {
+        size_t total = 0;
+        for (auto& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+};
@@ -0,0 +1,183 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <optional>
+#include "RankedCounter.h"
+using namespace std;
+
+// Fixed-size probabilistic summaries of event streams. Keys are 64-bit
+// integers; each sketch hashes them with its own seeds.
+
+inline uint64_t mixHash(uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Count-Min sketch: depth rows of width counters. An estimate is the smallest
+// of the key's counters, so it never undercounts and overcounts by at most
+// e/width of the total with probability 1 - e^-depth.
+class CountMinSketch {
+private:
+    int width;
+    int depth;
+    vector<uint32_t> cells;
+    uint64_t total;
+
+    size_t cell(int row, uint64_t key) const {
+        return (size_t)row * width + mixHash(key ^ (0x51ED27A3ULL * (row + 1))) % width;
+    }
+
+public:
+    CountMinSketch(int w = 2048, int d = 4) : width(w), depth(d), cells((size_t)w * d, 0), total(0) {}
+
+    void add(uint64_t key, uint32_t count = 1) {
+        for (int row = 0; row < depth; row++) {
+            cells[cell(row, key)] += count;
+        }
+        total += count;
+    }
+
+    uint32_t estimate(uint64_t key) const {
+        uint32_t best = UINT32_MAX;
+        for (int row = 0; row < depth; row++) {
+            best = min(best, cells[cell(row, key)]);
+        }
+        return best;
+    }
+
+    uint64_t getTotal() const { return total; }
+    const vector<uint32_t>& getCells() const { return cells; }
+
+    bool restore(const vector<uint32_t>& saved, uint64_t savedTotal) {
+        if (saved.size() != cells.size()) return false;
+        cells = saved;
+        total = savedTotal;
+        return true;
+    }
+
+    void clear() {
+        fill(cells.begin(), cells.end(), 0);
+        total = 0;
+    }
+};
+
+// HyperLogLog distinct counter with 2^precision one-byte registers; the
+// standard error is about 1.04 / sqrt(2^precision).
+class HyperLogLog {
+private:
+    int precision;
+    vector<uint8_t> registers;
+
+public:
+    HyperLogLog(int p = 10) : precision(p), registers((size_t)1 << p, 0) {}
+
+    void add(uint64_t key) {
+        uint64_t h = mixHash(key);
+        size_t index = h >> (64 - precision);
+        uint64_t rest = (h << precision) | ((uint64_t)1 << (precision - 1));
+        uint8_t rank = (uint8_t)(__builtin_clzll(rest) + 1);
+        registers[index] = max(registers[index], rank);
+    }
+
+    double estimate() const {
+        double m = (double)registers.size();
+        double sum = 0;
+        int zeros = 0;
+        for (uint8_t r : registers) {
+            sum += ldexp(1.0, -r);
+            if (r == 0) zeros++;
+        }
+
+        double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+        double raw = alpha * m * m / sum;
+        // Small cardinalities: linear counting over empty registers is more accurate
+        if (raw <= 2.5 * m && zeros > 0) {
+            return m * log(m / zeros);
+        }
+        return raw;
+    }
+
+    const vector<uint8_t>& getRegisters() const { return registers; }
+
+    bool restore(const vector<uint8_t>& saved) {
+        if (saved.size() != registers.size()) return false;
+        registers = saved;
+        return true;
+    }
+};
+
+template <typename K>
+struct HeavyHitter {
+    K key;
+    int count;   // upper bound on the true count
+    int error;   // count - error is a lower bound
+};
+
+// Space-Saving heavy hitters over a fixed number of counters. A new key
+// evicts the current minimum and inherits its count as error, so every key
+// occurring more than total/capacity times is guaranteed to be tracked.
+template <typename K>
+class SpaceSaving {
+private:
+    int capacity;
+    RankedCounter<K> counts;
+    unordered_map<K, int> errors;
+
+public:
+    SpaceSaving(int cap = 64) : capacity(cap) {}
+
+    // Returns the key evicted to make room for `key`, if any.
+    optional<K> offer(const K& key, int weight = 1) {
+        if (counts.contains(key) || counts.size() < capacity) {
+            counts.add(key, weight);
+            return nullopt;
+        }
+
+        pair<K, int> evicted = counts.lowest();
+        counts.erase(evicted.first);
+        errors.erase(evicted.first);
+        counts.set(key, evicted.second + weight);
+        errors[key] = evicted.second;
+        return evicted.first;
+    }
+
+    bool contains(const K& key) const { return counts.contains(key); }
+
+    vector<HeavyHitter<K>> top(int n) const {
+        vector<HeavyHitter<K>> result;
+        for (const auto& entry : counts.top(n)) {
+            auto error = errors.find(entry.first);
+            result.push_back({entry.first, entry.second, error == errors.end() ? 0 : error->second});
+        }
+        return result;
+    }
+
+    int getCapacity() const { return capacity; }
+
+    // Frees key's counter; the next new key takes the slot with no error.
+    void erase(const K& key) {
+        counts.erase(key);
+        errors.erase(key);
+    }
+
+    void restore(const vector<HeavyHitter<K>>& saved) {
+        clear();
+        vector<pair<K, int>> entries;
+        for (const auto& hitter : saved) {
+            if ((int)entries.size() == capacity) break;
+            entries.push_back({hitter.key, hitter.count});
+            if (hitter.error > 0) errors[hitter.key] = hitter.error;
+        }
+        counts.assign(entries);
+    }
+
+    void clear() {
+        counts.clear();
+        errors.clear();
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include "../utils/TextUtils.h"
+
+using namespace std;
+
+// Append-only intern table for short, highly repeated strings (categories,
+// types, roles). Each distinct string is stored once and named by a small
+// integer id; equal strings always get the same id, so equality is an integer
+// compare. Every id also records the id of its lowercase form, which makes
+// case-insensitive equality an integer compare as well.
+//
+// Entries are never freed and the table holds at most MAX_CHUNKS * CHUNK_SIZE
+// of them, so only fields with few distinct values belong here; titles are
+// owned by each Book and authors go in a table that frees them (see BookText
+// and SharedStringTable).
+//
+// Entries live in fixed-size chunks that never move, so str() needs no lock:
+// an id can only be observed after the entry it names was fully written.
+// Lookups are split over independently locked shards so that threads
+// interning different strings (parallel catalog loads) rarely contend.
+class StringPool {
+public:
+    using Id = uint32_t;
+    static const Id EMPTY = 0;
+
+private:
+    struct Entry {
+        string text;
+        Id folded;
+    };
+
+    static const int CHUNK_BITS = 12;
+    static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static const uint32_t MAX_CHUNKS = 4096;
+    static const size_t SHARDS = 16;
+
+    struct Shard {
+        unordered_map<string_view, Id> ids;
+        mutex lock;
+    };
+
+    unique_ptr<Entry[]> chunks[MAX_CHUNKS];
+    mutable Shard shards[SHARDS];
+    atomic<uint32_t> count;
+    mutex appendLock;  // taken after a shard lock, never before
+
+    Entry& entry(Id id) const {
+        return chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+    }
+
+    Shard& shardFor(string_view s) const {
+        return shards[hash<string_view>()(s) % SHARDS];
+    }
+
+    // `folded` is the id of s's lowercase form, or -1 when s is already lowercase.
+    // The caller publishes the id in s's shard.
+    Id append(string_view s, int64_t folded) {
+        lock_guard<mutex> guard(appendLock);
+        uint32_t id = count.load(memory_order_relaxed);
+        uint32_t chunk = id >> CHUNK_BITS;
+        if (chunk >= MAX_CHUNKS) {
+            throw length_error("StringPool is full");
+        }
+        if (!chunks[chunk]) {
+            chunks[chunk].reset(new Entry[CHUNK_SIZE]);
+        }
+
+        Entry& e = chunks[chunk][id & (CHUNK_SIZE - 1)];
+        e.text = string(s);
+        e.folded = folded < 0 ? id : (Id)folded;
+        count.store(id + 1, memory_order_release);
+        return id;
+    }
+
+public:
+    StringPool() : count(0) {
+        Id empty = append("", -1);
+        shardFor("").ids.emplace(string_view(str(empty)), empty);
+    }
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    static StringPool& shared() {
+        static StringPool pool;
+        return pool;
+    }
+
+    Id intern(string_view s) {
+        if (s.empty()) return EMPTY;
+        Shard& shard = shardFor(s);
+        {
+            lock_guard<mutex> guard(shard.lock);
+            auto it = shard.ids.find(s);
+            if (it != shard.ids.end()) return it->second;
+        }
+
+        // The lowercase form goes in first (possibly in another shard), with no lock held
+        string lower = TextUtils::toLower(s);
+        int64_t folded = lower == s ? -1 : (int64_t)intern(lower);
+
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.ids.find(s);
+        if (it != shard.ids.end()) return it->second;  // another thread won the race
+        Id id = append(s, folded);
+        shard.ids.emplace(string_view(str(id)), id);
+        return id;
+    }
+
+    // Id of s if it has been interned, without adding it.
+    bool find(string_view s, Id& out) const {
+        Shard& shard = shardFor(s);
+        lock_guard<mutex> guard(shard.lock);
+        auto it = shard.ids.find(s);
+        if (it == shard.ids.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    const string& str(Id id) const {
+        return entry(id).text;
+    }
+
+    // Id of the lowercase form of id's string.
+    Id folded(Id id) const {
+        return entry(id).folded;
+    }
+
+    size_t size() const {
+        return count.load(memory_order_acquire);
+    }
+};
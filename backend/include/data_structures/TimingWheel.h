@@ -0,0 +1,123 @@
+#pragma once
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+using namespace std;
+
+// Hierarchical timing wheel over integer ticks: LEVELS wheels of 64 slots,
+// level l covering 64^l ticks per slot. A timer is filed at the highest
+// 6-bit digit where its expiry differs from the current tick, so it only
+// cascades to a finer wheel when the clock reaches that digit. Scheduling
+// and cancelling are O(1) and each tick does O(1) work plus the timers it
+// cascades or fires.
+class TimingWheel {
+private:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 6;
+
+    struct Timer {
+        uint64_t id;
+        uint64_t expiry;
+    };
+    struct Handle {
+        list<Timer>* slot;
+        list<Timer>::iterator position;
+    };
+
+    vector<list<Timer>> slots;
+    list<Timer> expired;  // scheduled at or before the current tick
+    unordered_map<uint64_t, Handle> timers;
+    uint64_t current;
+
+    list<Timer>& slotFor(uint64_t expiry) {
+        if (expiry <= current) return expired;
+
+        uint64_t diff = expiry ^ current;
+        int level = 0;
+        while (level < LEVELS - 1 && (diff >> (SLOT_BITS * (level + 1))) != 0) level++;
+
+        uint64_t digit = expiry >> (SLOT_BITS * level);
+        if ((diff >> (SLOT_BITS * LEVELS)) != 0) {
+            // Beyond the top wheel: park in the top slot visited last
+            digit = (current >> (SLOT_BITS * level)) - 1;
+        }
+        return slots[level * SLOTS + (digit & (SLOTS - 1))];
+    }
+
+    void file(const Timer& timer) {
+        list<Timer>& slot = slotFor(timer.expiry);
+        slot.push_back(timer);
+        timers[timer.id] = {&slot, prev(slot.end())};
+    }
+
+    void fireAll(list<Timer>& slot, const function<void(uint64_t, uint64_t)>& fire) {
+        list<Timer> due;
+        due.swap(slot);
+        for (const Timer& timer : due) {
+            timers.erase(timer.id);
+            fire(timer.id, timer.expiry);
+        }
+    }
+
+public:
+    TimingWheel(uint64_t startTick = 0) : slots(LEVELS * SLOTS), current(startTick) {}
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // Schedules (or reschedules) timer id to fire at expiryTick.
+    void schedule(uint64_t id, uint64_t expiryTick) {
+        cancel(id);
+        file({id, expiryTick});
+    }
+
+    bool cancel(uint64_t id) {
+        auto it = timers.find(id);
+        if (it == timers.end()) return false;
+        it->second.slot->erase(it->second.position);
+        timers.erase(it);
+        return true;
+    }
+
+    // Moves the clock to targetTick, calling fire(id, expiry) for every timer
+    // that comes due on the way, in tick order.
+    void advance(uint64_t targetTick, const function<void(uint64_t, uint64_t)>& fire) {
+        fireAll(expired, fire);
+
+        while (current < targetTick) {
+            if (timers.empty()) {
+                current = targetTick;
+                break;
+            }
+            current++;
+
+            // Coarsest first, so timers cascading from level l can cascade again at l-1
+            for (int level = LEVELS - 1; level > 0; level--) {
+                uint64_t lowBits = current & ((1ULL << (SLOT_BITS * level)) - 1);
+                if (lowBits != 0) continue;
+
+                list<Timer> cascading;
+                cascading.swap(slots[level * SLOTS + ((current >> (SLOT_BITS * level)) & (SLOTS - 1))]);
+                for (const Timer& timer : cascading) {
+                    file(timer);
+                }
+            }
+
+            fireAll(slots[current & (SLOTS - 1)], fire);
+            fireAll(expired, fire);
+        }
+    }
+
+    uint64_t now() const { return current; }
+    size_t size() const { return timers.size(); }
+
+    void reset(uint64_t startTick) {
+        for (auto& slot : slots) slot.clear();
+        expired.clear();
+        timers.clear();
+        current = startTick;
+    }
+};
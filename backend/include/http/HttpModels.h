@@ -2,6 +2,7 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <functional>
 using namespace std;
 
 enum class HttpMethod {
@@ -22,6 +23,8 @@ enum class HttpStatus {
     FORBIDDEN = 403,
     NOT_FOUND = 404,
     CONFLICT = 409,
+    LENGTH_REQUIRED = 411,
+    PAYLOAD_TOO_LARGE = 413,
     INTERNAL_SERVER_ERROR = 500
 };
 
@@ -34,6 +37,11 @@ private:
     map<string, string> pathParams;
     string body;
 
+    // Set for streaming routes: pulls the body from the connection on demand
+    // instead of it being held in `body`. Returns 0 at the end of the body.
+    function<size_t(char*, size_t)> bodyReader;
+    mutable size_t bodyConsumed;
+
 public:
     HttpRequest();
     HttpRequest(HttpMethod m, const string& p);
@@ -51,9 +59,16 @@ public:
     void setQueryParam(const string& key, const string& value);
     void setPathParam(const string& key, const string& value);
     void setBody(const string& b);
+    void setBodyReader(function<size_t(char*, size_t)> reader);
+
+    // Reads the next part of the body, streamed or buffered; 0 at the end.
+    size_t readBody(char* buffer, size_t size) const;
 
     bool hasQueryParam(const string& key) const;
     bool hasPathParam(const string& key) const;
+    // Reads an optional count such as ?limit=N: missing means `fallback`,
+    // anything but a positive integer fails, and values above `max` are clamped.
+    bool getLimitParam(const string& key, int fallback, int max, int& out) const;
     map<string, string> getAllQueryParams() const;
 };
 
@@ -83,6 +98,8 @@ public:
     static HttpResponse created(const string& body = "");
     static HttpResponse badRequest(const string& message);
     static HttpResponse notFound(const string& message);
+    static HttpResponse lengthRequired(const string& message);
+    static HttpResponse payloadTooLarge(const string& message);
     static HttpResponse serverError(const string& message);
 
     string toString() const;
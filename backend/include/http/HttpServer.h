@@ -2,6 +2,7 @@
 #include <string>
 #include <thread>
 #include <atomic>
+#include <functional>
 #include "HttpModels.h"
 #include "../api/Router.h"
 
@@ -12,13 +13,32 @@ public:
 
     void start();
 
+    // Runs on the server thread after each batch of requests and about once a
+    // second while idle, e.g. for periodic snapshots
+    void setAfterRequestHook(std::function<void()> hook);
+
+    // Runs after a batch of requests has been handled and before any of their
+    // responses is sent, e.g. to make their changes durable with one fsync.
+    // If it returns false, every response in the batch becomes a 500.
+    void setBeforeRespondHook(std::function<bool()> hook);
+
 private:
+    static const int IDLE_HOOK_MS = 1000;
+    // Connections already waiting when the server looks are handled as one
+    // batch, up to this many
+    static const int MAX_BATCH = 64;
+    // Largest body read into memory; streaming routes read theirs piecewise
+    static const size_t MAX_BODY_BYTES = 16 * 1024 * 1024;
+
     Router& router;
     int port;
+    std::function<void()> afterRequest;
+    std::function<bool()> beforeRespond;
 
     // Helpers
     int createListenSocket();
-    void handleClient(int clientSock);
+    bool handleClient(int clientSock, HttpResponse& res);
+    void sendResponse(int clientSock, HttpResponse& res);
     bool parseRequest(const std::string& raw, HttpRequest& outReq);
     static HttpMethod parseMethod(const std::string& m);
     static std::string urlDecode(const std::string& s);
@@ -2,37 +2,71 @@
 #include <iostream>
 #include <algorithm>
 #include <vector>
+#include <memory>
+#include "../data_structures/StringPool.h"
+#include "../data_structures/SharedStringTable.h"
 using namespace std;
 
+// Fields only needed when a single book is shown in full. They are kept out
+// of line and shared between copies of a Book.
+struct BookDetails {
+    string isbn;
+    string coverImage;
+    vector<string> downloadLinks;
+};
+
+// Title with its lowercase sort/search key, and the author. Titles are mostly
+// unique per book, so they are owned here (and freed with the last copy);
+// authors repeat across books and are interned in a table that frees them
+// with their last book. titleKey is empty when the title is already lowercase.
+struct BookText {
+    string title;
+    string titleKey;
+    SharedStringTable::Ref author;
+};
+
+// Hot fields are ints, interned ids for the few distinct categories and
+// types, and a shared BookText, so copying a Book into search results or
+// index structures touches one small record plus refcounts.
 class Book {
 private:
     int bookID;
-    string title;
-    string author;
-    string isbn;
-    string category;
     int copies;
     int availableCopies;
-    string coverImage;
-    string type;
-    vector<string> downloadLinks;
+    StringPool::Id category;
+    StringPool::Id type;
+    shared_ptr<const BookText> text;
+    shared_ptr<const BookDetails> details;
+
+    const BookText& getText() const;
+    const BookDetails& getDetails() const;
 
 public:
     Book();
-    Book(int id, string t, string a, string i, string c, int cp, int av, string cover = "", string tp = "", vector<string> dl = {});
+    Book(int id, string_view t, string_view a, string i, string_view c, int cp, int av, string cover = "", string_view tp = "", vector<string> dl = {});
 
     void printBook() const;
 
-    string getISBN() const;
+    const string& getISBN() const;
     int getBookID() const;
-    string getTitle() const;
-    string getAuthor() const;
-    string getCategory() const;
+    const string& getTitle() const;
+    const string& getAuthor() const;
+    const string& getCategory() const;
     int getCopies() const;
     int getAvailableCopies() const;
-    string getCoverImage() const;
-    string getType() const;
-    vector<string> getDownloadLinks() const;
+    const string& getCoverImage() const;
+    const string& getType() const;
+    const vector<string>& getDownloadLinks() const;
+
+    // Interned ids (see StringPool); equal strings have equal ids.
+    StringPool::Id getCategoryId() const;
+    StringPool::Id getTypeId() const;
+    // Same for the author (see SharedStringTable); null when there is none.
+    SharedStringTable::Id getAuthorId() const;
+
+    // Lowercase title/author used for sorting and substring search.
+    const string& getTitleKey() const;
+    const string& getAuthorKey() const;
 
     void setAvailableCopies(int count);
     bool borrowBook();
@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include "../data_structures/StringPool.h"
 using namespace std;
 
 class User {
@@ -8,22 +9,23 @@ private:
     int userID;
     string name;
     string email;
-    string role;
+    StringPool::Id role;
     int borrowedBooks;
-    vector<int> borrowedBookIDs;
+    vector<int> borrowedBookIDs;  // sorted, so membership is a binary search
 
 public:
     User();
-    User(int id, string n, string e, string r);
+    User(int id, string n, string e, string_view r);
 
     void printUser() const;
 
     int getUserID() const;
     string getName() const;
     string getEmail() const;
-    string getRole() const;
+    const string& getRole() const;
+    StringPool::Id getRoleId() const;
     int getBorrowedBooksCount() const;
-    vector<int> getBorrowedBookIDs() const;
+    const vector<int>& getBorrowedBookIDs() const;
 
     bool borrowBook(int bookID);
     bool returnBook(int bookID);
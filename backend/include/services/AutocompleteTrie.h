@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+struct Completion {
+    string text;
+    long weight;
+};
+
+// Compressed (radix) trie over lowercase keys for type-ahead. Each key keeps
+// the display text it was first added with, a reference count (several books
+// can share a title or author) and a popularity weight. Every node caches
+// the largest weight in its subtree, so a top-N query is a best-first walk
+// that only expands the branches able to produce the next-best completion.
+class AutocompleteTrie {
+private:
+    struct Node {
+        string label;
+        vector<unique_ptr<Node>> children;  // sorted by first label byte
+        bool terminal = false;
+        string display;
+        int refs = 0;
+        long weight = 0;
+        long best = -1;
+    };
+
+    unique_ptr<Node> root;
+    int keyCount;
+
+    // Nodes from the root to the node for key, created on demand.
+    vector<Node*> pathTo(const string& key, bool create);
+    static void refreshBest(Node* node);
+    static void mergeWithOnlyChild(Node* node);
+
+public:
+    AutocompleteTrie();
+
+    void add(string_view text, long weight);
+    void remove(string_view text, long weight);
+    void addWeight(string_view text, long delta);
+    void clear();
+
+    int size() const;
+
+    // Up to limit completions of prefix (case-insensitive), heaviest first.
+    vector<Completion> complete(string_view prefix, int limit) const;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// Conjunction of book predicates; empty strings and a negative ID mean "any".
+// Title and author are case-insensitive substrings, category is a
+// case-insensitive exact match.
+struct BookQuery {
+    int bookID = -1;
+    string title;
+    string author;
+    string category;
+    bool availableOnly = false;
+
+    bool hasFilter() const {
+        return bookID >= 0 || !title.empty() || !author.empty() || !category.empty() || availableOnly;
+    }
+};
+
+enum class BookAccessPath {
+    ById,
+    Category,
+    TitleTrigrams,
+    AuthorTrigrams,
+    FullScan
+};
+
+// The access path chosen for a query and the number of candidates it is
+// expected to produce before the remaining predicates are checked.
+struct BookQueryPlan {
+    BookAccessPath path;
+    size_t estimatedCandidates;
+};
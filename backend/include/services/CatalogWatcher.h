@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "Library.h"
+
+using namespace std;
+
+struct CatalogReloadStats {
+    int added = 0;
+    int changed = 0;
+    int removed = 0;
+    int deferred = 0;  // removals waiting for loans to be returned
+};
+
+// Hot reload of the JSON catalog. A background thread watches the file with
+// inotify and, after each rewrite, parses it and diffs it by book ID against
+// the version seen before (a fingerprint per book), so unchanged books cost
+// one hash compare. The first version seen is the library itself, so edits
+// made while the server was down are picked up by the parse at startup. Only the changes are queued; applyPending() hands them
+// to the library's index APIs on the thread that owns the library, so a
+// refresh costs the parse off-thread plus work proportional to the change.
+// Users and loans are never touched by a reload. The file is read into
+// memory, not mapped, since whoever rewrites it may truncate it mid-parse.
+class CatalogWatcher {
+private:
+    Library& library;
+    string path;
+    int threads;
+
+    unordered_map<int, uint64_t> fingerprints;  // book ID -> fields, as of the last parse
+    // False until a parse has replaced the library-derived fingerprints.
+    // Until then books missing from the file are kept: they cannot be told
+    // apart from books added at runtime.
+    bool baselined;
+    mutex pendingLock;
+    unordered_map<int, optional<Book>> pending;  // book ID -> new version, or nullopt to remove
+    atomic<bool> hasPending;
+
+    int notifyFd;
+    atomic<bool> stopping;
+    thread watcher;
+
+    void watchLoop();
+    bool reload();
+
+public:
+    static const int SETTLE_MS = 200;  // quiet period before a changed file is read
+
+    CatalogWatcher(Library& lib, const string& catalogPath, int ingestThreads = 0);
+    ~CatalogWatcher();
+
+    CatalogWatcher(const CatalogWatcher&) = delete;
+    CatalogWatcher& operator=(const CatalogWatcher&) = delete;
+
+    // Takes the library's books as the baseline and starts watching. The file
+    // is first parsed on the watcher thread, and its differences from the
+    // library are queued like any reload.
+    bool start();
+    void stop();
+
+    // Applies the changes queued since the last call. Call it from the thread
+    // that owns the library, e.g. between requests. The changes are not
+    // written to the library's WAL; take a snapshot to make them durable.
+    CatalogReloadStats applyPending();
+
+    static uint64_t fingerprint(const Book& b);
+};
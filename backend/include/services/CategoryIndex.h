@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include "../data_structures/StringPool.h"
+
+using namespace std;
+
+struct CategoryStats {
+    StringPool::Id category;
+    int totalBooks;
+    int availableBooks;
+    int borrowedBooks;
+};
+
+// Inverted index from interned category to the IDs of its books, with
+// per-category availability counters kept current by the Library. A book is
+// "available" while it has at least one copy on the shelf.
+class CategoryIndex {
+private:
+    struct Entry {
+        vector<int> bookIDs;
+        int available = 0;
+        int borrowed = 0;
+    };
+
+    unordered_map<StringPool::Id, Entry> byCategory;
+    vector<StringPool::Id> byName;  // categories sorted by name, for stats()
+    CategoryStats overall;
+    // Lowercase category id -> spellings seen, for case-insensitive lookup
+    unordered_map<StringPool::Id, vector<StringPool::Id>> byFolded;
+
+public:
+    CategoryIndex();
+
+    void add(int bookID, StringPool::Id category, bool available);
+    void remove(int bookID, StringPool::Id category, bool available);
+    void setAvailable(StringPool::Id category, bool wasAvailable, bool isAvailable);
+    void clear();
+
+    // Book IDs whose category equals foldedCategory ignoring case.
+    vector<int> find(StringPool::Id foldedCategory) const;
+    size_t count(StringPool::Id foldedCategory) const;
+
+    // One entry per category, ordered by category name.
+    vector<CategoryStats> stats() const;
+    // Sums over all categories; category is StringPool::EMPTY.
+    const CategoryStats& totals() const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <ctime>
+#include <unordered_map>
+#include "../data_structures/RollingCounter.h"
+#include "../data_structures/StringPool.h"
+
+using namespace std;
+
+enum class CirculationEvent {
+    Borrow,
+    Return,
+    Registration
+};
+
+enum class MetricsResolution {
+    Minute,
+    Hour,
+    Day
+};
+
+// Rolling per-minute (last hour), per-hour (last two days) and per-day (last
+// 90 days) counters of circulation events, library-wide and, for borrows and
+// returns, per case-folded category. Recording an event touches a fixed
+// number of counters.
+class CirculationMetrics {
+private:
+    struct Series {
+        RollingCounter minutes{windowSeconds(MetricsResolution::Minute), maxWindows(MetricsResolution::Minute)};
+        RollingCounter hours{windowSeconds(MetricsResolution::Hour), maxWindows(MetricsResolution::Hour)};
+        RollingCounter days{windowSeconds(MetricsResolution::Day), maxWindows(MetricsResolution::Day)};
+
+        void add(time_t now);
+        const RollingCounter& at(MetricsResolution resolution) const;
+        void clear();
+    };
+
+    Series global[3];
+    unordered_map<StringPool::Id, Series> borrowsByCategory;
+    unordered_map<StringPool::Id, Series> returnsByCategory;
+
+public:
+    void record(CirculationEvent event, StringPool::Id category, time_t now);
+    void clear();
+
+    // Counts for the last `windows` windows up to `now`, newest first. A
+    // non-empty foldedCategory restricts borrows and returns to that category.
+    vector<uint32_t> recent(CirculationEvent event, MetricsResolution resolution, int windows, time_t now,
+                            StringPool::Id foldedCategory = StringPool::EMPTY) const;
+
+    static int windowSeconds(MetricsResolution resolution);
+    static int maxWindows(MetricsResolution resolution);
+};
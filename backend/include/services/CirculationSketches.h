@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include "../data_structures/Sketches.h"
+#include "../data_structures/StringPool.h"
+
+using namespace std;
+
+// Approximate circulation analytics fed by every borrow. Memory does not
+// grow with the number of borrows or books: a Count-Min sketch for per-book
+// frequency, Space-Saving for the most borrowed books, a small HyperLogLog of
+// borrowers for each book Space-Saving tracks, and one per (case-folded)
+// category, so it grows only with the number of categories.
+class CirculationSketches {
+private:
+    friend class LibrarySnapshot;
+
+    static constexpr int BOOK_PRECISION = 8;
+    static constexpr int CATEGORY_PRECISION = 11;
+
+    CountMinSketch borrowFrequency;
+    SpaceSaving<int> popularBooks;
+    // Only for books in popularBooks, and dropped when they are evicted, so a
+    // book's count starts at its most recent admission
+    unordered_map<int, HyperLogLog> borrowersByBook;
+    unordered_map<StringPool::Id, HyperLogLog> borrowersByCategory;
+
+public:
+    CirculationSketches();
+
+    void recordBorrow(int bookID, int userID, StringPool::Id category);
+    void clear();
+
+    uint64_t totalBorrows() const;
+    uint32_t estimateBorrows(int bookID) const;
+    // 0 for books outside the most borrowed (see mostBorrowed)
+    double estimateBorrowers(int bookID) const;
+    double estimateCategoryBorrowers(StringPool::Id foldedCategory) const;
+    vector<HeavyHitter<int>> mostBorrowed(int limit) const;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include "../data_structures/Sketches.h"
+
+using namespace std;
+
+// Sparse book-to-book co-borrowing counts for "readers who borrowed this
+// also borrowed". A borrow pairs the book with each of the reader's other
+// current loans. Every book keeps at most NEIGHBORS partners in a
+// Space-Saving summary, which stays sorted by count, so recommendations are
+// read straight off its top.
+class CoBorrowIndex {
+private:
+    friend class LibrarySnapshot;
+
+    static constexpr int NEIGHBORS = 32;
+
+    unordered_map<int, SpaceSaving<int>> neighbors;
+
+    SpaceSaving<int>& neighborsOf(int bookID);
+
+public:
+    // O(otherLoans): bookID was just borrowed by a reader also holding otherLoans.
+    void recordBorrow(int bookID, const vector<int>& otherLoans);
+    // Drops bookID's summary and its entry in each partner's summary. A
+    // partner the book's own summary has evicted may still list it.
+    void removeBook(int bookID);
+    void clear();
+
+    // Most frequently co-borrowed books, strongest first (count is an upper bound).
+    vector<HeavyHitter<int>> recommend(int bookID, int limit) const;
+    static int maxRecommendations();
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+using namespace std;
+
+struct ScoredBook {
+    int bookID;
+    double score;
+};
+
+// Token-level inverted index ranked with Okapi BM25. Each book is one
+// document made of its title, author and category tokens.
+//
+// Documents get increasing internal numbers, so posting lists stay sorted by
+// appending. Replacing or removing a book tombstones its old document; the
+// postings are compacted once tombstones outnumber live documents.
+//
+// Top-k queries use WAND: every term carries an upper bound on its score
+// contribution, and documents whose bound sum cannot beat the current k-th
+// best score are skipped without being scored.
+class FullTextIndex {
+private:
+    struct Posting {
+        uint32_t doc;
+        uint32_t tf;
+    };
+
+    struct Term {
+        vector<Posting> postings;
+        int liveDocs = 0;
+        uint32_t maxTf = 0;
+    };
+
+    struct Document {
+        int bookID;
+        uint32_t length;
+        bool alive;
+    };
+
+    unordered_map<string, uint32_t> termIds;
+    vector<Term> terms;
+    vector<Document> docs;
+    unordered_map<int, uint32_t> docOfBook;
+    int liveDocs;
+    uint64_t liveLength;
+
+    static const double K1;
+    static const double B;
+
+    double idf(const Term& term) const;
+    double upperBound(const Term& term) const;
+    void compact();
+
+public:
+    FullTextIndex();
+
+    static vector<string> tokenize(string_view text);
+
+    void add(int bookID, string_view text);
+    void remove(int bookID, string_view text);
+    void clear();
+
+    int size() const;
+
+    // Best k books for a free-text query (terms are OR'ed), highest score first.
+    vector<ScoredBook> search(const string& query, int k) const;
+};
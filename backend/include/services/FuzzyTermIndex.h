@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "../data_structures/PostingBatch.h"
+
+using namespace std;
+
+struct FuzzyMatch {
+    int bookID;
+    int distance;
+};
+
+// Typo-tolerant word lookup. Distinct lowercase words are kept in a BK-tree
+// keyed by Levenshtein distance, which lets a query visit only the subtrees
+// whose distance band can contain a match, and each word maps to the sorted
+// IDs of the books containing it. Words are never removed from the tree; a
+// word with no remaining books is simply skipped.
+class FuzzyTermIndex {
+private:
+    struct TreeNode {
+        string term;
+        vector<pair<int, int>> children;  // (distance to this term, node index)
+    };
+
+    vector<TreeNode> tree;
+    unordered_map<string, vector<int>> postings;
+    PostingBatch batch;
+
+    void insertTerm(const string& term);
+    void termsWithin(const string& word, int maxDistance, vector<pair<const string*, int>>& out) const;
+
+public:
+    static int levenshtein(string_view a, string_view b);
+
+    // Largest distance allowed for a query word of this length, capped by maxDistance.
+    static int allowedDistance(size_t wordLength, int maxDistance);
+
+    void add(int bookID, string_view text);
+    void remove(int bookID, string_view text);
+    void clear();
+
+    // As in TrigramIndex: postings added in between are merged at endBatch().
+    void beginBatch();
+    void endBatch();
+
+    // Books in which every query word matches some word within its allowed
+    // distance, ordered by total distance and then book ID.
+    vector<FuzzyMatch> search(string_view query, int maxDistance) const;
+};
@@ -1,34 +1,132 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <functional>
 #include <algorithm>
+#include <unordered_map>
 #include "../models/Book.h"
 #include "../models/User.h"
 #include "../data_structures/BTree.h"
 #include "../data_structures/HashTable.h"
+#include "../data_structures/RankedCounter.h"
+#include "CategoryIndex.h"
+#include "TrigramIndex.h"
+#include "FullTextIndex.h"
+#include "AutocompleteTrie.h"
+#include "FuzzyTermIndex.h"
+#include "BookQuery.h"
+#include "CirculationSketches.h"
+#include "CirculationMetrics.h"
+#include "LoanSchedule.h"
+#include "CoBorrowIndex.h"
 
 using namespace std;
 
+class WriteAheadLog;
+class LibrarySnapshot;
+class CatalogSegment;
+struct CatalogRecord;
+
+// Library-wide counters for the dashboard. Book counts follow the category
+// index ("borrowed" = no copy on the shelf); loans are per user and copy.
+struct LibraryTotals {
+    int totalBooks;
+    int availableBooks;
+    int borrowedBooks;
+    int totalUsers;
+    int outstandingLoans;
+};
+
 class Library {
 private:
+    friend class LibrarySnapshot;
+
+    // Books live in two layers: an optional read-only catalog segment (mmap'd)
+    // and a heap overlay holding added books plus edited copies of segment
+    // records. A heap entry shadows the segment record with the same ID.
+    vector<Book> books;
+    HashTable<int, int> bookSlots;
+    BTree<int>* booksByTitle;
 
-    BTree<Book>* booksByTitle;
+    CatalogSegment* catalog;
+    vector<bool> shadowedRecords;
+    int shadowedCount;
+    Book catalogScratch;
 
     HashTable<int, User> usersByID;
     HashTable<string, User> usersByEmail;
 
     HashTable<int, int> borrowCounts;
+    RankedCounter<int> borrowRanking;   // book ID -> times borrowed
+    RankedCounter<int> userActivity;    // user ID -> books currently borrowed
+    int outstandingLoans;
+    CirculationSketches circulation;
+    CirculationMetrics metrics;
+    LoanSchedule loans;
+    unordered_map<int, vector<int>> borrowersByBook;  // book ID -> sorted IDs of users holding a copy
+    CoBorrowIndex coBorrows;
+
+    CategoryIndex categories;  // always current; the totals come from it
+    TrigramIndex titleTrigrams;
+    TrigramIndex authorTrigrams;
+    FullTextIndex fullText;
+    AutocompleteTrie titleSuggestions;
+    AutocompleteTrie authorSuggestions;
+    FuzzyTermIndex titleWords;
+
+    bool indexesBuilt;  // text indexes: false until first needed after attachCatalog() or a snapshot load
+    WriteAheadLog* wal;
+
+    static const size_t REBUILD_RATIO = 4;  // addBooks rebuilds for batches over 1/4 of the library
+
+    int storeBook(const Book& b);
+    int writableSlot(int bookID);
+    void markShadowed(int bookID);
+    void updateIndexes(const Book* before, const Book& after);
+    void updateTextIndexes(const Book* before, const Book& after);
+    void removeFromIndexes(const Book& b);
+    void rebuildCategories();
+    void reindexBooks();
+    void invalidateIndexes();
+    void ensureIndexes() const;
+    void beginIndexBatch();
+    void endIndexBatch();
+    void rebuildUserAggregates();
+    void addBorrower(int bookID, int userID);
+    void removeBorrower(int bookID, int userID);
+    static string searchableText(const Book& b);
+    int borrowCountOf(int bookID) const;
+    vector<Book> booksInTitleOrder(const vector<int>& bookIDs, const function<bool(const Book&)>& keep);
+
+    vector<Book> collectBooks(const function<bool(const Book&)>& matchHeap,
+                              const function<bool(const CatalogRecord&)>& matchRecord) const;
 
 public:
     Library();
     ~Library();
 
+    Library(const Library&) = delete;
+    Library& operator=(const Library&) = delete;
+
     void addBook(const Book& b);
+    void addBooks(vector<Book> batch);
+    // Adds or replaces a book without disturbing its loans: available copies
+    // are capped at the copies not currently on loan.
+    void replaceBook(const Book& b);
+    // Fails for books with copies on loan and for catalog segment records.
+    bool removeBook(int bookID);
     void printAllBooks();
 
     vector<Book> searchBookByTitle(const string& title);
+    vector<Book> searchBookByTitleFuzzy(const string& title, int maxDistance = 2);
     vector<Book> searchBookByAuthor(const string& author);
     vector<Book> searchBookByCategory(const string& category);
+    vector<Book> findBooks(const BookQuery& query);
+    BookQueryPlan planBookQuery(const BookQuery& query) const;
+    vector<ScoredBook> rankBooks(const string& query, int topK = 20) const;
+    vector<Completion> suggestTitles(const string& prefix, int limit = 10) const;
+    vector<Completion> suggestAuthors(const string& prefix, int limit = 10) const;
     Book* findBookByID(int bookID);
 
     void addUser(const User& u);
@@ -36,15 +134,38 @@ public:
     User* findUserByEmail(const string& email);
     void printAllUsers();
 
-    bool borrowBook(int userID, int bookID);
+    // dueAt of 0 means the default loan period from now
+    bool borrowBook(int userID, int bookID, time_t dueAt = 0);
     bool returnBook(int userID, int bookID);
 
-    vector<pair<int, int>> getMostBorrowedBooks(int topN = 5);
-    vector<pair<int, int>> getMostActiveUsers(int topN = 5);
+    vector<pair<int, int>> getMostBorrowedBooks(int topN = 5) const;
+    vector<pair<int, int>> getMostActiveUsers(int topN = 5) const;
+    vector<CategoryStats> getCategoryStats() const;
+    LibraryTotals getTotals() const;
+    const CirculationSketches& getCirculationSketches() const;
+    const CirculationMetrics& getCirculationMetrics() const;
+
+    // Moves loans due by `now` into the overdue set; returns how many moved.
+    int processDueLoans(time_t now);
+    vector<Loan> getOverdueLoans(int limit) const;
+    int getOverdueCount() const;
+    bool getLoanDueDate(int userID, int bookID, time_t& dueAt) const;
+    bool isLoanOverdue(int userID, int bookID) const;
+    const vector<int>& getBorrowers(int bookID) const;
+    vector<HeavyHitter<int>> recommendBooks(int bookID, int limit = 10) const;
+    void resetCirculationMetrics();
     void printStatistics();
 
     vector<Book> getAllBooks() const;
     vector<User> getAllUsers() const;
     int getTotalBooks() const;
     int getTotalUsers() const;
+
+    bool attachCatalog(const string& path);
+    bool hasCatalog() const;
+
+    // With a log attached, a mutation whose record cannot be logged throws
+    // runtime_error before changing anything.
+    void setWriteAheadLog(WriteAheadLog* log);
+    WriteAheadLog* getWriteAheadLog() const;
 };
@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <set>
+#include <ctime>
+#include <unordered_map>
+#include "../data_structures/TimingWheel.h"
+
+using namespace std;
+
+struct Loan {
+    int userID;
+    int bookID;
+    time_t dueAt;
+};
+
+// Due dates of open loans. Each loan arms a timer on a minute-granularity
+// timing wheel; advancing the clock fires the loans that came due and moves
+// them into the overdue set, so the overdue report never scans open loans.
+class LoanSchedule {
+private:
+    static constexpr int TICK_SECONDS = 60;
+
+    TimingWheel wheel;
+    unordered_map<uint64_t, time_t> dueDates;
+    set<pair<time_t, uint64_t>> overdue;  // (due, loan key), oldest first
+
+    static uint64_t keyOf(int userID, int bookID);
+    static Loan loanOf(uint64_t key, time_t dueAt);
+    // First tick at or after the due time
+    static uint64_t tickOf(time_t dueAt);
+
+public:
+    static constexpr time_t DEFAULT_LOAN_SECONDS = 14 * 24 * 3600;
+
+    LoanSchedule(time_t start = time(nullptr));
+
+    void open(int userID, int bookID, time_t dueAt);
+    void close(int userID, int bookID);
+    void clear(time_t start = time(nullptr));
+
+    // Fires every loan due by `now`; returns how many became overdue.
+    int advance(time_t now);
+
+    bool dueDate(int userID, int bookID, time_t& dueAt) const;
+    bool isOverdue(int userID, int bookID) const;
+    size_t openCount() const;
+    size_t overdueCount() const;
+
+    // Overdue loans, longest overdue first.
+    vector<Loan> overdueLoans(int limit) const;
+    vector<Loan> openLoans() const;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "../data_structures/PostingBatch.h"
+
+using namespace std;
+
+// Inverted index from 3-byte substrings of lowercase text to sorted book ID
+// posting lists. A query's candidates are the intersection of the postings
+// of its trigrams; callers still verify each candidate, since sharing all
+// trigrams does not guarantee the query occurs contiguously.
+class TrigramIndex {
+private:
+    unordered_map<uint32_t, vector<int>> postings;
+    PostingBatch batch;
+
+    static vector<uint32_t> trigramsOf(string_view text);
+
+public:
+    static const size_t GRAM = 3;
+
+    void add(int bookID, string_view foldedText);
+    void remove(int bookID, string_view foldedText);
+    void clear();
+
+    // Adds between the two are merged into the postings once, at endBatch();
+    // queries are only valid outside a batch.
+    void beginBatch();
+    void endBatch();
+
+    // Candidate IDs for a lowercase query of at least GRAM bytes, ascending.
+    vector<int> candidates(string_view foldedQuery) const;
+
+    // Upper bound on candidates(foldedQuery).size(): its shortest posting list.
+    size_t estimate(string_view foldedQuery) const;
+};
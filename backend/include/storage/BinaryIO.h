@@ -0,0 +1,130 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// Little-endian encoding helpers shared by the on-disk formats
+// (write-ahead log, snapshots, catalog segments).
+class BinaryIO {
+public:
+    static void putU32(string& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back((char)((v >> (8 * i)) & 0xFF));
+    }
+
+    static void putU64(string& out, uint64_t v) {
+        for (int i = 0; i < 8; i++) out.push_back((char)((v >> (8 * i)) & 0xFF));
+    }
+
+    static void putInt(string& out, int v) {
+        putU32(out, (uint32_t)v);
+    }
+
+    static void putString(string& out, const string& s) {
+        putU32(out, (uint32_t)s.size());
+        out.append(s);
+    }
+
+    static uint32_t readU32(const char* p) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) v |= (uint32_t)(uint8_t)p[i] << (8 * i);
+        return v;
+    }
+
+    static uint64_t readU64(const char* p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v |= (uint64_t)(uint8_t)p[i] << (8 * i);
+        return v;
+    }
+
+    static uint32_t crc32(const char* data, size_t len) {
+        struct Table {
+            uint32_t entries[256];
+            Table() {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = i;
+                    for (int k = 0; k < 8; k++) {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    entries[i] = c;
+                }
+            }
+        };
+        static const Table table;
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < len; i++) {
+            crc = table.entries[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    static bool readWholeFile(int fd, string& out) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) return false;
+        out.resize((size_t)st.st_size);
+        size_t done = 0;
+        while (done < out.size()) {
+            ssize_t n = pread(fd, &out[done], out.size() - done, (off_t)done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += (size_t)n;
+        }
+        return true;
+    }
+
+    static bool writeFully(int fd, const char* data, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::write(fd, data, len);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            data += n;
+            len -= (size_t)n;
+        }
+        return true;
+    }
+};
+
+// Bounds-checked cursor over an encoded buffer. Any overrun clears `ok`
+// and yields zero/empty values from then on.
+class BinaryReader {
+public:
+    const char* cur;
+    const char* end;
+    bool ok;
+
+    BinaryReader(const char* begin, const char* finish) : cur(begin), end(finish), ok(true) {}
+
+    bool has(size_t n) const {
+        return ok && (size_t)(end - cur) >= n;
+    }
+
+    uint32_t readU32() {
+        if (!has(4)) { ok = false; return 0; }
+        uint32_t v = BinaryIO::readU32(cur);
+        cur += 4;
+        return v;
+    }
+
+    uint64_t readU64() {
+        if (!has(8)) { ok = false; return 0; }
+        uint64_t v = BinaryIO::readU64(cur);
+        cur += 8;
+        return v;
+    }
+
+    int readInt() {
+        return (int)readU32();
+    }
+
+    string readString() {
+        uint32_t len = readU32();
+        if (!has(len)) { ok = false; return ""; }
+        string s(cur, len);
+        cur += len;
+        return s;
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "../models/Book.h"
+
+using namespace std;
+
+struct CatalogStringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Fixed-width book record; strings point into the segment's string pool.
+struct CatalogRecord {
+    int32_t bookID;
+    int32_t copies;
+    int32_t availableCopies;
+    uint32_t firstLink;
+    CatalogStringRef title;
+    CatalogStringRef author;
+    CatalogStringRef isbn;
+    CatalogStringRef category;
+    CatalogStringRef coverImage;
+    CatalogStringRef type;
+    uint32_t linkCount;
+    uint32_t reserved;
+};
+
+// Read-only, compiled book catalog that is mmap'd as a whole. Layout:
+//   header | records sorted by bookID | title index | download links | string pool
+// The title index lists record numbers ordered by case-folded title, then ID.
+// Records are stored in host byte order, so segments are not portable across
+// architectures; the version field guards layout changes.
+class CatalogSegment {
+private:
+    const char* base;
+    size_t mappedSize;
+
+    const CatalogRecord* records;
+    uint32_t recordCount;
+    const uint32_t* titleIndex;
+    const CatalogStringRef* links;
+    uint32_t linkCount;
+    const char* strings;
+    uint64_t stringsSize;
+
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+
+    CatalogSegment();
+    ~CatalogSegment();
+
+    CatalogSegment(const CatalogSegment&) = delete;
+    CatalogSegment& operator=(const CatalogSegment&) = delete;
+
+    static bool build(const vector<Book>& books, const string& path);
+
+    bool open(const string& path);
+    void close();
+    bool isOpen() const;
+
+    size_t size() const;
+    const CatalogRecord& record(size_t index) const;
+    size_t recordAtTitleRank(size_t rank) const;
+    int findRecord(int bookID) const;
+
+    string_view text(const CatalogStringRef& ref) const;
+    vector<string> downloadLinks(size_t index) const;
+    Book toBook(size_t index) const;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "BinaryIO.h"
+#include "../models/Book.h"
+#include "../models/User.h"
+
+using namespace std;
+
+// Binary encoding of Book and User records, shared by the write-ahead log
+// and snapshot formats. Loans are not part of a User record.
+class RecordCodec {
+public:
+    static void putBook(string& out, const Book& b) {
+        BinaryIO::putInt(out, b.getBookID());
+        BinaryIO::putString(out, b.getTitle());
+        BinaryIO::putString(out, b.getAuthor());
+        BinaryIO::putString(out, b.getISBN());
+        BinaryIO::putString(out, b.getCategory());
+        BinaryIO::putInt(out, b.getCopies());
+        BinaryIO::putInt(out, b.getAvailableCopies());
+        BinaryIO::putString(out, b.getCoverImage());
+        BinaryIO::putString(out, b.getType());
+        vector<string> links = b.getDownloadLinks();
+        BinaryIO::putU32(out, (uint32_t)links.size());
+        for (const auto& link : links) {
+            BinaryIO::putString(out, link);
+        }
+    }
+
+    static Book readBook(BinaryReader& in) {
+        int id = in.readInt();
+        string title = in.readString();
+        string author = in.readString();
+        string isbn = in.readString();
+        string category = in.readString();
+        int copies = in.readInt();
+        int available = in.readInt();
+        string cover = in.readString();
+        string type = in.readString();
+        uint32_t linkCount = in.readU32();
+        vector<string> links;
+        for (uint32_t i = 0; i < linkCount && in.ok; i++) {
+            links.push_back(in.readString());
+        }
+        return Book(id, title, author, isbn, category, copies, available, cover, type, links);
+    }
+
+    static void putUser(string& out, const User& u) {
+        BinaryIO::putInt(out, u.getUserID());
+        BinaryIO::putString(out, u.getName());
+        BinaryIO::putString(out, u.getEmail());
+        BinaryIO::putString(out, u.getRole());
+    }
+
+    static User readUser(BinaryReader& in) {
+        int id = in.readInt();
+        string name = in.readString();
+        string email = in.readString();
+        string role = in.readString();
+        return User(id, name, email, role);
+    }
+};
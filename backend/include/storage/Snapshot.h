@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include "../services/Library.h"
+
+using namespace std;
+
+class WriteAheadLog;
+class BinaryReader;
+
+struct SnapshotInfo {
+    uint32_t version = 0;
+    uint64_t walLsn = 0;
+    int books = 0;
+    int users = 0;
+};
+
+// Versioned binary image of the whole Library: books in title order (so the
+// B-tree can be bulk loaded), users with their loans (due dates from version
+// 3), borrow counts, the circulation sketches (version 2) and co-borrowing
+// neighbours (version 4).
+class LibrarySnapshot {
+private:
+    static void putSketches(string& body, const CirculationSketches& sketches);
+    static bool readSketches(BinaryReader& in, CirculationSketches& sketches);
+    static void putCoBorrows(string& body, const CoBorrowIndex& index);
+    static bool readCoBorrows(BinaryReader& in, CoBorrowIndex& index);
+
+public:
+    static const uint32_t FORMAT_VERSION = 4;
+
+    static bool write(const Library& library, const string& path, uint64_t walLsn, SnapshotInfo* info = nullptr);
+    static bool load(Library& library, const string& path, SnapshotInfo* info = nullptr);
+};
+
+// Takes snapshots on demand or when maybeSnapshot() notices the interval has
+// elapsed with new WAL records. After a snapshot the WAL is reset, so restart
+// cost is one snapshot read plus the WAL tail.
+class SnapshotManager {
+private:
+    Library& library;
+    WriteAheadLog* wal;
+    string path;
+    chrono::seconds interval;
+    chrono::steady_clock::time_point lastSnapshot;
+    uint64_t lastSnapshotLsn;
+
+public:
+    SnapshotManager(Library& lib, WriteAheadLog* log, const string& snapshotPath, int intervalSeconds = 300);
+
+    bool restore(SnapshotInfo* info = nullptr);
+    bool snapshotNow(SnapshotInfo* info = nullptr);
+    bool maybeSnapshot();
+
+    string getPath() const;
+    uint64_t getLastSnapshotLsn() const;
+};
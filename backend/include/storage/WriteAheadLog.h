@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include "../models/Book.h"
+#include "../models/User.h"
+
+using namespace std;
+
+class Library;
+
+// How hard append() tries to make a record durable before returning.
+//   EveryOperation - caller blocks until its record is fsync'd. Group commit
+//                    lets callers on different threads share one fsync. A
+//                    single-threaded caller can defer the wait instead (see
+//                    setDeferredSync) and cover several operations with one
+//                    sync(), as the HTTP server does per batch of requests.
+//   Interval       - a background flusher fsyncs every syncIntervalMs
+//   None           - records reach the OS page cache, never fsync'd
+enum class WalSyncMode {
+    EveryOperation,
+    Interval,
+    None
+};
+
+struct WalOptions {
+    WalSyncMode syncMode = WalSyncMode::Interval;
+    int syncIntervalMs = 10;
+
+    static WalOptions parse(const string& mode, int intervalMs = 10);
+};
+
+enum class WalRecordType : uint8_t {
+    AddBook = 1,
+    AddUser = 2,
+    BorrowBook = 3,
+    ReturnBook = 4,
+    RemoveBook = 5
+};
+
+class WriteAheadLog {
+private:
+    string path;
+    WalOptions options;
+    int fd;
+
+    mutable mutex mtx;
+    condition_variable flushed;
+    condition_variable flushRequested;
+    thread flusher;
+    bool stopping;
+    bool flushing;
+
+    string pending;
+    uint64_t lastLsn;
+    uint64_t durableLsn;
+    off_t writtenEnd;  // file size after the last complete write
+    bool failed;       // a write failed; appends are refused until reset()
+    bool deferSync;    // EveryOperation commits only queue; sync() makes them durable
+
+    uint64_t append(WalRecordType type, const string& payload);
+    uint64_t queueRecord(WalRecordType type, const string& payload);
+    uint64_t commit(uint64_t lsn, unique_lock<mutex>& lock);
+    bool waitDurable(uint64_t lsn, unique_lock<mutex>& lock);
+    bool flushPending(unique_lock<mutex>& lock, bool doSync);
+    void flusherLoop();
+
+    bool writeHeader(uint64_t baseLsn);
+    bool scanExisting();
+
+public:
+    WriteAheadLog(const string& filePath, WalOptions opts = WalOptions());
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // Each returns the record's LSN, or 0 if it could not be logged (the log
+    // is closed or a write failed); the caller must then not apply the change.
+    uint64_t logAddBook(const Book& b);
+    // The whole batch is written together; returns the last record's LSN.
+    uint64_t logAddBooks(const vector<Book>& books);
+    uint64_t logAddUser(const User& u);
+    uint64_t logBorrow(int userID, int bookID, int64_t dueAt);
+    uint64_t logReturn(int userID, int bookID);
+    uint64_t logRemoveBook(int bookID);
+
+    // With deferred sync, EveryOperation appends return once their record is
+    // queued and the caller must sync() before acknowledging the change.
+    // Queued records are still written out in large pieces along the way.
+    void setDeferredSync(bool deferred);
+    // Returns false if a record could not be made durable.
+    bool sync();
+    bool reset();
+
+    int replay(Library& library, uint64_t afterLsn = 0);
+
+    uint64_t getLastLsn() const;
+    uint64_t getDurableLsn() const;
+    bool hasFailed() const;
+    string getPath() const;
+    WalOptions getOptions() const;
+};
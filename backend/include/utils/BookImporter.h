@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include "../services/Library.h"
+
+using namespace std;
+
+class JsonStreamParser;
+
+struct ImportError {
+    size_t record;  // NDJSON line number, or CSV data row number (header excluded)
+    string message;
+};
+
+struct ImportReport {
+    size_t imported = 0;
+    size_t rejected = 0;
+    vector<ImportError> errors;  // the first MAX_ERRORS only
+    // Set when the library refused a batch (e.g. the WAL failed). The import
+    // stopped there: the books counted in `imported` are in the library, the
+    // failed batch and everything after it are not.
+    string failure;
+};
+
+// Incremental book import from NDJSON (one JSON object per line) or CSV (a
+// header row naming the columns, RFC 4180 quoting). feed() accepts the input
+// in pieces of any size, so a request body can be parsed as it arrives; only
+// the record being read and the current batch are held in memory. Valid
+// records go into the library through Library::addBooks, one batch at a
+// time; invalid ones are skipped and reported by record number. Field names
+// are those of library_data.json (bookID or id, title, author, isbn,
+// category, copies, availableCopies, cover or coverImage, type).
+class BookImporter {
+public:
+    enum class Format { NDJSON, CSV };
+
+    static const size_t BATCH_SIZE = 4096;
+    static const size_t MAX_RECORD_BYTES = 1 << 20;
+    static const size_t MAX_ERRORS = 100;
+
+    BookImporter(Library& library, Format format);
+    ~BookImporter();
+
+    BookImporter(const BookImporter&) = delete;
+    BookImporter& operator=(const BookImporter&) = delete;
+
+    // Accepts "ndjson", "csv" or a matching content type
+    static bool parseFormat(const string& name, Format& format);
+
+    // Input after a failed batch is ignored; see ImportReport::failure.
+    void feed(string_view data);
+    // Reads a last record without a trailing newline and adds the final batch.
+    ImportReport finish();
+
+private:
+    struct Fields;
+    class RecordHandler;
+
+    Library& library;
+    Format format;
+    ImportReport report;
+
+    vector<Book> batch;
+    unordered_set<int> batchIDs;
+    bool failed;     // a batch was refused; the rest of the input is ignored
+    string pending;  // a record split across feed() calls
+    bool skipping;   // the pending record is too long and is being skipped
+    bool inQuotes;   // CSV: inside a quoted field
+    size_t records;
+
+    vector<string> columns;  // CSV header
+    bool haveHeader;
+    vector<string> values;
+
+    unique_ptr<Fields> fields;
+    unique_ptr<RecordHandler> handler;
+    unique_ptr<JsonStreamParser> parser;
+
+    size_t findEnd(string_view data, size_t from);
+    void endRecord(string_view text);
+    bool readJson(string_view text, string& error);
+    bool readCsv(string_view text, string& error);
+    bool splitCsv(string_view text);
+    bool validate(Book& book, string& error);
+    void reject(const string& message);
+    void flush();
+};
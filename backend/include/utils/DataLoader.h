@@ -2,143 +2,36 @@
 #define DATA_LOADER_H
 
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <vector>
+#include <istream>
 #include "../services/Library.h"
 
+// Loads the JSON catalog ({"books": [...], "users": [...]}) in one streaming
+// pass: records are added to the library as soon as their closing brace is
+// parsed, so only the record being read is held in memory. Files are mmap'd
+// and fields are read as views into the mapping; strings are only copied
+// (or interned) once, when they enter a Book or User.
 class DataLoader {
 public:
-    // Simple JSON parser for our specific format
-    static bool loadFromFile(Library& library, const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open " << filename << std::endl;
-            return false;
-        }
-
-        std::string content((std::istreambuf_iterator<char>(file)),
-                           std::istreambuf_iterator<char>());
-        file.close();
-
-        // Parse books
-        size_t booksPos = content.find("\"books\":");
-        if (booksPos != std::string::npos) {
-            parseBooks(library, content, booksPos);
-        }
-
-        // Parse users
-        size_t usersPos = content.find("\"users\":");
-        if (usersPos != std::string::npos) {
-            parseUsers(library, content, usersPos);
-        }
-
-        return true;
-    }
-
-private:
-    static std::string extractValue(const std::string& json, const std::string& key, size_t startPos) {
-        size_t keyPos = json.find("\"" + key + "\":", startPos);
-        if (keyPos == std::string::npos) return "";
-        
-        size_t valueStart = json.find(":", keyPos) + 1;
-        while (json[valueStart] == ' ') valueStart++;
-        
-        if (json[valueStart] == '"') {
-            // String value
-            valueStart++;
-            size_t valueEnd = json.find('"', valueStart);
-            return json.substr(valueStart, valueEnd - valueStart);
-        } else {
-            // Number value
-            size_t valueEnd = json.find_first_of(",}\n", valueStart);
-            std::string num = json.substr(valueStart, valueEnd - valueStart);
-            // Trim whitespace
-            size_t first = num.find_first_not_of(" \t\n\r");
-            size_t last = num.find_last_not_of(" \t\n\r");
-            return (first == std::string::npos) ? "" : num.substr(first, last - first + 1);
-        }
-    }
-
-    static int extractInt(const std::string& json, const std::string& key, size_t startPos) {
-        std::string value = extractValue(json, key, startPos);
-        return value.empty() ? 0 : std::stoi(value);
-    }
-
-    static void parseBooks(Library& library, const std::string& json, size_t startPos) {
-        size_t pos = json.find('[', startPos);
-        if (pos == std::string::npos) return;
-
-        int count = 0;
-        while (true) {
-            size_t objStart = json.find('{', pos);
-            if (objStart == std::string::npos) break;
-            
-            size_t objEnd = json.find('}', objStart);
-            if (objEnd == std::string::npos) break;
-
-            // Check if we've moved to users section
-            if (json.substr(objStart, objEnd - objStart).find("\"email\"") != std::string::npos) {
-                break;
-            }
-
-            int id = extractInt(json, "bookID", objStart);
-            std::string title = extractValue(json, "title", objStart);
-            std::string author = extractValue(json, "author", objStart);
-            std::string isbn = extractValue(json, "isbn", objStart);
-            std::string category = extractValue(json, "category", objStart);
-            int copies = extractInt(json, "copies", objStart);
-            int availableCopies = extractInt(json, "availableCopies", objStart);
-            // Try "cover" field first (new real covers), fallback to "coverImage"
-            std::string coverImage = extractValue(json, "cover", objStart);
-            if (coverImage.empty()) {
-                coverImage = extractValue(json, "coverImage", objStart);
-            }
-            std::string type = extractValue(json, "type", objStart);
-
-            if (id > 0 && !title.empty()) {
-                library.addBook(Book(id, title, author, isbn, category, copies, availableCopies, coverImage, type));
-                count++;
-            }
-
-            pos = objEnd + 1;
-            
-            // Stop if we hit the users section
-            size_t nextObj = json.find('{', pos);
-            size_t usersSection = json.find("\"users\"", pos);
-            if (usersSection != std::string::npos && usersSection < nextObj) {
-                break;
-            }
-        }
-        std::cout << "Loaded " << count << " books from file\n";
-    }
-
-    static void parseUsers(Library& library, const std::string& json, size_t startPos) {
-        size_t pos = json.find('[', startPos);
-        if (pos == std::string::npos) return;
-
-        int count = 0;
-        while (true) {
-            size_t objStart = json.find('{', pos);
-            if (objStart == std::string::npos) break;
-            
-            size_t objEnd = json.find('}', objStart);
-            if (objEnd == std::string::npos) break;
-
-            int id = extractInt(json, "id", objStart);
-            std::string name = extractValue(json, "name", objStart);
-            std::string email = extractValue(json, "email", objStart);
-            std::string role = extractValue(json, "role", objStart);
-
-            if (id > 0 && !name.empty()) {
-                library.addUser(User(id, name, email, role));
-                count++;
-            }
-
-            pos = objEnd + 1;
-            if (pos >= json.size()) break;
-        }
-        std::cout << "Loaded " << count << " users from file\n";
-    }
+    static const size_t BLOCK_SIZE = 4 << 20;
+
+    static bool loadFromFile(Library& library, const std::string& filename);
+    static bool loadFromStream(Library& library, std::istream& in, const std::string& name);
+
+    // Multi-stage load: the file is read in blocks, each block's structural
+    // characters are indexed (JsonStructuralIndex) and used to cut it into
+    // record-aligned chunks, a pool of `threads` workers builds records from
+    // the index, and the records are merged in file order and bulk loaded.
+    // Nothing is added unless the whole file parses. threads <= 0 uses one
+    // per hardware thread.
+    static bool loadFromFileParallel(Library& library, const std::string& filename, int threads = 0);
+
+    // The read and parse stages on their own; records come back in file order.
+    // With copyFile the file is read into memory rather than mapped, for files
+    // that may be truncated or rewritten while they are parsed (see MappedFile).
+    static bool parseFileParallel(const std::string& filename, int threads,
+                                  std::vector<Book>& books, std::vector<User>& users,
+                                  size_t blockSize = BLOCK_SIZE, bool copyFile = false);
 };
 
 #endif
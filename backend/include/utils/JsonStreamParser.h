@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <istream>
+
+using namespace std;
+
+// Callbacks for JsonStreamParser. Views passed to them are only valid for
+// the duration of the call, except that when parsing a string_view, strings
+// without escapes are passed as views into that input.
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual void startObject() {}
+    virtual void endObject() {}
+    virtual void startArray() {}
+    virtual void endArray() {}
+    virtual void key(string_view) {}
+    virtual void stringValue(string_view) {}
+    virtual void numberValue(string_view) {}
+    virtual void boolValue(bool) {}
+    virtual void nullValue() {}
+};
+
+// Single-pass, SAX-style JSON parser. Input is pulled through a fixed-size
+// buffer and every token is reported to the handler as soon as it is
+// complete, so memory stays bounded by the buffer, the longest string and
+// the nesting depth regardless of document size. Strings are unescaped
+// (including \u surrogate pairs, emitted as UTF-8) and the grammar is
+// validated; the first error stops the parse.
+class JsonStreamParser {
+private:
+    enum class Container : char { Object, Array };
+
+    JsonHandler& handler;
+    vector<char> buffer;
+    const char* base;  // start of the current buffer
+    const char* pos;
+    const char* end;
+    istream* input;
+    size_t consumed;  // bytes before the current buffer
+
+    vector<Container> stack;
+    string scratch;
+    string_view token;  // last string; in scratch or in the input
+    string error;
+
+    bool refill();
+    int peek();
+    int next();
+    bool skipWhitespace();
+    bool fail(const string& message);
+
+    bool parseScalar(int c);
+    bool parseString();
+    bool parseEscape();
+    bool parseHex4(unsigned& code);
+    bool parseNumber(int first);
+    bool parseLiteral(const char* word);
+    void appendUtf8(unsigned code);
+    bool run();
+
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+    static const size_t MAX_DEPTH = 512;
+
+    explicit JsonStreamParser(JsonHandler& handler, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    // Parses exactly one document (surrounding whitespace allowed).
+    bool parse(istream& in);
+    bool parse(string_view text);
+
+    const string& getError() const;
+    size_t getOffset() const;
+};
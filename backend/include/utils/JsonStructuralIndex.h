@@ -0,0 +1,34 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Stage 1 of a two-stage JSON parse in the style of simdjson: records the
+// offset of every structural character ({ } [ ] : ,) outside strings and of
+// every unescaped quote, so stage 2 can walk offsets instead of bytes.
+//
+// Input is classified 64 bytes at a time into bitmasks (SSE2 when the
+// compiler targets it, otherwise a portable scalar loop). Escapes are
+// resolved on the backslash mask, the inside of strings is the prefix XOR
+// of the quote mask, and offsets are read off the final mask with
+// count-trailing-zeros. A document can be indexed in pieces; State carries
+// the open string and pending escape across piece boundaries.
+class JsonStructuralIndex {
+public:
+    static const size_t NONE = (size_t)-1;
+
+    struct State {
+        bool inString = false;
+        bool escapeNext = false;
+        size_t controlCharAt = NONE;  // first raw control character inside a string
+    };
+
+    // Appends the structural offsets of text[0, length), each plus `offset`.
+    static void index(const char* text, size_t length, uint32_t offset, State& state,
+                      vector<uint32_t>& out, bool scalarOnly = false);
+
+    static bool simdEnabled();
+};
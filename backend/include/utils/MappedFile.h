@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Read-only mapping of a whole file. The contents are file-backed pages, so
+// reading through them costs no heap copy and the kernel can drop pages that
+// were already read. Views into text() stay valid until close().
+//
+// The pages are only as stable as the file: if another process truncates it
+// while it is mapped, touching a page past the new end raises SIGBUS. Map
+// files nobody rewrites in place; for ones that may change under the reader
+// (the watched catalog), load() takes a private copy instead.
+class MappedFile {
+private:
+    const char* base;
+    size_t mappedSize;
+    string copy;  // contents when loaded rather than mapped
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Empty files open successfully with an empty text().
+    bool open(const string& path);
+    // Reads the file into memory instead; same interface, no mapping.
+    bool load(const string& path);
+    void close();
+    bool isOpen() const;
+
+    string_view text() const;
+    bool contains(string_view part) const;
+
+    // Drops the pages wholly inside [from, to) from memory once a reader is
+    // done with them, so resident memory tracks the part being read rather
+    // than the whole file. Touching them again reads them back in.
+    void release(size_t from, size_t to) const;
+};
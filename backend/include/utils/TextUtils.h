@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cctype>
+#include <algorithm>
+
+using namespace std;
+
+// Case-insensitive (ASCII) helpers that work on views, so callers can compare
+// and search without building lowercased copies.
+class TextUtils {
+public:
+    static char fold(char c) {
+        return (char)tolower((unsigned char)c);
+    }
+
+    static string toLower(string_view s) {
+        string out(s);
+        transform(out.begin(), out.end(), out.begin(), [](char c) { return fold(c); });
+        return out;
+    }
+
+    static int compareFolded(string_view a, string_view b) {
+        size_t n = min(a.size(), b.size());
+        for (size_t i = 0; i < n; i++) {
+            unsigned char ca = (unsigned char)fold(a[i]);
+            unsigned char cb = (unsigned char)fold(b[i]);
+            if (ca != cb) return ca < cb ? -1 : 1;
+        }
+        if (a.size() == b.size()) return 0;
+        return a.size() < b.size() ? -1 : 1;
+    }
+
+    static bool equalsFolded(string_view a, string_view b) {
+        return a.size() == b.size() && compareFolded(a, b) == 0;
+    }
+
+    // `needleLower` must already be lowercase.
+    static bool containsFolded(string_view haystack, string_view needleLower) {
+        if (needleLower.empty()) return true;
+        if (needleLower.size() > haystack.size()) return false;
+
+        size_t last = haystack.size() - needleLower.size();
+        for (size_t i = 0; i <= last; i++) {
+            size_t j = 0;
+            while (j < needleLower.size() && fold(haystack[i + j]) == needleLower[j]) {
+                j++;
+            }
+            if (j == needleLower.size()) return true;
+        }
+        return false;
+    }
+};
@@ -3,8 +3,8 @@
 #include <sstream>
 #include <algorithm>
 
-Route::Route(HttpMethod m, const string& p, RouteHandler h)
-    : method(m), path(p), handler(h) {
+Route::Route(HttpMethod m, const string& p, RouteHandler h, bool streaming)
+    : method(m), path(p), handler(h), streamsBody(streaming) {
 
     string pattern = p;
     size_t pos = 0;
@@ -87,9 +87,22 @@ void Router::del(const string& path, RouteHandler handler) {
     registerRoute(HttpMethod::DELETE, path, handler);
 }
 
-void Router::registerRoute(HttpMethod method, const string& path, RouteHandler handler) {
+void Router::postStream(const string& path, RouteHandler handler) {
+    registerRoute(HttpMethod::POST, path, handler, true);
+}
+
+void Router::registerRoute(HttpMethod method, const string& path, RouteHandler handler, bool streaming) {
     string fullPath = basePath + normalizePath(path);
-    routes.push_back(Route(method, fullPath, handler));
+    routes.push_back(Route(method, fullPath, handler, streaming));
+}
+
+// Whether the route that would handle this request reads its own body
+bool Router::streamsBody(HttpMethod method, const string& path) const {
+    string normalizedPath = normalizePath(path);
+    for (const auto& route : routes) {
+        if (route.matches(method, normalizedPath)) return route.streamsBody;
+    }
+    return false;
 }
 
 HttpResponse Router::handleRequest(const HttpRequest& request) {
@@ -0,0 +1,35 @@
+#include "../../include/controllers/AdminController.h"
+#include <sstream>
+
+AdminController::AdminController(SnapshotManager* manager) : snapshots(manager) {}
+
+HttpResponse AdminController::createSnapshot(const HttpRequest& req) {
+    (void)req;
+
+    try {
+        SnapshotInfo info;
+        if (!snapshots->snapshotNow(&info)) {
+            return HttpResponse::serverError(
+                JsonHelper::createErrorResponse("Failed to write snapshot")
+            );
+        }
+
+        stringstream ss;
+        ss << "{";
+        ss << "\"path\":\"" << JsonHelper::escapeJson(snapshots->getPath()) << "\",";
+        ss << "\"version\":" << info.version << ",";
+        ss << "\"walLsn\":" << info.walLsn << ",";
+        ss << "\"books\":" << info.books << ",";
+        ss << "\"users\":" << info.users;
+        ss << "}";
+
+        return HttpResponse::ok(
+            JsonHelper::createSuccessResponse(ss.str(), "Snapshot written")
+        );
+
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse("Failed to write snapshot: " + string(e.what()))
+        );
+    }
+}
@@ -1,10 +1,12 @@
 #include "../../include/controllers/BookController.h"
+#include "../../include/utils/BookImporter.h"
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 BookController::BookController(Library* lib) : library(lib) {}
 
-string BookController::bookToJson(const Book& book) {
+map<string, string> BookController::bookFields(const Book& book) {
     map<string, string> fields;
     fields["id"] = to_string(book.getBookID());
     fields["title"] = book.getTitle();
@@ -15,8 +17,11 @@ string BookController::bookToJson(const Book& book) {
     fields["availableCopies"] = to_string(book.getAvailableCopies());
     fields["coverImage"] = book.getCoverImage();
     fields["type"] = book.getType();
+    return fields;
+}
 
-    return JsonHelper::createObject(fields);
+string BookController::bookToJson(const Book& book) {
+    return JsonHelper::createObject(bookFields(book));
 }
 
 string BookController::booksToJson(const vector<Book>& books) {
@@ -68,26 +73,148 @@ HttpResponse BookController::getBookById(const HttpRequest& request) {
     }
 }
 
+// GET /books/search?q=...&limit=N: BM25-ranked full-text search over
+// title, author and category, best match first.
+HttpResponse BookController::rankedSearch(const HttpRequest& request) {
+    int limit;
+    if (!request.getLimitParam("limit", 20, 100, limit)) {
+        return HttpResponse::badRequest("limit must be a positive integer");
+    }
+
+    vector<ScoredBook> ranked = library->rankBooks(request.getQueryParam("q"), limit);
+
+    vector<string> bookJsons;
+    for (const auto& hit : ranked) {
+        Book* book = library->findBookByID(hit.bookID);
+        if (book == nullptr) continue;
+
+        map<string, string> fields = bookFields(*book);
+        fields["score"] = to_string(hit.score);
+        bookJsons.push_back(JsonHelper::createObject(fields));
+    }
+
+    map<string, string> response;
+    response["status"] = "success";
+    response["data"] = JsonHelper::createArray(bookJsons);
+    response["count"] = to_string(bookJsons.size());
+    return HttpResponse::ok(JsonHelper::createObject(response));
+}
+
+// GET /books/suggest?prefix=...&limit=N: title and author completions,
+// most borrowed first.
+HttpResponse BookController::suggestBooks(const HttpRequest& request) {
+    try {
+        if (!request.hasQueryParam("prefix")) {
+            return HttpResponse::badRequest("Please provide a prefix parameter");
+        }
+
+        string prefix = request.getQueryParam("prefix");
+        int limit;
+        if (!request.getLimitParam("limit", 10, 50, limit)) {
+            return HttpResponse::badRequest("limit must be a positive integer");
+        }
+
+        struct Suggestion {
+            Completion completion;
+            const char* type;
+        };
+        vector<Suggestion> merged;
+        for (auto& c : library->suggestTitles(prefix, limit)) merged.push_back({move(c), "title"});
+        for (auto& c : library->suggestAuthors(prefix, limit)) merged.push_back({move(c), "author"});
+
+        stable_sort(merged.begin(), merged.end(), [](const Suggestion& a, const Suggestion& b) {
+            return a.completion.weight > b.completion.weight;
+        });
+        if ((int)merged.size() > limit) merged.resize(limit);
+
+        vector<string> items;
+        for (const auto& s : merged) {
+            map<string, string> fields;
+            fields["text"] = s.completion.text;
+            fields["type"] = s.type;
+            fields["weight"] = to_string(s.completion.weight);
+            items.push_back(JsonHelper::createObject(fields));
+        }
+
+        map<string, string> response;
+        response["status"] = "success";
+        response["data"] = JsonHelper::createArray(items);
+        response["count"] = to_string(items.size());
+        return HttpResponse::ok(JsonHelper::createObject(response));
+
+    } catch (const invalid_argument& e) {
+        return HttpResponse::badRequest("Invalid limit");
+    } catch (const exception& e) {
+        return HttpResponse::serverError(e.what());
+    }
+}
+
+// GET /books/:id/recommendations?limit=N: books most often borrowed
+// alongside this one, strongest first.
+HttpResponse BookController::getRecommendations(const HttpRequest& request) {
+    try {
+        string idStr = request.getPathParam("id");
+        int id = stoi(idStr);
+        if (library->findBookByID(id) == nullptr) {
+            return HttpResponse::notFound("Book not found with ID: " + idStr);
+        }
+
+        int limit;
+        if (!request.getLimitParam("limit", 10, CoBorrowIndex::maxRecommendations(), limit)) {
+            return HttpResponse::badRequest("limit must be a positive integer");
+        }
+
+        vector<string> bookJsons;
+        for (const auto& partner : library->recommendBooks(id, limit)) {
+            Book* book = library->findBookByID(partner.key);
+            if (book == nullptr) continue;
+
+            map<string, string> fields = bookFields(*book);
+            fields["coBorrowCount"] = to_string(partner.count);
+            bookJsons.push_back(JsonHelper::createObject(fields));
+        }
+
+        map<string, string> response;
+        response["status"] = "success";
+        response["data"] = JsonHelper::createArray(bookJsons);
+        response["count"] = to_string(bookJsons.size());
+        return HttpResponse::ok(JsonHelper::createObject(response));
+
+    } catch (const invalid_argument& e) {
+        return HttpResponse::badRequest("Invalid book ID or limit");
+    } catch (const exception& e) {
+        return HttpResponse::serverError(e.what());
+    }
+}
+
 HttpResponse BookController::searchBooks(const HttpRequest& request) {
     try {
         vector<Book> results;
 
-        if (request.hasQueryParam("title")) {
-            string title = request.getQueryParam("title");
-            results = library->searchBookByTitle(title);
+        if (request.hasQueryParam("q")) {
+            return rankedSearch(request);
         }
 
-        else if (request.hasQueryParam("author")) {
-            string author = request.getQueryParam("author");
-            results = library->searchBookByAuthor(author);
+        // fuzzy=1 or fuzzy=2 sets the edit distance for a title search;
+        // fuzzy=0 turns it off, leaving the plain substring filters below
+        string fuzzy = request.getQueryParam("fuzzy");
+        if (request.hasQueryParam("fuzzy") && fuzzy != "0" && fuzzy != "1" && fuzzy != "2") {
+            return HttpResponse::badRequest("fuzzy must be 0, 1 or 2");
         }
 
-        else if (request.hasQueryParam("category")) {
-            string category = request.getQueryParam("category");
-            results = library->searchBookByCategory(category);
-        }
-        else {
-            return HttpResponse::badRequest("Please provide title, author, or category parameter");
+        if (request.hasQueryParam("title") && (fuzzy == "1" || fuzzy == "2")) {
+            results = library->searchBookByTitleFuzzy(request.getQueryParam("title"), fuzzy == "1" ? 1 : 2);
+        } else {
+            // Any combination of title, author and category; all must match
+            BookQuery query;
+            if (request.hasQueryParam("title")) query.title = request.getQueryParam("title");
+            if (request.hasQueryParam("author")) query.author = request.getQueryParam("author");
+            if (request.hasQueryParam("category")) query.category = request.getQueryParam("category");
+            if (!query.hasFilter()) {
+                return HttpResponse::badRequest("Please provide q, title, author, or category parameter");
+            }
+            query.availableOnly = request.getQueryParam("available") == "true";
+            results = library->findBooks(query);
         }
 
         map<string, string> response;
@@ -114,6 +241,9 @@ HttpResponse BookController::createBook(const HttpRequest& request) {
         }
 
         static int nextId = 1000;
+        while (library->findBookByID(nextId)) {
+            nextId++;
+        }
         int id = nextId++;
 
         string title = fields["title"];
@@ -133,6 +263,56 @@ HttpResponse BookController::createBook(const HttpRequest& request) {
     }
 }
 
+HttpResponse BookController::bulkImport(const HttpRequest& request) {
+    try {
+        string formatName = request.getQueryParam("format");
+        if (formatName.empty()) formatName = request.getHeader("Content-Type");
+
+        BookImporter::Format format;
+        if (!BookImporter::parseFormat(formatName, format)) {
+            return HttpResponse::badRequest("Body must be NDJSON (application/x-ndjson) or CSV (text/csv)");
+        }
+
+        BookImporter importer(*library, format);
+        vector<char> buffer(64 * 1024);
+        size_t n;
+        // After a failed batch the importer ignores its input, but the body is
+        // still read to the end so the client gets the response
+        while ((n = request.readBody(buffer.data(), buffer.size())) > 0) {
+            importer.feed(string_view(buffer.data(), n));
+        }
+        ImportReport report = importer.finish();
+
+        vector<string> errors;
+        for (const auto& e : report.errors) {
+            map<string, string> error;
+            error["record"] = to_string(e.record);
+            error["message"] = e.message;
+            errors.push_back(JsonHelper::createObject(error));
+        }
+
+        map<string, string> response;
+        response["status"] = report.failure.empty() ? "success" : "error";
+        response["imported"] = to_string(report.imported);
+        response["rejected"] = to_string(report.rejected);
+        response["errors"] = JsonHelper::createArray(errors);
+        if (!report.failure.empty()) {
+            response["message"] = "Import stopped: " + report.failure;
+        }
+
+        string json = JsonHelper::createObject(response);
+        if (!report.failure.empty()) {
+            HttpResponse res(HttpStatus::INTERNAL_SERVER_ERROR);
+            res.setBody(json);
+            return res;
+        }
+        return HttpResponse::ok(json);
+
+    } catch (const exception& e) {
+        return HttpResponse::serverError(e.what());
+    }
+}
+
 HttpResponse BookController::updateBook(const HttpRequest& request) {
     try {
         string idStr = request.getPathParam("id");
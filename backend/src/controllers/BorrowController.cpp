@@ -37,13 +37,10 @@ HttpResponse BorrowController::borrowBook(const HttpRequest& req) {
             );
         }
 
-        const vector<int> borrowedBooks = user->getBorrowedBookIDs();
-        for (int id : borrowedBooks) {
-            if (id == bookId) {
-                return HttpResponse::badRequest(
-                    JsonHelper::createErrorResponse("User already borrowed this book")
-                );
-            }
+        if (user->hasBorrowedBook(bookId)) {
+            return HttpResponse::badRequest(
+                JsonHelper::createErrorResponse("User already borrowed this book")
+            );
         }
 
         bool success = library->borrowBook(userId, bookId);
@@ -53,6 +50,12 @@ HttpResponse BorrowController::borrowBook(const HttpRequest& req) {
             );
         }
 
+        // Re-read: the mutation may have moved the book or changed its counts
+        book = library->findBookByID(bookId);
+
+        time_t dueAt = 0;
+        library->getLoanDueDate(userId, bookId, dueAt);
+
         stringstream ss;
         ss << "{";
         ss << "\"message\":\"Book borrowed successfully\",";
@@ -60,7 +63,8 @@ HttpResponse BorrowController::borrowBook(const HttpRequest& req) {
         ss << "\"userName\":\"" << JsonHelper::escapeJson(user->getName()) << "\",";
         ss << "\"bookID\":" << bookId << ",";
         ss << "\"bookTitle\":\"" << JsonHelper::escapeJson(book->getTitle()) << "\",";
-        ss << "\"availableCopies\":" << book->getAvailableCopies();
+        ss << "\"availableCopies\":" << book->getAvailableCopies() << ",";
+        ss << "\"dueAt\":" << dueAt;
         ss << "}";
 
         return HttpResponse::ok(ss.str());
@@ -99,16 +103,7 @@ HttpResponse BorrowController::returnBook(const HttpRequest& req) {
             );
         }
 
-        const vector<int> borrowedBooks = user->getBorrowedBookIDs();
-        bool hasBorrowed = false;
-        for (int id : borrowedBooks) {
-            if (id == bookId) {
-                hasBorrowed = true;
-                break;
-            }
-        }
-
-        if (!hasBorrowed) {
+        if (!user->hasBorrowedBook(bookId)) {
             return HttpResponse::badRequest(
                 JsonHelper::createErrorResponse("User has not borrowed this book")
             );
@@ -121,6 +116,9 @@ HttpResponse BorrowController::returnBook(const HttpRequest& req) {
             );
         }
 
+        // Re-read: the mutation may have moved the book or changed its counts
+        book = library->findBookByID(bookId);
+
         stringstream ss;
         ss << "{";
         ss << "\"message\":\"Book returned successfully\",";
@@ -173,3 +171,96 @@ HttpResponse BorrowController::getBorrowHistory(const HttpRequest& req) {
         );
     }
 }
+
+HttpResponse BorrowController::getOverdueLoans(const HttpRequest& req) {
+    try {
+        int limit;
+        if (!req.getLimitParam("limit", 50, 500, limit)) {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("limit must be a positive integer"));
+        }
+
+        time_t now = time(nullptr);
+        library->processDueLoans(now);
+        vector<Loan> overdue = library->getOverdueLoans(limit);
+
+        stringstream ss;
+        ss << "[";
+        for (size_t i = 0; i < overdue.size(); i++) {
+            User* user = library->findUserByID(overdue[i].userID);
+            Book* book = library->findBookByID(overdue[i].bookID);
+
+            ss << "{";
+            ss << "\"userID\":" << overdue[i].userID << ",";
+            ss << "\"userName\":\"" << JsonHelper::escapeJson(user ? user->getName() : "") << "\",";
+            ss << "\"bookID\":" << overdue[i].bookID << ",";
+            ss << "\"bookTitle\":\"" << JsonHelper::escapeJson(book ? book->getTitle() : "") << "\",";
+            ss << "\"dueAt\":" << overdue[i].dueAt << ",";
+            ss << "\"overdueSeconds\":" << (now - overdue[i].dueAt);
+            ss << "}";
+            if (i < overdue.size() - 1) ss << ",";
+        }
+        ss << "]";
+
+        return HttpResponse::ok(
+            JsonHelper::createSuccessResponse(
+                ss.str(),
+                "Retrieved " + to_string(overdue.size()) + " of " +
+                    to_string(library->getOverdueCount()) + " overdue loans"
+            )
+        );
+
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse(string("Error: ") + e.what())
+        );
+    }
+}
+
+HttpResponse BorrowController::getBookBorrowers(const HttpRequest& req) {
+    try {
+        int bookId = stoi(req.getPathParam("id"));
+
+        Book* book = library->findBookByID(bookId);
+        if (!book) {
+            return HttpResponse::notFound(
+                JsonHelper::createErrorResponse("Book not found")
+            );
+        }
+
+        const vector<int>& borrowers = library->getBorrowers(bookId);
+
+        stringstream ss;
+        ss << "[";
+        for (size_t i = 0; i < borrowers.size(); i++) {
+            User* user = library->findUserByID(borrowers[i]);
+            time_t dueAt = 0;
+            library->getLoanDueDate(borrowers[i], bookId, dueAt);
+
+            ss << "{";
+            ss << "\"userID\":" << borrowers[i] << ",";
+            ss << "\"name\":\"" << JsonHelper::escapeJson(user ? user->getName() : "") << "\",";
+            ss << "\"email\":\"" << JsonHelper::escapeJson(user ? user->getEmail() : "") << "\",";
+            ss << "\"dueAt\":" << dueAt << ",";
+            ss << "\"overdue\":" << (library->isLoanOverdue(borrowers[i], bookId) ? "true" : "false");
+            ss << "}";
+            if (i < borrowers.size() - 1) ss << ",";
+        }
+        ss << "]";
+
+        return HttpResponse::ok(
+            JsonHelper::createSuccessResponse(
+                ss.str(),
+                "Retrieved " + to_string(borrowers.size()) + " current borrowers of \"" + book->getTitle() + "\""
+            )
+        );
+
+    } catch (const invalid_argument& e) {
+        return HttpResponse::badRequest(
+            JsonHelper::createErrorResponse("Invalid book ID format")
+        );
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse(string("Error: ") + e.what())
+        );
+    }
+}
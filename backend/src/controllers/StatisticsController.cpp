@@ -1,8 +1,10 @@
 #include "../../include/controllers/StatisticsController.h"
 #include "../../include/http/HttpModels.h"
+#include "../../include/utils/TextUtils.h"
 #include <sstream>
 #include <vector>
-#include <map>
+#include <cmath>
+#include <ctime>
 
 StatisticsController::StatisticsController(Library* lib) : library(lib) {}
 
@@ -10,52 +12,28 @@ HttpResponse StatisticsController::getDashboard(const HttpRequest& req) {
     (void)req;
 
     try {
-        vector<Book> allBooks = library->getAllBooks();
-        vector<User> allUsers = library->getAllUsers();
-
-        int totalBooks = (int)allBooks.size();
-        int availableBooks = 0;
-        int borrowedBooks = 0;
-
-        for (const auto& book : allBooks) {
-            if (book.getAvailableCopies() > 0) {
-                availableBooks++;
-            } else {
-                borrowedBooks++;
-            }
-        }
-
-        int totalBorrowedInstances = 0;
-        for (const auto& user : allUsers) {
-            totalBorrowedInstances += (int)user.getBorrowedBookIDs().size();
-        }
-
-        map<string, int> categoryCount;
-        for (const auto& book : allBooks) {
-            categoryCount[book.getCategory()]++;
-        }
+        vector<CategoryStats> categories = library->getCategoryStats();
+        LibraryTotals totals = library->getTotals();
 
         stringstream categorySS;
         categorySS << "[";
-        size_t catIdx = 0;
-        for (const auto& entry : categoryCount) {
+        for (size_t catIdx = 0; catIdx < categories.size(); catIdx++) {
             categorySS << "{";
-            categorySS << "\"category\":\"" << JsonHelper::escapeJson(entry.first) << "\",";
-            categorySS << "\"count\":" << entry.second;
+            categorySS << "\"category\":\"" << JsonHelper::escapeJson(StringPool::shared().str(categories[catIdx].category)) << "\",";
+            categorySS << "\"count\":" << categories[catIdx].totalBooks;
             categorySS << "}";
-            if (catIdx < categoryCount.size() - 1) categorySS << ",";
-            catIdx++;
+            if (catIdx < categories.size() - 1) categorySS << ",";
         }
         categorySS << "]";
 
         stringstream ss;
         ss << "{";
         ss << "\"overview\":{";
-        ss << "\"totalBooks\":" << totalBooks << ",";
-        ss << "\"availableBooks\":" << availableBooks << ",";
-        ss << "\"borrowedBooks\":" << borrowedBooks << ",";
-        ss << "\"totalUsers\":" << allUsers.size() << ",";
-        ss << "\"totalBorrowedInstances\":" << totalBorrowedInstances;
+        ss << "\"totalBooks\":" << totals.totalBooks << ",";
+        ss << "\"availableBooks\":" << totals.availableBooks << ",";
+        ss << "\"borrowedBooks\":" << totals.borrowedBooks << ",";
+        ss << "\"totalUsers\":" << totals.totalUsers << ",";
+        ss << "\"totalBorrowedInstances\":" << totals.outstandingLoans;
         ss << "},";
         ss << "\"categoryDistribution\":" << categorySS.str();
         ss << "}";
@@ -74,10 +52,10 @@ HttpResponse StatisticsController::getDashboard(const HttpRequest& req) {
 HttpResponse StatisticsController::getMostBorrowedBooks(const HttpRequest& req) {
     try {
 
-        string limitStr = req.getQueryParam("limit");
-        int limit = limitStr.empty() ? 10 : stoi(limitStr);
-        if (limit <= 0) limit = 10;
-        if (limit > 100) limit = 100;
+        int limit;
+        if (!req.getLimitParam("limit", 10, 100, limit)) {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("limit must be a positive integer"));
+        }
 
         vector<pair<int, int>> mostBorrowed = library->getMostBorrowedBooks(limit);
 
@@ -109,10 +87,6 @@ HttpResponse StatisticsController::getMostBorrowedBooks(const HttpRequest& req)
             )
         );
 
-    } catch (const invalid_argument& e) {
-        return HttpResponse::badRequest(
-            JsonHelper::createErrorResponse("Invalid limit parameter")
-        );
     } catch (const exception& e) {
         return HttpResponse::serverError(
             JsonHelper::createErrorResponse("Failed to retrieve most borrowed books: " + string(e.what()))
@@ -123,10 +97,10 @@ HttpResponse StatisticsController::getMostBorrowedBooks(const HttpRequest& req)
 HttpResponse StatisticsController::getMostActiveUsers(const HttpRequest& req) {
     try {
 
-        string limitStr = req.getQueryParam("limit");
-        int limit = limitStr.empty() ? 10 : stoi(limitStr);
-        if (limit <= 0) limit = 10;
-        if (limit > 100) limit = 100;
+        int limit;
+        if (!req.getLimitParam("limit", 10, 100, limit)) {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("limit must be a positive integer"));
+        }
 
         vector<pair<int, int>> mostActive = library->getMostActiveUsers(limit);
 
@@ -159,10 +133,6 @@ HttpResponse StatisticsController::getMostActiveUsers(const HttpRequest& req) {
             )
         );
 
-    } catch (const invalid_argument& e) {
-        return HttpResponse::badRequest(
-            JsonHelper::createErrorResponse("Invalid limit parameter")
-        );
     } catch (const exception& e) {
         return HttpResponse::serverError(
             JsonHelper::createErrorResponse("Failed to retrieve most active users: " + string(e.what()))
@@ -174,31 +144,15 @@ HttpResponse StatisticsController::getCategoryDistribution(const HttpRequest& re
     (void)req;
 
     try {
-        vector<Book> allBooks = library->getAllBooks();
-
-        map<string, int> categoryCount;
-        map<string, int> availableCount;
-        map<string, int> borrowedCount;
-
-        for (const auto& book : allBooks) {
-            string category = book.getCategory();
-            categoryCount[category]++;
-
-            if (book.getAvailableCopies() > 0) {
-                availableCount[category]++;
-            } else {
-                borrowedCount[category]++;
-            }
-        }
+        vector<CategoryStats> categories = library->getCategoryStats();
 
         stringstream ss;
         ss << "[";
-        size_t idx = 0;
-        for (const auto& entry : categoryCount) {
-            string category = entry.first;
-            int total = entry.second;
-            int available = availableCount[category];
-            int borrowed = borrowedCount[category];
+        for (size_t idx = 0; idx < categories.size(); idx++) {
+            const string& category = StringPool::shared().str(categories[idx].category);
+            int total = categories[idx].totalBooks;
+            int available = categories[idx].availableBooks;
+            int borrowed = categories[idx].borrowedBooks;
 
             ss << "{";
             ss << "\"category\":\"" << JsonHelper::escapeJson(category) << "\",";
@@ -208,15 +162,14 @@ HttpResponse StatisticsController::getCategoryDistribution(const HttpRequest& re
             ss << "\"borrowRate\":" << (total > 0 ? (borrowed * 100.0 / total) : 0);
             ss << "}";
 
-            if (idx < categoryCount.size() - 1) ss << ",";
-            idx++;
+            if (idx < categories.size() - 1) ss << ",";
         }
         ss << "]";
 
         return HttpResponse::ok(
             JsonHelper::createSuccessResponse(
                 ss.str(),
-                "Retrieved category distribution for " + to_string(categoryCount.size()) + " categories"
+                "Retrieved category distribution for " + to_string(categories.size()) + " categories"
             )
         );
 
@@ -226,3 +179,165 @@ HttpResponse StatisticsController::getCategoryDistribution(const HttpRequest& re
         );
     }
 }
+
+HttpResponse StatisticsController::getWindowedCounts(const HttpRequest& req) {
+    try {
+        string eventName = req.hasQueryParam("event") ? req.getQueryParam("event") : "borrows";
+        CirculationEvent event;
+        if (eventName == "borrows") event = CirculationEvent::Borrow;
+        else if (eventName == "returns") event = CirculationEvent::Return;
+        else if (eventName == "registrations") event = CirculationEvent::Registration;
+        else return HttpResponse::badRequest(JsonHelper::createErrorResponse("event must be borrows, returns or registrations"));
+
+        string resolutionName = req.hasQueryParam("resolution") ? req.getQueryParam("resolution") : "minute";
+        MetricsResolution resolution;
+        if (resolutionName == "minute") resolution = MetricsResolution::Minute;
+        else if (resolutionName == "hour") resolution = MetricsResolution::Hour;
+        else if (resolutionName == "day") resolution = MetricsResolution::Day;
+        else return HttpResponse::badRequest(JsonHelper::createErrorResponse("resolution must be minute, hour or day"));
+
+        int maxWindows = CirculationMetrics::maxWindows(resolution);
+        int windows;
+        if (!req.getLimitParam("n", maxWindows, maxWindows, windows)) {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("n must be a positive integer"));
+        }
+
+        time_t now = time(nullptr);
+        int width = CirculationMetrics::windowSeconds(resolution);
+        vector<uint32_t> counts;
+
+        StringPool::Id category = StringPool::EMPTY;
+        if (req.hasQueryParam("category") && event != CirculationEvent::Registration &&
+            !StringPool::shared().find(TextUtils::toLower(req.getQueryParam("category")), category)) {
+            counts.assign(windows, 0);  // never seen, so nothing was recorded for it
+        } else {
+            counts = library->getCirculationMetrics().recent(event, resolution, windows, now, category);
+        }
+
+        uint64_t total = 0;
+        stringstream windowSS;
+        windowSS << "[";
+        for (size_t i = 0; i < counts.size(); i++) {
+            time_t start = (now / width - (time_t)i) * width;
+            windowSS << "{\"start\":" << start << ",\"count\":" << counts[i] << "}";
+            if (i < counts.size() - 1) windowSS << ",";
+            total += counts[i];
+        }
+        windowSS << "]";
+
+        stringstream ss;
+        ss << "{";
+        ss << "\"event\":\"" << eventName << "\",";
+        ss << "\"resolution\":\"" << resolutionName << "\",";
+        ss << "\"windowSeconds\":" << width << ",";
+        ss << "\"total\":" << total << ",";
+        ss << "\"windows\":" << windowSS.str();
+        ss << "}";
+
+        return HttpResponse::ok(
+            JsonHelper::createSuccessResponse(ss.str(), "Retrieved " + to_string(counts.size()) + " windows, newest first")
+        );
+
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse("Failed to retrieve windowed counts: " + string(e.what()))
+        );
+    }
+}
+
+HttpResponse StatisticsController::getApproxBorrows(const HttpRequest& req) {
+    try {
+        string idStr = req.getQueryParam("bookID");
+        if (idStr.empty()) {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("bookID parameter is required"));
+        }
+        int bookID = stoi(idStr);
+        const CirculationSketches& sketches = library->getCirculationSketches();
+
+        stringstream ss;
+        ss << "{";
+        ss << "\"bookID\":" << bookID << ",";
+        ss << "\"estimatedBorrows\":" << sketches.estimateBorrows(bookID) << ",";
+        ss << "\"totalBorrows\":" << sketches.totalBorrows();
+        ss << "}";
+
+        return HttpResponse::ok(JsonHelper::createSuccessResponse(ss.str(), "Estimated borrow frequency"));
+
+    } catch (const invalid_argument& e) {
+        return HttpResponse::badRequest(JsonHelper::createErrorResponse("Invalid bookID parameter"));
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse("Failed to estimate borrows: " + string(e.what()))
+        );
+    }
+}
+
+HttpResponse StatisticsController::getApproxUniqueBorrowers(const HttpRequest& req) {
+    try {
+        const CirculationSketches& sketches = library->getCirculationSketches();
+        stringstream ss;
+        ss << "{";
+
+        if (req.hasQueryParam("bookID")) {
+            int bookID = stoi(req.getQueryParam("bookID"));
+            ss << "\"bookID\":" << bookID << ",";
+            ss << "\"estimatedBorrowers\":" << llround(sketches.estimateBorrowers(bookID));
+        } else if (req.hasQueryParam("category")) {
+            string category = req.getQueryParam("category");
+            StringPool::Id folded;
+            double estimate = StringPool::shared().find(TextUtils::toLower(category), folded)
+                                  ? sketches.estimateCategoryBorrowers(folded) : 0;
+            ss << "\"category\":\"" << JsonHelper::escapeJson(category) << "\",";
+            ss << "\"estimatedBorrowers\":" << llround(estimate);
+        } else {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("Please provide bookID or category parameter"));
+        }
+        ss << "}";
+
+        return HttpResponse::ok(JsonHelper::createSuccessResponse(ss.str(), "Estimated unique borrowers"));
+
+    } catch (const invalid_argument& e) {
+        return HttpResponse::badRequest(JsonHelper::createErrorResponse("Invalid bookID parameter"));
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse("Failed to estimate borrowers: " + string(e.what()))
+        );
+    }
+}
+
+HttpResponse StatisticsController::getApproxHeavyHitters(const HttpRequest& req) {
+    try {
+        int limit;
+        if (!req.getLimitParam("limit", 10, 64, limit)) {
+            return HttpResponse::badRequest(JsonHelper::createErrorResponse("limit must be a positive integer"));
+        }
+
+        vector<HeavyHitter<int>> hitters = library->getCirculationSketches().mostBorrowed(limit);
+
+        stringstream ss;
+        ss << "[";
+        for (size_t i = 0; i < hitters.size(); i++) {
+            Book* book = library->findBookByID(hitters[i].key);
+            ss << "{";
+            ss << "\"bookID\":" << hitters[i].key << ",";
+            ss << "\"title\":\"" << JsonHelper::escapeJson(book ? book->getTitle() : "") << "\",";
+            ss << "\"estimatedBorrows\":" << hitters[i].count << ",";
+            ss << "\"maxOvercount\":" << hitters[i].error;
+            ss << "}";
+            if (i < hitters.size() - 1) ss << ",";
+        }
+        ss << "]";
+
+        return HttpResponse::ok(
+            JsonHelper::createSuccessResponse(
+                ss.str(),
+                "Retrieved " + to_string(hitters.size()) + " heavy hitters"
+            )
+        );
+
+    } catch (const exception& e) {
+        return HttpResponse::serverError(
+            JsonHelper::createErrorResponse("Failed to retrieve heavy hitters: " + string(e.what()))
+        );
+    }
+}
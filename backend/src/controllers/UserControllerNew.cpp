@@ -131,6 +131,9 @@ HttpResponse UserController::createUser(const HttpRequest& req) {
         }
 
         static int nextUserID = 1;
+        while (library->findUserByID(nextUserID)) {
+            nextUserID++;
+        }
         int newUserID = nextUserID++;
 
         User newUser(newUserID, name, email, role);
@@ -245,7 +248,7 @@ HttpResponse UserController::getBorrowedBooks(const HttpRequest& req) {
             );
         }
 
-        const vector<int> borrowedBookIDs = user->getBorrowedBookIDs();
+        const vector<int>& borrowedBookIDs = user->getBorrowedBookIDs();
 
         stringstream ss;
         ss << "[";
@@ -259,7 +262,12 @@ HttpResponse UserController::getBorrowedBooks(const HttpRequest& req) {
                 ss << "\"bookID\":" << book->getBookID() << ",";
                 ss << "\"title\":\"" << JsonHelper::escapeJson(book->getTitle()) << "\",";
                 ss << "\"author\":\"" << JsonHelper::escapeJson(book->getAuthor()) << "\",";
-                ss << "\"category\":\"" << JsonHelper::escapeJson(book->getCategory()) << "\"";
+                ss << "\"category\":\"" << JsonHelper::escapeJson(book->getCategory()) << "\",";
+
+                time_t dueAt = 0;
+                library->getLoanDueDate(userId, bookId, dueAt);
+                ss << "\"dueAt\":" << dueAt << ",";
+                ss << "\"overdue\":" << (library->isLoanOverdue(userId, bookId) ? "true" : "false");
                 ss << "}";
 
                 count++;
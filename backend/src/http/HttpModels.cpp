@@ -1,10 +1,11 @@
 #include "../../include/http/HttpModels.h"
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
 
-HttpRequest::HttpRequest() : method(HttpMethod::GET), path("/") {}
+HttpRequest::HttpRequest() : method(HttpMethod::GET), path("/"), bodyConsumed(0) {}
 
-HttpRequest::HttpRequest(HttpMethod m, const string& p) : method(m), path(p) {}
+HttpRequest::HttpRequest(HttpMethod m, const string& p) : method(m), path(p), bodyConsumed(0) {}
 
 HttpMethod HttpRequest::getMethod() const { return method; }
 string HttpRequest::getPath() const { return path; }
@@ -32,11 +33,32 @@ void HttpRequest::setHeader(const string& key, const string& value) { headers[ke
 void HttpRequest::setQueryParam(const string& key, const string& value) { queryParams[key] = value; }
 void HttpRequest::setPathParam(const string& key, const string& value) { pathParams[key] = value; }
 void HttpRequest::setBody(const string& b) { body = b; }
+void HttpRequest::setBodyReader(function<size_t(char*, size_t)> reader) { bodyReader = reader; }
+
+size_t HttpRequest::readBody(char* buffer, size_t size) const {
+    if (bodyReader) return bodyReader(buffer, size);
+    size_t n = min(size, body.size() - bodyConsumed);
+    body.copy(buffer, n, bodyConsumed);
+    bodyConsumed += n;
+    return n;
+}
 
 bool HttpRequest::hasQueryParam(const string& key) const {
     return queryParams.find(key) != queryParams.end();
 }
 
+bool HttpRequest::getLimitParam(const string& key, int fallback, int max, int& out) const {
+    string text = getQueryParam(key);
+    if (text.empty()) {
+        out = fallback;
+        return true;
+    }
+    if (text.find_first_not_of("0123456789") != string::npos) return false;
+    if (text.find_first_not_of('0') == string::npos) return false;
+    out = text.size() > 9 ? max : std::min(stoi(text), max);
+    return true;
+}
+
 bool HttpRequest::hasPathParam(const string& key) const {
     return pathParams.find(key) != pathParams.end();
 }
@@ -103,6 +125,18 @@ HttpResponse HttpResponse::notFound(const string& message) {
     return response;
 }
 
+HttpResponse HttpResponse::lengthRequired(const string& message) {
+    HttpResponse response(HttpStatus::LENGTH_REQUIRED);
+    response.setBody(JsonHelper::createErrorResponse(message, "LENGTH_REQUIRED"));
+    return response;
+}
+
+HttpResponse HttpResponse::payloadTooLarge(const string& message) {
+    HttpResponse response(HttpStatus::PAYLOAD_TOO_LARGE);
+    response.setBody(JsonHelper::createErrorResponse(message, "PAYLOAD_TOO_LARGE"));
+    return response;
+}
+
 HttpResponse HttpResponse::serverError(const string& message) {
     HttpResponse response(HttpStatus::INTERNAL_SERVER_ERROR);
     response.setBody(JsonHelper::createErrorResponse(message, "SERVER_ERROR"));
@@ -4,16 +4,29 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <cstring>
 #include <cerrno>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
 
 using std::string;
 
 HttpServer::HttpServer(Router& r, int p) : router(r), port(p) {}
 HttpServer::~HttpServer() {}
 
+void HttpServer::setAfterRequestHook(std::function<void()> hook) {
+    afterRequest = hook;
+}
+
+void HttpServer::setBeforeRespondHook(std::function<bool()> hook) {
+    beforeRespond = hook;
+}
+
 int HttpServer::createListenSocket() {
     int sock = ::socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
@@ -36,7 +49,10 @@ int HttpServer::createListenSocket() {
         ::close(sock);
         return -1;
     }
-    if (::listen(sock, 16) < 0) {
+    // Non-blocking, so a batch ends when no connection is waiting; accepted
+    // sockets do not inherit this
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    if (::listen(sock, 128) < 0) {
         std::cerr << "listen() failed: " << strerror(errno) << "\n";
         ::close(sock);
         return -1;
@@ -53,71 +69,112 @@ void HttpServer::start() {
     std::cout << "HTTP server listening on 0.0.0.0:" << port << "\n";
 
     while (true) {
-        sockaddr_in clientAddr{};
-        socklen_t len = sizeof(clientAddr);
-        int clientSock = accept(serverSock, (sockaddr*)&clientAddr, &len);
-        if (clientSock < 0) continue;
-        // Handle client in the same thread (simple, single-threaded)
-        handleClient(clientSock);
-        ::close(clientSock);
+        pollfd listening{serverSock, POLLIN, 0};
+        if (poll(&listening, 1, IDLE_HOOK_MS) == 0) {
+            if (afterRequest) afterRequest();
+            continue;
+        }
+
+        // Requests are handled one at a time on this thread, but the responses
+        // of all connections that were waiting go out together after
+        // beforeRespond, so their changes share one WAL fsync
+        struct Answer {
+            int sock;
+            bool pending;
+            HttpResponse res;
+        };
+        std::vector<Answer> batch;
+        while ((int)batch.size() < MAX_BATCH) {
+            sockaddr_in clientAddr{};
+            socklen_t len = sizeof(clientAddr);
+            int clientSock = accept(serverSock, (sockaddr*)&clientAddr, &len);
+            if (clientSock < 0) break;
+            Answer answer{clientSock, false, HttpResponse()};
+            answer.pending = handleClient(clientSock, answer.res);
+            batch.push_back(std::move(answer));
+        }
+        if (batch.empty()) continue;
+
+        bool durable = !beforeRespond || beforeRespond();
+        for (auto& answer : batch) {
+            if (answer.pending) {
+                if (!durable) answer.res = HttpResponse::serverError("Changes could not be made durable");
+                sendResponse(answer.sock, answer.res);
+            }
+            ::close(answer.sock);
+        }
+        if (afterRequest) afterRequest();
     }
 }
 
-static string readAll(int sock) {
+static const size_t MAX_HEAD_BYTES = 64 * 1024;
+
+// Reads up to the end of the headers. Body bytes that arrived with them are
+// left in `rest`.
+static bool readHead(int sock, string& head, string& rest) {
     char buffer[8192];
-    std::stringstream ss;
-    ssize_t n;
-    // Read until we think we have the full request headers
-    while ((n = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
-        ss.write(buffer, n);
-        // Heuristic: stop if we've seen end of headers and Content-Length satisfied
-        string data = ss.str();
-        auto pos = data.find("\r\n\r\n");
-        if (pos != string::npos) {
-            // Check content-length
-            auto clPos = data.find("Content-Length:");
-            if (clPos != string::npos) {
-                auto endLine = data.find("\r\n", clPos);
-                string clLine = data.substr(clPos, endLine - clPos);
-                int contentLength = 0;
-                try {
-                    contentLength = std::stoi(clLine.substr(clLine.find(":") + 1));
-                } catch (...) { contentLength = 0; }
-                size_t bodyStart = pos + 4;
-                if (data.size() >= bodyStart + (size_t)contentLength) break;
-            } else {
-                // No body
-                break;
-            }
-        }
-        if (n < (ssize_t)sizeof(buffer)) break;
+    string data;
+    size_t end;
+    while ((end = data.find("\r\n\r\n")) == string::npos) {
+        if (data.size() > MAX_HEAD_BYTES) return false;
+        ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        data.append(buffer, n);
     }
-    return ss.str();
+    head = data.substr(0, end + 4);
+    rest = data.substr(end + 4);
+    return true;
+}
+
+// Content-Length must be all digits; a missing header means no body. Values
+// of more than 18 digits come back as SIZE_MAX, which no route accepts.
+static bool parseContentLength(const string& text, size_t& out) {
+    out = 0;
+    if (text.empty()) return true;
+    if (text.find_first_not_of("0123456789") != string::npos) return false;
+    out = text.size() > 18 ? SIZE_MAX : static_cast<size_t>(std::stoull(text));
+    return true;
 }
 
-void HttpServer::handleClient(int clientSock) {
-    string raw = readAll(clientSock);
+// The rest of a request body: what arrived with the headers, then the socket.
+struct BodyStream {
+    int sock;
+    string buffered;
+    size_t offset;
+    size_t remaining;
+
+    size_t read(char* out, size_t size) {
+        size = std::min(size, remaining);
+        if (size == 0) return 0;
+        size_t n = 0;
+        if (offset < buffered.size()) {
+            n = buffered.copy(out, size, offset);
+            offset += n;
+        } else {
+            ssize_t got = recv(sock, out, size, 0);
+            n = got > 0 ? (size_t)got : 0;
+        }
+        // A closed connection ends the body early
+        remaining = n > 0 ? remaining - n : 0;
+        return n;
+    }
+};
+
+// Reads and routes one request. Returns false if the client has already been
+// answered (preflight, malformed or refused requests); otherwise the response
+// is left in `res` for the caller to send.
+bool HttpServer::handleClient(int clientSock, HttpResponse& res) {
+    string head, rest;
     HttpRequest req;
 
-    if (!parseRequest(raw, req)) {
-        HttpResponse res = HttpResponse::badRequest("Malformed HTTP request");
-        addCorsHeaders(res);
-        string out = res.toString();
-        // Ensure Content-Length
-        std::stringstream ss;
-        ss << "HTTP/1.1 " << res.getStatusCodeValue() << "\r\n";
-        ss << "Content-Length: " << res.getBody().size() << "\r\n";
-        ss << "Content-Type: application/json\r\n";
-        ss << "Access-Control-Allow-Origin: *\r\n\r\n";
-        ss << res.getBody();
-        ::send(clientSock, ss.str().c_str(), ss.str().size(), 0);
-        return;
+    if (!readHead(clientSock, head, rest) || !parseRequest(head, req)) {
+        HttpResponse refused = HttpResponse::badRequest("Malformed HTTP request");
+        sendResponse(clientSock, refused);
+        return false;
     }
 
     // Preflight CORS
     if (req.getMethod() == HttpMethod::OPTIONS) {
-        HttpResponse res(HttpStatus::NO_CONTENT);
-        addCorsHeaders(res);
         std::stringstream ss;
         ss << "HTTP/1.1 204\r\n";
         ss << "Access-Control-Allow-Origin: *\r\n";
@@ -125,10 +182,53 @@ void HttpServer::handleClient(int clientSock) {
         ss << "Access-Control-Allow-Headers: Content-Type\r\n";
         ss << "Content-Length: 0\r\n\r\n";
         ::send(clientSock, ss.str().c_str(), ss.str().size(), 0);
-        return;
+        return false;
+    }
+
+    // Streaming routes pull the body as they parse it; the rest get it whole,
+    // up to MAX_BODY_BYTES. Both are checked before the client sends it.
+    size_t contentLength = 0;
+    bool streaming = router.streamsBody(req.getMethod(), req.getPath());
+    // Only Content-Length framing is read; a chunked body would look empty
+    if (!req.getHeader("Transfer-Encoding").empty()) {
+        HttpResponse refused = HttpResponse::lengthRequired("Chunked uploads are not supported; send a Content-Length");
+        sendResponse(clientSock, refused);
+        return false;
+    }
+    if (!parseContentLength(req.getHeader("Content-Length"), contentLength)) {
+        HttpResponse refused = HttpResponse::badRequest("Invalid Content-Length");
+        sendResponse(clientSock, refused);
+        return false;
+    }
+    if (contentLength > MAX_BODY_BYTES && (!streaming || contentLength == SIZE_MAX)) {
+        HttpResponse refused = HttpResponse::payloadTooLarge(
+            streaming ? "Content-Length is too large"
+                      : "Request body is larger than " + std::to_string(MAX_BODY_BYTES) + " bytes");
+        sendResponse(clientSock, refused);
+        return false;
     }
 
-    HttpResponse res = router.handleRequest(req);
+    BodyStream body{clientSock, rest, 0, contentLength};
+    // Clients sending large uploads (curl among them) wait for this before the body
+    if (contentLength > 0 && req.getHeader("Expect") == "100-continue") {
+        static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        ::send(clientSock, CONTINUE, sizeof(CONTINUE) - 1, 0);
+    }
+    if (streaming) {
+        req.setBodyReader([&body](char* out, size_t size) { return body.read(out, size); });
+    } else if (contentLength > 0) {
+        // Grown as bytes arrive, so a client that stops short costs only what it sent
+        string whole;
+        char buffer[64 * 1024];
+        while (size_t n = body.read(buffer, sizeof(buffer))) whole.append(buffer, n);
+        req.setBody(whole);
+    }
+
+    res = router.handleRequest(req);
+    return true;
+}
+
+void HttpServer::sendResponse(int clientSock, HttpResponse& res) {
     addCorsHeaders(res);
 
     // Build raw HTTP response with Content-Length
@@ -177,9 +277,8 @@ bool HttpServer::parseRequest(const string& raw, HttpRequest& outReq) {
     }
     outReq.setPath(urlPath);
 
-    // Headers
+    // Headers; the body is read separately
     string headerLine;
-    size_t contentLength = 0;
     while (std::getline(ss, headerLine)) {
         if (!headerLine.empty() && headerLine.back() == '\r') headerLine.pop_back();
         if (headerLine.empty()) break; // end of headers
@@ -190,19 +289,9 @@ bool HttpServer::parseRequest(const string& raw, HttpRequest& outReq) {
             // trim leading spaces
             value.erase(0, value.find_first_not_of(" \t"));
             outReq.setHeader(key, value);
-            if (key == "Content-Length") {
-                try { contentLength = static_cast<size_t>(std::stoul(value)); } catch (...) {}
-            }
         }
     }
 
-    // Body
-    if (contentLength > 0) {
-        string body(contentLength, '\0');
-        ss.read(&body[0], contentLength);
-        outReq.setBody(body);
-    }
-
     return true;
 }
 
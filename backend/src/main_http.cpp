@@ -1,5 +1,6 @@
 #include <iostream>
 #include <string>
+#include <cstdlib>
 #include "../include/services/Library.h"
 #include "../include/api/Router.h"
 #include "../include/controllers/BookController.h"
@@ -8,6 +9,11 @@
 #include "../include/controllers/StatisticsController.h"
 #include "../include/http/HttpServer.h"
 #include "../include/utils/DataLoader.h"
+#include "../include/controllers/AdminController.h"
+#include "../include/storage/WriteAheadLog.h"
+#include "../include/storage/Snapshot.h"
+#include "../include/storage/CatalogSegment.h"
+#include "../include/services/CatalogWatcher.h"
 
 using namespace std;
 
@@ -34,6 +40,19 @@ static void seedSampleData(Library& library) {
     // No hardcoded users - users add themselves via the UI
 }
 
+static string envOrDefault(const char* name, const string& fallback) {
+    const char* value = getenv(name);
+    return (value && *value) ? string(value) : fallback;
+}
+
+// LIBRARY_WAL_SYNC: always | interval (default) | none
+// LIBRARY_WAL_INTERVAL_MS: fsync period for interval mode
+static WalOptions walOptionsFromEnv() {
+    string mode = envOrDefault("LIBRARY_WAL_SYNC", "interval");
+    int intervalMs = atoi(envOrDefault("LIBRARY_WAL_INTERVAL_MS", "10").c_str());
+    return WalOptions::parse(mode, intervalMs);
+}
+
 static void registerRoutes(Router& router, Library& library,
                            BookController& bookController,
                            UserController& userController,
@@ -42,8 +61,10 @@ static void registerRoutes(Router& router, Library& library,
     // Book routes
     router.get("/books", [&](const HttpRequest& req) { return bookController.getAllBooks(req); });
     router.get("/books/search", [&](const HttpRequest& req) { return bookController.searchBooks(req); });  // MUST be before :id
+    router.get("/books/suggest", [&](const HttpRequest& req) { return bookController.suggestBooks(req); });
     router.get("/books/:id", [&](const HttpRequest& req) { return bookController.getBookById(req); });
     router.post("/books", [&](const HttpRequest& req) { return bookController.createBook(req); });
+    router.postStream("/books/bulk", [&](const HttpRequest& req) { return bookController.bulkImport(req); });
     router.put("/books/:id", [&](const HttpRequest& req) { return bookController.updateBook(req); });
     router.del("/books/:id", [&](const HttpRequest& req) { return bookController.deleteBook(req); });
 
@@ -60,24 +81,82 @@ static void registerRoutes(Router& router, Library& library,
     router.post("/borrow", [&](const HttpRequest& req) { return borrowController.borrowBook(req); });
     router.post("/return", [&](const HttpRequest& req) { return borrowController.returnBook(req); });
     router.get("/books/:id/history", [&](const HttpRequest& req) { return borrowController.getBorrowHistory(req); });
+    router.get("/books/:id/borrowers", [&](const HttpRequest& req) { return borrowController.getBookBorrowers(req); });
+    router.get("/books/:id/recommendations", [&](const HttpRequest& req) { return bookController.getRecommendations(req); });
+    router.get("/overdue", [&](const HttpRequest& req) { return borrowController.getOverdueLoans(req); });
 
     // Stats routes
     router.get("/dashboard", [&](const HttpRequest& req) { return statsController.getDashboard(req); });
     router.get("/statistics/most-borrowed", [&](const HttpRequest& req) { return statsController.getMostBorrowedBooks(req); });
     router.get("/statistics/most-active",  [&](const HttpRequest& req) { return statsController.getMostActiveUsers(req); });
     router.get("/statistics/category-distribution", [&](const HttpRequest& req) { return statsController.getCategoryDistribution(req); });
+    router.get("/statistics/approx/borrows", [&](const HttpRequest& req) { return statsController.getApproxBorrows(req); });
+    router.get("/statistics/approx/unique-borrowers", [&](const HttpRequest& req) { return statsController.getApproxUniqueBorrowers(req); });
+    router.get("/statistics/windows", [&](const HttpRequest& req) { return statsController.getWindowedCounts(req); });
+    router.get("/statistics/approx/heavy-hitters", [&](const HttpRequest& req) { return statsController.getApproxHeavyHitters(req); });
+}
+
+// LIBRARY_INGEST_THREADS: parser threads for JSON catalog loads (0 = one per core)
+static int ingestThreadsFromEnv() {
+    return atoi(envOrDefault("LIBRARY_INGEST_THREADS", "0").c_str());
+}
+
+// --compile-catalog <input.json> <output>: builds an mmap-able catalog segment
+static int compileCatalog(const string& input, const string& output) {
+    Library staging;
+    if (!DataLoader::loadFromFileParallel(staging, input, ingestThreadsFromEnv())) {
+        return 1;
+    }
+    if (!CatalogSegment::build(staging.getAllBooks(), output)) {
+        return 1;
+    }
+    cout << "Compiled " << staging.getTotalBooks() << " books into " << output << "\n";
+    return 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc == 4 && string(argv[1]) == "--compile-catalog") {
+        return compileCatalog(argv[2], argv[3]);
+    }
+
     printBanner();
     Library library;
     
-    // Try to load from JSON file first, fall back to sample data if file not found
-    if (!DataLoader::loadFromFile(library, "library_data.json")) {
+    WriteAheadLog wal(envOrDefault("LIBRARY_WAL_PATH", "library.wal"), walOptionsFromEnv());
+    SnapshotManager snapshots(library, &wal,
+                              envOrDefault("LIBRARY_SNAPSHOT_PATH", "library.snapshot"),
+                              atoi(envOrDefault("LIBRARY_SNAPSHOT_INTERVAL_S", "300").c_str()));
+
+    // A compiled catalog segment, when configured, is mapped as the read-only base
+    string catalogPath = envOrDefault("LIBRARY_CATALOG_PATH", "");
+    bool haveCatalog = !catalogPath.empty() && library.attachCatalog(catalogPath);
+    if (haveCatalog) {
+        cout << "Mapped catalog segment " << catalogPath << ": " << library.getTotalBooks() << " books\n";
+    }
+
+    // Prefer the binary snapshot; fall back to the JSON catalog, then sample data
+    SnapshotInfo snapshot;
+    if (snapshots.restore(&snapshot)) {
+        cout << "Loaded snapshot " << snapshots.getPath() << ": " << snapshot.books << " books, "
+             << snapshot.users << " users (WAL LSN " << snapshot.walLsn << ")\n";
+    } else if (haveCatalog) {
+        // The segment already provides the catalog
+    } else if (!DataLoader::loadFromFileParallel(library, "library_data.json", ingestThreadsFromEnv())) {
         cout << "Could not load library_data.json, using sample data instead...\n";
         seedSampleData(library);
     }
 
+    // Replay mutations made since the snapshot (or catalog load), then log new ones
+    if (wal.open()) {
+        int replayed = wal.replay(library, snapshots.getLastSnapshotLsn());
+        cout << "Replayed " << replayed << " operations from " << wal.getPath() << "\n";
+        library.setWriteAheadLog(&wal);
+    } else {
+        cout << "Write-ahead log unavailable, changes will not survive a restart\n";
+    }
+    // Loading and replay happened now, not when the events originally did
+    library.resetCirculationMetrics();
+
     Router router("/api/v1");
     
     // Create controllers that will live for the entire program
@@ -85,11 +164,49 @@ int main() {
     UserController userController(&library);
     BorrowController borrowController(&library);
     StatisticsController statsController(&library);
+    AdminController adminController(&snapshots);
     
     registerRoutes(router, library, bookController, userController, borrowController, statsController);
+    router.post("/admin/snapshot", [&](const HttpRequest& req) { return adminController.createSnapshot(req); });
     cout << "Registered routes: " << router.getRouteCount() << " under base path " << router.getBasePath() << "\n";
 
+    // LIBRARY_WATCH_CATALOG=0 turns off hot reload of library_data.json
+    CatalogWatcher catalogWatcher(library, "library_data.json", ingestThreadsFromEnv());
+    bool watching = !haveCatalog && envOrDefault("LIBRARY_WATCH_CATALOG", "1") != "0" && catalogWatcher.start();
+    if (watching) {
+        cout << "Watching library_data.json for changes\n";
+    }
+
     HttpServer server(router, 8080);
+    // In always mode, requests handled together share one fsync: appends only
+    // queue their records, and the batch's responses wait for the sync. A
+    // batch that logged nothing (reads, or writes refused by a failed log)
+    // has nothing to wait for.
+    uint64_t answeredLsn = wal.getLastLsn();
+    if (wal.getOptions().syncMode == WalSyncMode::EveryOperation) {
+        wal.setDeferredSync(true);
+        server.setBeforeRespondHook([&wal, &answeredLsn]() {
+            uint64_t last = wal.getLastLsn();
+            bool durable = last == answeredLsn || wal.sync();
+            answeredLsn = last;
+            return durable;
+        });
+    }
+    server.setAfterRequestHook([&snapshots, &library, &catalogWatcher, watching]() {
+        if (watching) {
+            CatalogReloadStats reload = catalogWatcher.applyPending();
+            if (reload.added + reload.changed + reload.removed > 0) {
+                cout << "Catalog reload: " << reload.added << " added, " << reload.changed << " changed, "
+                     << reload.removed << " removed";
+                if (reload.deferred > 0) cout << ", " << reload.deferred << " removals waiting on loans";
+                cout << "\n";
+                // Reloads bypass the WAL, so a snapshot is what keeps them across a restart
+                if (!snapshots.snapshotNow()) cerr << "Catalog reload: snapshot failed\n";
+            }
+        }
+        snapshots.maybeSnapshot();
+        library.processDueLoans(time(nullptr));
+    });
     cout << "Starting HTTP server...\n";
     server.start();
     return 0;
@@ -1,36 +1,71 @@
 #include "../../include/models/Book.h"
 
-Book::Book() : bookID(0), title(""), author(""), isbn(""), category(""), copies(0), availableCopies(0), coverImage(""), type("") {}
+Book::Book() : bookID(0), copies(0), availableCopies(0), category(StringPool::EMPTY), type(StringPool::EMPTY) {}
 
-Book::Book(int id, string t, string a, string i, string c, int cp, int av, string cover, string tp, vector<string> dl) {
+// Empty when s is already lowercase, so the common case stores no second copy.
+static string foldedKey(string_view s) {
+    string lower = TextUtils::toLower(s);
+    return lower == s ? string() : lower;
+}
+
+Book::Book(int id, string_view t, string_view a, string i, string_view c, int cp, int av, string cover, string_view tp, vector<string> dl) {
+    StringPool& pool = StringPool::shared();
     bookID = id;
-    title = t;
-    author = a;
-    isbn = i;
-    category = c;
     copies = cp;
     availableCopies = av;
-    coverImage = cover;
-    type = tp;
-    downloadLinks = dl;
+    text = make_shared<BookText>(BookText{string(t), foldedKey(t), SharedStringTable::authors().intern(a)});
+    category = pool.intern(c);
+    type = pool.intern(tp);
+
+    if (!i.empty() || !cover.empty() || !dl.empty()) {
+        details = make_shared<BookDetails>(BookDetails{move(i), move(cover), move(dl)});
+    }
+}
+
+const BookText& Book::getText() const {
+    static const BookText none;
+    return text ? *text : none;
+}
+
+const BookDetails& Book::getDetails() const {
+    static const BookDetails none;
+    return details ? *details : none;
 }
 
 void Book::printBook() const {
-    cout << "Book ID: " << bookID << ", Title: " << title
-         << ", Author: " << author << ", ISBN: " << isbn
+    cout << "Book ID: " << bookID << ", Title: " << getTitle()
+         << ", Author: " << getAuthor() << ", ISBN: " << getISBN()
          << ", Available: " << availableCopies << "/" << copies << endl;
 }
 
-string Book::getISBN() const { return isbn; }
+const string& Book::getISBN() const { return getDetails().isbn; }
 int Book::getBookID() const { return bookID; }
-string Book::getTitle() const { return title; }
-string Book::getAuthor() const { return author; }
-string Book::getCategory() const { return category; }
+const string& Book::getTitle() const { return getText().title; }
+const string& Book::getAuthor() const {
+    static const string none;
+    const auto& author = getText().author;
+    return author ? author->text : none;
+}
+const string& Book::getCategory() const { return StringPool::shared().str(category); }
 int Book::getCopies() const { return copies; }
 int Book::getAvailableCopies() const { return availableCopies; }
-string Book::getCoverImage() const { return coverImage; }
-string Book::getType() const { return type; }
-vector<string> Book::getDownloadLinks() const { return downloadLinks; }
+const string& Book::getCoverImage() const { return getDetails().coverImage; }
+const string& Book::getType() const { return StringPool::shared().str(type); }
+const vector<string>& Book::getDownloadLinks() const { return getDetails().downloadLinks; }
+
+const string& Book::getTitleKey() const {
+    const BookText& t = getText();
+    return t.titleKey.empty() ? t.title : t.titleKey;
+}
+
+const string& Book::getAuthorKey() const {
+    const auto& author = getText().author;
+    return author ? author->key() : getAuthor();
+}
+
+StringPool::Id Book::getCategoryId() const { return category; }
+StringPool::Id Book::getTypeId() const { return type; }
+SharedStringTable::Id Book::getAuthorId() const { return getText().author.get(); }
 
 void Book::setAvailableCopies(int count) {
     if (count >= 0 && count <= copies) {
@@ -54,11 +89,14 @@ bool Book::returnBook() {
     return false;
 }
 
+// Sort keys are lowercased once, when the book is built.
+static int compareKeys(const string& a, const string& b) {
+    int cmp = a.compare(b);
+    return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+}
+
 bool Book::operator<(const Book& other) const {
-    string t1 = title, t2 = other.title;
-    transform(t1.begin(), t1.end(), t1.begin(), ::tolower);
-    transform(t2.begin(), t2.end(), t2.begin(), ::tolower);
-    return t1 < t2;
+    return compareKeys(getTitleKey(), other.getTitleKey()) < 0;
 }
 
 bool Book::operator>(const Book& other) const {
@@ -66,10 +104,7 @@ bool Book::operator>(const Book& other) const {
 }
 
 bool Book::operator==(const Book& other) const {
-    string t1 = title, t2 = other.title;
-    transform(t1.begin(), t1.end(), t1.begin(), ::tolower);
-    transform(t2.begin(), t2.end(), t2.begin(), ::tolower);
-    return t1 == t2;
+    return getTitleKey() == other.getTitleKey();
 }
 
 bool Book::operator<=(const Book& other) const {
@@ -81,26 +116,16 @@ bool Book::operator>=(const Book& other) const {
 }
 
 int Book::compareByTitle(const Book& a, const Book& b) {
-    string t1 = a.title, t2 = b.title;
-    transform(t1.begin(), t1.end(), t1.begin(), ::tolower);
-    transform(t2.begin(), t2.end(), t2.begin(), ::tolower);
-    if (t1 < t2) return -1;
-    if (t1 > t2) return 1;
-    return 0;
+    return compareKeys(a.getTitleKey(), b.getTitleKey());
 }
 
 int Book::compareByAuthor(const Book& a, const Book& b) {
-    string a1 = a.author, a2 = b.author;
-    transform(a1.begin(), a1.end(), a1.begin(), ::tolower);
-    transform(a2.begin(), a2.end(), a2.begin(), ::tolower);
-    if (a1 < a2) return -1;
-    if (a1 > a2) return 1;
-    return 0;
+    return compareKeys(a.getAuthorKey(), b.getAuthorKey());
 }
 
 int Book::compareByISBN(const Book& a, const Book& b) {
-    if (a.isbn < b.isbn) return -1;
-    if (a.isbn > b.isbn) return 1;
+    if (a.getISBN() < b.getISBN()) return -1;
+    if (a.getISBN() > b.getISBN()) return 1;
     return 0;
 }
 
@@ -1,13 +1,13 @@
 #include "../../include/models/User.h"
 #include <algorithm>
 
-User::User() : userID(0), name(""), email(""), role(""), borrowedBooks(0) {}
+User::User() : userID(0), name(""), email(""), role(StringPool::EMPTY), borrowedBooks(0) {}
 
-User::User(int id, string n, string e, string r) {
+User::User(int id, string n, string e, string_view r) {
     userID = id;
-    name = n;
-    email = e;
-    role = r;
+    name = move(n);
+    email = move(e);
+    role = StringPool::shared().intern(r);
     borrowedBooks = 0;
 }
 
@@ -15,29 +15,31 @@ void User::printUser() const {
     cout << "User ID: " << userID
          << ", Name: " << name
          << ", Email: " << email
-         << ", Role: " << role
+         << ", Role: " << getRole()
          << ", Borrowed Books: " << borrowedBooks << endl;
 }
 
 int User::getUserID() const { return userID; }
 string User::getName() const { return name; }
 string User::getEmail() const { return email; }
-string User::getRole() const { return role; }
+const string& User::getRole() const { return StringPool::shared().str(role); }
+StringPool::Id User::getRoleId() const { return role; }
 int User::getBorrowedBooksCount() const { return borrowedBooks; }
-vector<int> User::getBorrowedBookIDs() const { return borrowedBookIDs; }
+const vector<int>& User::getBorrowedBookIDs() const { return borrowedBookIDs; }
 
 bool User::borrowBook(int bookID) {
-    if (!hasBorrowedBook(bookID)) {
-        borrowedBookIDs.push_back(bookID);
-        borrowedBooks++;
-        return true;
+    auto it = lower_bound(borrowedBookIDs.begin(), borrowedBookIDs.end(), bookID);
+    if (it != borrowedBookIDs.end() && *it == bookID) {
+        return false;
     }
-    return false;
+    borrowedBookIDs.insert(it, bookID);
+    borrowedBooks++;
+    return true;
 }
 
 bool User::returnBook(int bookID) {
-    auto it = find(borrowedBookIDs.begin(), borrowedBookIDs.end(), bookID);
-    if (it != borrowedBookIDs.end()) {
+    auto it = lower_bound(borrowedBookIDs.begin(), borrowedBookIDs.end(), bookID);
+    if (it != borrowedBookIDs.end() && *it == bookID) {
         borrowedBookIDs.erase(it);
         borrowedBooks--;
         return true;
@@ -46,5 +48,5 @@ bool User::returnBook(int bookID) {
 }
 
 bool User::hasBorrowedBook(int bookID) const {
-    return find(borrowedBookIDs.begin(), borrowedBookIDs.end(), bookID) != borrowedBookIDs.end();
+    return binary_search(borrowedBookIDs.begin(), borrowedBookIDs.end(), bookID);
 }
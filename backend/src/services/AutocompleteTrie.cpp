@@ -0,0 +1,199 @@
+#include "../../include/services/AutocompleteTrie.h"
+#include "../../include/utils/TextUtils.h"
+#include <algorithm>
+#include <queue>
+
+AutocompleteTrie::AutocompleteTrie() : root(new Node()), keyCount(0) {}
+
+vector<AutocompleteTrie::Node*> AutocompleteTrie::pathTo(const string& key, bool create) {
+    vector<Node*> path{root.get()};
+    Node* node = root.get();
+    size_t pos = 0;
+
+    while (pos < key.size()) {
+        auto& children = node->children;
+        auto it = lower_bound(children.begin(), children.end(), key[pos],
+                              [](const unique_ptr<Node>& child, char c) { return child->label[0] < c; });
+
+        if (it == children.end() || (*it)->label[0] != key[pos]) {
+            if (!create) return {};
+            unique_ptr<Node> leaf(new Node());
+            leaf->label = key.substr(pos);
+            it = children.insert(it, move(leaf));
+            path.push_back(it->get());
+            return path;
+        }
+
+        Node* child = it->get();
+        size_t common = 0;
+        while (common < child->label.size() && pos + common < key.size() &&
+               child->label[common] == key[pos + common]) {
+            common++;
+        }
+
+        if (common < child->label.size()) {
+            if (!create) return {};
+            // Split the edge: child keeps the tail of its label under a new node
+            unique_ptr<Node> split(new Node());
+            split->label = child->label.substr(0, common);
+            child->label = child->label.substr(common);
+            split->best = child->best;
+            split->children.push_back(move(*it));
+            *it = move(split);
+            child = it->get();
+        }
+
+        path.push_back(child);
+        node = child;
+        pos += common;
+    }
+    return path;
+}
+
+void AutocompleteTrie::refreshBest(Node* node) {
+    long best = node->terminal ? node->weight : -1;
+    for (const auto& child : node->children) {
+        best = max(best, child->best);
+    }
+    node->best = best;
+}
+
+// Keeps the trie compressed after a removal: a non-terminal node with a
+// single child absorbs that child.
+void AutocompleteTrie::mergeWithOnlyChild(Node* node) {
+    if (node->terminal || node->children.size() != 1) return;
+
+    unique_ptr<Node> child = move(node->children[0]);
+    node->label += child->label;
+    node->children = move(child->children);
+    node->terminal = child->terminal;
+    node->display = move(child->display);
+    node->refs = child->refs;
+    node->weight = child->weight;
+    node->best = child->best;
+}
+
+void AutocompleteTrie::add(string_view text, long weight) {
+    string key = TextUtils::toLower(text);
+    if (key.empty()) return;
+
+    vector<Node*> path = pathTo(key, true);
+    Node* node = path.back();
+    if (!node->terminal) {
+        node->terminal = true;
+        node->display = string(text);
+        keyCount++;
+    }
+    node->refs++;
+    node->weight += weight;
+
+    for (auto it = path.rbegin(); it != path.rend(); ++it) refreshBest(*it);
+}
+
+void AutocompleteTrie::remove(string_view text, long weight) {
+    string key = TextUtils::toLower(text);
+    vector<Node*> path = key.empty() ? vector<Node*>() : pathTo(key, false);
+    if (path.empty() || !path.back()->terminal) return;
+
+    Node* node = path.back();
+    node->weight -= weight;
+    if (--node->refs <= 0) {
+        node->terminal = false;
+        node->display.clear();
+        node->weight = 0;
+        keyCount--;
+    }
+
+    // Prune empty leaves and re-compress on the way up
+    for (size_t i = path.size() - 1; i > 0; i--) {
+        Node* current = path[i];
+        Node* parent = path[i - 1];
+        if (!current->terminal && current->children.empty()) {
+            auto& siblings = parent->children;
+            siblings.erase(find_if(siblings.begin(), siblings.end(),
+                                   [current](const unique_ptr<Node>& n) { return n.get() == current; }));
+        } else {
+            mergeWithOnlyChild(current);
+            refreshBest(current);
+        }
+    }
+    refreshBest(root.get());
+}
+
+void AutocompleteTrie::addWeight(string_view text, long delta) {
+    string key = TextUtils::toLower(text);
+    vector<Node*> path = key.empty() ? vector<Node*>() : pathTo(key, false);
+    if (path.empty() || !path.back()->terminal) return;
+
+    path.back()->weight += delta;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) refreshBest(*it);
+}
+
+void AutocompleteTrie::clear() {
+    root.reset(new Node());
+    keyCount = 0;
+}
+
+int AutocompleteTrie::size() const {
+    return keyCount;
+}
+
+vector<Completion> AutocompleteTrie::complete(string_view prefix, int limit) const {
+    vector<Completion> results;
+    if (limit <= 0) return results;
+
+    string key = TextUtils::toLower(prefix);
+    const Node* node = root.get();
+    string nodePath;
+    size_t pos = 0;
+    while (pos < key.size()) {
+        const Node* next = nullptr;
+        for (const auto& child : node->children) {
+            if (child->label[0] == key[pos]) {
+                next = child.get();
+                break;
+            }
+        }
+        if (!next) return results;
+
+        size_t n = min(next->label.size(), key.size() - pos);
+        if (next->label.compare(0, n, key, pos, n) != 0) return results;
+        node = next;
+        nodePath += next->label;
+        pos += n;
+    }
+
+    // Best-first expansion. Entries are either subtrees (ranked by their best
+    // weight) or finished completions. Equal weights are broken by key: a
+    // subtree's path is a prefix of every key below it, so completions of the
+    // same weight still come out in alphabetical order.
+    struct Entry {
+        long priority;
+        string path;
+        const Node* node;
+        bool completion;
+    };
+    auto lower = [](const Entry& a, const Entry& b) {
+        if (a.priority != b.priority) return a.priority < b.priority;
+        return a.path > b.path;
+    };
+    priority_queue<Entry, vector<Entry>, decltype(lower)> frontier(lower);
+    if (node->best >= 0) frontier.push({node->best, nodePath, node, false});
+
+    while (!frontier.empty() && (int)results.size() < limit) {
+        Entry top = frontier.top();
+        frontier.pop();
+
+        if (top.completion) {
+            results.push_back({top.node->display, top.node->weight});
+            continue;
+        }
+        if (top.node->terminal) {
+            frontier.push({top.node->weight, top.path, top.node, true});
+        }
+        for (const auto& child : top.node->children) {
+            if (child->best >= 0) frontier.push({child->best, top.path + child->label, child.get(), false});
+        }
+    }
+    return results;
+}
@@ -0,0 +1,193 @@
+#include "../../include/services/CatalogWatcher.h"
+#include "../../include/utils/DataLoader.h"
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+uint64_t mix(uint64_t seed, uint64_t value) {
+    return (seed ^ value) * 0x100000001B3ull;
+}
+
+string directoryOf(const string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+string fileNameOf(const string& path) {
+    size_t slash = path.rfind('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+}
+
+CatalogWatcher::CatalogWatcher(Library& lib, const string& catalogPath, int ingestThreads)
+    : library(lib), path(catalogPath), threads(ingestThreads), baselined(false), hasPending(false), notifyFd(-1),
+      stopping(false) {}
+
+CatalogWatcher::~CatalogWatcher() {
+    stop();
+}
+
+uint64_t CatalogWatcher::fingerprint(const Book& b) {
+    hash<string_view> text;
+    uint64_t h = 0xCBF29CE484222325ull;
+    h = mix(h, (uint64_t)b.getCopies());
+    h = mix(h, (uint64_t)b.getAvailableCopies());
+    for (const string* field : {&b.getTitle(), &b.getAuthor(), &b.getISBN(), &b.getCategory(),
+                                &b.getCoverImage(), &b.getType()}) {
+        h = mix(h, text(*field));
+    }
+    return h;
+}
+
+bool CatalogWatcher::start() {
+    // The library may come from a snapshot older than the file; the first
+    // parse, on the watcher thread, diffs the file against it
+    fingerprints.clear();
+    for (Book b : library.getAllBooks()) {
+        // Copies on loan were taken off availableCopies; the file counts them
+        b.setAvailableCopies(b.getAvailableCopies() + (int)library.getBorrowers(b.getBookID()).size());
+        fingerprints[b.getBookID()] = fingerprint(b);
+    }
+    baselined = false;
+
+    // The directory is watched, not the file: editors and deploy tools often
+    // replace a file by renaming a new one over it
+    notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0 ||
+        inotify_add_watch(notifyFd, directoryOf(path).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        cerr << "Catalog watch: cannot watch " << path << ": " << strerror(errno) << "\n";
+        if (notifyFd >= 0) ::close(notifyFd);
+        notifyFd = -1;
+        return false;
+    }
+
+    stopping = false;
+    watcher = thread(&CatalogWatcher::watchLoop, this);
+    return true;
+}
+
+void CatalogWatcher::stop() {
+    stopping = true;
+    if (watcher.joinable()) watcher.join();
+    if (notifyFd >= 0) ::close(notifyFd);
+    notifyFd = -1;
+}
+
+void CatalogWatcher::watchLoop() {
+    const string name = fileNameOf(path);
+    alignas(inotify_event) char events[4096];
+    bool changed = false;
+
+    // Watching starts before this parse, so a rewrite during it is not missed
+    reload();
+
+    while (!stopping) {
+        // After a change, wait for the writer to go quiet before reading
+        pollfd watched{notifyFd, POLLIN, 0};
+        int ready = poll(&watched, 1, changed ? SETTLE_MS : 500);
+        if (ready == 0 && changed) {
+            changed = false;
+            reload();
+            continue;
+        }
+        if (ready <= 0) continue;
+
+        ssize_t n;
+        while ((n = read(notifyFd, events, sizeof(events))) > 0) {
+            for (char* p = events; p < events + n;) {
+                auto* event = (inotify_event*)p;
+                if (event->len > 0 && name == event->name) changed = true;
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+bool CatalogWatcher::reload() {
+    vector<Book> books;
+    vector<User> users;  // user records in the file are ignored; users are live state
+    if (!DataLoader::parseFileParallel(path, threads, books, users, DataLoader::BLOCK_SIZE, true)) {
+        cerr << "Catalog watch: keeping the current catalog, " << path << " did not parse\n";
+        return false;
+    }
+
+    unordered_map<int, uint64_t> latest;
+    latest.reserve(books.size());
+    unordered_map<int, optional<Book>> changes;
+    for (auto& b : books) {
+        uint64_t print = fingerprint(b);
+        latest[b.getBookID()] = print;
+        auto previous = fingerprints.find(b.getBookID());
+        if (previous == fingerprints.end() || previous->second != print) {
+            changes[b.getBookID()] = move(b);
+        }
+    }
+    if (baselined) {
+        for (const auto& entry : fingerprints) {
+            if (!latest.count(entry.first)) changes[entry.first] = nullopt;
+        }
+    }
+    fingerprints = move(latest);
+    baselined = true;
+
+    if (changes.empty()) return true;
+    lock_guard<mutex> guard(pendingLock);
+    for (auto& change : changes) {
+        pending[change.first] = move(change.second);
+    }
+    hasPending = true;
+    return true;
+}
+
+CatalogReloadStats CatalogWatcher::applyPending() {
+    CatalogReloadStats stats;
+    if (!hasPending) return stats;
+
+    unordered_map<int, optional<Book>> changes;
+    {
+        lock_guard<mutex> guard(pendingLock);
+        changes.swap(pending);
+        hasPending = false;
+    }
+
+    // The file, not the WAL, is the record of these changes: replaying them
+    // after a restart would put old versions on top of a newer file
+    WriteAheadLog* attached = library.getWriteAheadLog();
+    library.setWriteAheadLog(nullptr);
+
+    vector<int> onLoan;
+    for (auto& change : changes) {
+        int bookID = change.first;
+        bool exists = library.findBookByID(bookID) != nullptr;
+        if (change.second) {
+            library.replaceBook(*change.second);
+            (exists ? stats.changed : stats.added)++;
+        } else if (exists) {
+            if (library.removeBook(bookID)) {
+                stats.removed++;
+            } else if (!library.getBorrowers(bookID).empty()) {
+                onLoan.push_back(bookID);
+            }
+        }
+    }
+    library.setWriteAheadLog(attached);
+
+    // Removals of books on loan are retried once the copies come back,
+    // unless a newer version of the file brings the book back first
+    if (!onLoan.empty()) {
+        lock_guard<mutex> guard(pendingLock);
+        for (int bookID : onLoan) {
+            pending.emplace(bookID, nullopt);
+        }
+        hasPending = true;
+        stats.deferred = (int)onLoan.size();
+    }
+    return stats;
+}
@@ -0,0 +1,121 @@
+#include "../../include/services/CategoryIndex.h"
+#include <algorithm>
+
+namespace {
+
+struct ByName {
+    bool operator()(StringPool::Id a, StringPool::Id b) const {
+        const StringPool& pool = StringPool::shared();
+        return pool.str(a) < pool.str(b);
+    }
+};
+
+}
+
+CategoryIndex::CategoryIndex() : overall{StringPool::EMPTY, 0, 0, 0} {}
+
+void CategoryIndex::add(int bookID, StringPool::Id category, bool available) {
+    auto inserted = byCategory.try_emplace(category);
+    Entry& entry = inserted.first->second;
+    if (inserted.second) {
+        byFolded[StringPool::shared().folded(category)].push_back(category);
+        byName.insert(upper_bound(byName.begin(), byName.end(), category, ByName()), category);
+    }
+
+    entry.bookIDs.push_back(bookID);
+    overall.totalBooks++;
+    if (available) {
+        entry.available++;
+        overall.availableBooks++;
+    } else {
+        entry.borrowed++;
+        overall.borrowedBooks++;
+    }
+}
+
+void CategoryIndex::remove(int bookID, StringPool::Id category, bool available) {
+    auto it = byCategory.find(category);
+    if (it == byCategory.end()) return;
+
+    Entry& entry = it->second;
+    auto pos = find_if(entry.bookIDs.begin(), entry.bookIDs.end(), [bookID](int id) { return id == bookID; });
+    if (pos == entry.bookIDs.end()) return;
+
+    *pos = entry.bookIDs.back();
+    entry.bookIDs.pop_back();
+    overall.totalBooks--;
+    if (available) {
+        entry.available--;
+        overall.availableBooks--;
+    } else {
+        entry.borrowed--;
+        overall.borrowedBooks--;
+    }
+
+    if (entry.bookIDs.empty()) {
+        byCategory.erase(it);
+        byName.erase(std::remove(byName.begin(), byName.end(), category), byName.end());
+        auto& spellings = byFolded[StringPool::shared().folded(category)];
+        spellings.erase(std::remove(spellings.begin(), spellings.end(), category), spellings.end());
+        if (spellings.empty()) {
+            byFolded.erase(StringPool::shared().folded(category));
+        }
+    }
+}
+
+void CategoryIndex::setAvailable(StringPool::Id category, bool wasAvailable, bool isAvailable) {
+    if (wasAvailable == isAvailable) return;
+
+    auto it = byCategory.find(category);
+    if (it == byCategory.end()) return;
+
+    int delta = isAvailable ? 1 : -1;
+    it->second.available += delta;
+    it->second.borrowed -= delta;
+    overall.availableBooks += delta;
+    overall.borrowedBooks -= delta;
+}
+
+void CategoryIndex::clear() {
+    byCategory.clear();
+    byFolded.clear();
+    byName.clear();
+    overall = {StringPool::EMPTY, 0, 0, 0};
+}
+
+vector<int> CategoryIndex::find(StringPool::Id foldedCategory) const {
+    vector<int> result;
+    auto spellings = byFolded.find(foldedCategory);
+    if (spellings == byFolded.end()) return result;
+
+    for (StringPool::Id category : spellings->second) {
+        const vector<int>& ids = byCategory.at(category).bookIDs;
+        result.insert(result.end(), ids.begin(), ids.end());
+    }
+    return result;
+}
+
+size_t CategoryIndex::count(StringPool::Id foldedCategory) const {
+    size_t total = 0;
+    auto spellings = byFolded.find(foldedCategory);
+    if (spellings == byFolded.end()) return total;
+
+    for (StringPool::Id category : spellings->second) {
+        total += byCategory.at(category).bookIDs.size();
+    }
+    return total;
+}
+
+vector<CategoryStats> CategoryIndex::stats() const {
+    vector<CategoryStats> result;
+    result.reserve(byName.size());
+    for (StringPool::Id category : byName) {
+        const Entry& e = byCategory.at(category);
+        result.push_back({category, (int)e.bookIDs.size(), e.available, e.borrowed});
+    }
+    return result;
+}
+
+const CategoryStats& CategoryIndex::totals() const {
+    return overall;
+}
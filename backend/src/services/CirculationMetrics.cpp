@@ -0,0 +1,68 @@
+#include "../../include/services/CirculationMetrics.h"
+#include <algorithm>
+
+void CirculationMetrics::Series::add(time_t now) {
+    minutes.add(now);
+    hours.add(now);
+    days.add(now);
+}
+
+const RollingCounter& CirculationMetrics::Series::at(MetricsResolution resolution) const {
+    switch (resolution) {
+        case MetricsResolution::Minute: return minutes;
+        case MetricsResolution::Hour: return hours;
+        default: return days;
+    }
+}
+
+void CirculationMetrics::Series::clear() {
+    minutes.clear();
+    hours.clear();
+    days.clear();
+}
+
+void CirculationMetrics::record(CirculationEvent event, StringPool::Id category, time_t now) {
+    global[(int)event].add(now);
+
+    if (event == CirculationEvent::Registration) return;
+    auto& byCategory = event == CirculationEvent::Borrow ? borrowsByCategory : returnsByCategory;
+    byCategory[StringPool::shared().folded(category)].add(now);
+}
+
+void CirculationMetrics::clear() {
+    for (auto& series : global) {
+        series.clear();
+    }
+    borrowsByCategory.clear();
+    returnsByCategory.clear();
+}
+
+vector<uint32_t> CirculationMetrics::recent(CirculationEvent event, MetricsResolution resolution, int windows,
+                                            time_t now, StringPool::Id foldedCategory) const {
+    if (foldedCategory == StringPool::EMPTY || event == CirculationEvent::Registration) {
+        return global[(int)event].at(resolution).recent(now, windows);
+    }
+
+    const auto& byCategory = event == CirculationEvent::Borrow ? borrowsByCategory : returnsByCategory;
+    auto it = byCategory.find(foldedCategory);
+    if (it == byCategory.end()) {
+        return vector<uint32_t>(min(windows, maxWindows(resolution)), 0);
+    }
+    return it->second.at(resolution).recent(now, windows);
+}
+
+int CirculationMetrics::windowSeconds(MetricsResolution resolution) {
+    switch (resolution) {
+        case MetricsResolution::Minute: return 60;
+        case MetricsResolution::Hour: return 3600;
+        default: return 86400;
+    }
+}
+
+int CirculationMetrics::maxWindows(MetricsResolution resolution) {
+    switch (resolution) {
+        case MetricsResolution::Minute: return 60;
+        case MetricsResolution::Hour: return 48;
+        default: return 90;
+    }
+}
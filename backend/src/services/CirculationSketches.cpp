@@ -0,0 +1,42 @@
+#include "../../include/services/CirculationSketches.h"
+
+CirculationSketches::CirculationSketches() : borrowFrequency(2048, 4), popularBooks(64) {}
+
+void CirculationSketches::recordBorrow(int bookID, int userID, StringPool::Id category) {
+    borrowFrequency.add((uint64_t)bookID);
+    optional<int> evicted = popularBooks.offer(bookID);
+    if (evicted) borrowersByBook.erase(*evicted);
+    borrowersByBook.try_emplace(bookID, BOOK_PRECISION).first->second.add((uint64_t)userID);
+
+    StringPool::Id folded = StringPool::shared().folded(category);
+    borrowersByCategory.try_emplace(folded, CATEGORY_PRECISION).first->second.add((uint64_t)userID);
+}
+
+void CirculationSketches::clear() {
+    borrowFrequency.clear();
+    popularBooks.clear();
+    borrowersByBook.clear();
+    borrowersByCategory.clear();
+}
+
+uint64_t CirculationSketches::totalBorrows() const {
+    return borrowFrequency.getTotal();
+}
+
+uint32_t CirculationSketches::estimateBorrows(int bookID) const {
+    return borrowFrequency.estimate((uint64_t)bookID);
+}
+
+double CirculationSketches::estimateBorrowers(int bookID) const {
+    auto it = borrowersByBook.find(bookID);
+    return it == borrowersByBook.end() ? 0 : it->second.estimate();
+}
+
+double CirculationSketches::estimateCategoryBorrowers(StringPool::Id foldedCategory) const {
+    auto it = borrowersByCategory.find(foldedCategory);
+    return it == borrowersByCategory.end() ? 0 : it->second.estimate();
+}
+
+vector<HeavyHitter<int>> CirculationSketches::mostBorrowed(int limit) const {
+    return popularBooks.top(limit);
+}
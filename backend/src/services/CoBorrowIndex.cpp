@@ -0,0 +1,37 @@
+#include "../../include/services/CoBorrowIndex.h"
+
+SpaceSaving<int>& CoBorrowIndex::neighborsOf(int bookID) {
+    return neighbors.try_emplace(bookID, NEIGHBORS).first->second;
+}
+
+void CoBorrowIndex::recordBorrow(int bookID, const vector<int>& otherLoans) {
+    for (int other : otherLoans) {
+        if (other == bookID) continue;
+        neighborsOf(bookID).offer(other);
+        neighborsOf(other).offer(bookID);
+    }
+}
+
+void CoBorrowIndex::removeBook(int bookID) {
+    auto it = neighbors.find(bookID);
+    if (it == neighbors.end()) return;
+    for (const auto& partner : it->second.top(NEIGHBORS)) {
+        auto other = neighbors.find(partner.key);
+        if (other != neighbors.end()) other->second.erase(bookID);
+    }
+    neighbors.erase(it);
+}
+
+void CoBorrowIndex::clear() {
+    neighbors.clear();
+}
+
+vector<HeavyHitter<int>> CoBorrowIndex::recommend(int bookID, int limit) const {
+    auto it = neighbors.find(bookID);
+    if (it == neighbors.end()) return vector<HeavyHitter<int>>();
+    return it->second.top(limit);
+}
+
+int CoBorrowIndex::maxRecommendations() {
+    return NEIGHBORS;
+}
@@ -0,0 +1,246 @@
+#include "../../include/services/FullTextIndex.h"
+#include "../../include/utils/TextUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+const double FullTextIndex::K1 = 1.2;
+const double FullTextIndex::B = 0.75;
+
+namespace {
+
+const uint32_t END_OF_LIST = UINT32_MAX;
+const size_t MIN_DOCS_BEFORE_COMPACTION = 1024;
+
+bool isTokenByte(unsigned char c) {
+    return isalnum(c) || c >= 0x80;
+}
+
+// Orders heap entries so the weakest result is on top: lower score first,
+// and on equal scores the higher book ID.
+struct WeakerFirst {
+    bool operator()(const ScoredBook& a, const ScoredBook& b) const {
+        if (a.score != b.score) return a.score > b.score;
+        return a.bookID < b.bookID;
+    }
+};
+
+}
+
+FullTextIndex::FullTextIndex() : liveDocs(0), liveLength(0) {}
+
+vector<string> FullTextIndex::tokenize(string_view text) {
+    vector<string> tokens;
+    string current;
+    for (char c : text) {
+        if (isTokenByte((unsigned char)c)) {
+            current.push_back(TextUtils::fold(c));
+        } else if (!current.empty()) {
+            tokens.push_back(move(current));
+            current.clear();
+        }
+    }
+    if (!current.empty()) tokens.push_back(move(current));
+    return tokens;
+}
+
+void FullTextIndex::add(int bookID, string_view text) {
+    auto existing = docOfBook.find(bookID);
+    if (existing != docOfBook.end()) {
+        // Caller did not remove the old text; drop the document so it is not
+        // returned twice (its terms' document counts stay slightly high).
+        Document& old = docs[existing->second];
+        old.alive = false;
+        liveDocs--;
+        liveLength -= old.length;
+    }
+
+    vector<string> tokens = tokenize(text);
+    sort(tokens.begin(), tokens.end());
+
+    uint32_t doc = (uint32_t)docs.size();
+    docs.push_back({bookID, (uint32_t)tokens.size(), true});
+    docOfBook[bookID] = doc;
+    liveDocs++;
+    liveLength += tokens.size();
+
+    for (size_t i = 0; i < tokens.size();) {
+        size_t j = i;
+        while (j < tokens.size() && tokens[j] == tokens[i]) j++;
+        uint32_t tf = (uint32_t)(j - i);
+
+        auto inserted = termIds.emplace(tokens[i], (uint32_t)terms.size());
+        if (inserted.second) terms.emplace_back();
+        Term& term = terms[inserted.first->second];
+        term.postings.push_back({doc, tf});
+        term.liveDocs++;
+        term.maxTf = max(term.maxTf, tf);
+        i = j;
+    }
+}
+
+void FullTextIndex::remove(int bookID, string_view text) {
+    auto it = docOfBook.find(bookID);
+    if (it == docOfBook.end()) return;
+
+    Document& doc = docs[it->second];
+    doc.alive = false;
+    liveDocs--;
+    liveLength -= doc.length;
+    docOfBook.erase(it);
+
+    vector<string> tokens = tokenize(text);
+    sort(tokens.begin(), tokens.end());
+    tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+    for (const auto& token : tokens) {
+        auto term = termIds.find(token);
+        if (term != termIds.end()) terms[term->second].liveDocs--;
+    }
+
+    size_t dead = docs.size() - liveDocs;
+    if (dead > MIN_DOCS_BEFORE_COMPACTION && dead > (size_t)liveDocs) {
+        compact();
+    }
+}
+
+// Drops tombstoned documents and renumbers the rest. The renumbering keeps
+// relative order, so posting lists remain sorted.
+void FullTextIndex::compact() {
+    vector<uint32_t> renumbered(docs.size(), END_OF_LIST);
+    vector<Document> kept;
+    kept.reserve(liveDocs);
+    for (size_t doc = 0; doc < docs.size(); doc++) {
+        if (!docs[doc].alive) continue;
+        renumbered[doc] = (uint32_t)kept.size();
+        kept.push_back(docs[doc]);
+    }
+
+    for (auto& term : terms) {
+        vector<Posting> postings;
+        uint32_t maxTf = 0;
+        for (const auto& posting : term.postings) {
+            if (renumbered[posting.doc] == END_OF_LIST) continue;
+            postings.push_back({renumbered[posting.doc], posting.tf});
+            maxTf = max(maxTf, posting.tf);
+        }
+        term.postings.swap(postings);
+        term.maxTf = maxTf;
+    }
+
+    docs.swap(kept);
+    docOfBook.clear();
+    for (size_t doc = 0; doc < docs.size(); doc++) {
+        docOfBook[docs[doc].bookID] = (uint32_t)doc;
+    }
+}
+
+void FullTextIndex::clear() {
+    termIds.clear();
+    terms.clear();
+    docs.clear();
+    docOfBook.clear();
+    liveDocs = 0;
+    liveLength = 0;
+}
+
+int FullTextIndex::size() const {
+    return liveDocs;
+}
+
+double FullTextIndex::idf(const Term& term) const {
+    double df = term.liveDocs;
+    return log(1.0 + (liveDocs - df + 0.5) / (df + 0.5));
+}
+
+// BM25's term score grows with tf and shrinks with document length, so the
+// term's largest tf in the shortest possible document bounds it.
+double FullTextIndex::upperBound(const Term& term) const {
+    double tf = term.maxTf;
+    return idf(term) * tf * (K1 + 1) / (tf + K1 * (1 - B));
+}
+
+vector<ScoredBook> FullTextIndex::search(const string& query, int k) const {
+    vector<ScoredBook> results;
+    if (k <= 0 || liveDocs == 0) return results;
+
+    struct Cursor {
+        const Term* term;
+        size_t pos;
+        double idf;
+        double bound;
+
+        uint32_t doc() const {
+            return pos < term->postings.size() ? term->postings[pos].doc : END_OF_LIST;
+        }
+    };
+
+    vector<string> tokens = tokenize(query);
+    sort(tokens.begin(), tokens.end());
+    tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+
+    vector<Cursor> cursors;
+    for (const auto& token : tokens) {
+        auto it = termIds.find(token);
+        if (it == termIds.end()) continue;
+        const Term& term = terms[it->second];
+        if (term.liveDocs <= 0) continue;
+        cursors.push_back({&term, 0, idf(term), upperBound(term)});
+    }
+
+    double avgLength = (double)liveLength / liveDocs;
+    priority_queue<ScoredBook, vector<ScoredBook>, WeakerFirst> best;
+
+    while (true) {
+        sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b) { return a.doc() < b.doc(); });
+
+        // Pivot: first cursor at which the summed bounds could beat the k-th score
+        double threshold = (int)best.size() == k ? best.top().score : 0.0;
+        double boundSum = 0;
+        size_t pivot = cursors.size();
+        for (size_t i = 0; i < cursors.size() && cursors[i].doc() != END_OF_LIST; i++) {
+            boundSum += cursors[i].bound;
+            if (boundSum >= threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == cursors.size()) break;
+
+        uint32_t pivotDoc = cursors[pivot].doc();
+        if (cursors[0].doc() == pivotDoc) {
+            const Document& doc = docs[pivotDoc];
+            double score = 0;
+            for (auto& cursor : cursors) {
+                if (cursor.doc() != pivotDoc) break;
+                double tf = cursor.term->postings[cursor.pos].tf;
+                score += cursor.idf * tf * (K1 + 1) / (tf + K1 * (1 - B + B * doc.length / avgLength));
+                cursor.pos++;
+            }
+
+            if (doc.alive) {
+                ScoredBook candidate{doc.bookID, score};
+                if ((int)best.size() < k) {
+                    best.push(candidate);
+                } else if (WeakerFirst()(candidate, best.top())) {
+                    best.pop();
+                    best.push(candidate);
+                }
+            }
+        } else {
+            // Nothing before the pivot can reach the threshold on its own: skip ahead
+            for (size_t i = 0; i < pivot; i++) {
+                const vector<Posting>& postings = cursors[i].term->postings;
+                auto next = lower_bound(postings.begin() + cursors[i].pos, postings.end(), pivotDoc,
+                                        [](const Posting& p, uint32_t target) { return p.doc < target; });
+                cursors[i].pos = next - postings.begin();
+            }
+        }
+    }
+
+    while (!best.empty()) {
+        results.push_back(best.top());
+        best.pop();
+    }
+    reverse(results.begin(), results.end());
+    return results;
+}
@@ -0,0 +1,146 @@
+#include "../../include/services/FuzzyTermIndex.h"
+#include "../../include/services/FullTextIndex.h"
+#include <algorithm>
+
+int FuzzyTermIndex::levenshtein(string_view a, string_view b) {
+    vector<int> previous(b.size() + 1), current(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) previous[j] = (int)j;
+
+    for (size_t i = 1; i <= a.size(); i++) {
+        current[0] = (int)i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            int substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            current[j] = min({previous[j] + 1, current[j - 1] + 1, substitution});
+        }
+        previous.swap(current);
+    }
+    return previous[b.size()];
+}
+
+int FuzzyTermIndex::allowedDistance(size_t wordLength, int maxDistance) {
+    int allowed = wordLength <= 2 ? 0 : (wordLength <= 5 ? 1 : 2);
+    return min(allowed, max(maxDistance, 0));
+}
+
+void FuzzyTermIndex::insertTerm(const string& term) {
+    if (tree.empty()) {
+        tree.push_back({term, {}});
+        return;
+    }
+
+    size_t node = 0;
+    while (true) {
+        int d = levenshtein(term, tree[node].term);
+        auto& children = tree[node].children;
+        auto child = find_if(children.begin(), children.end(), [d](const pair<int, int>& c) { return c.first == d; });
+        if (child == children.end()) {
+            children.push_back({d, (int)tree.size()});
+            tree.push_back({term, {}});
+            return;
+        }
+        node = child->second;
+    }
+}
+
+void FuzzyTermIndex::add(int bookID, string_view text) {
+    vector<string> words = FullTextIndex::tokenize(text);
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+
+    for (const auto& word : words) {
+        auto inserted = postings.try_emplace(word);
+        if (inserted.second) insertTerm(word);
+
+        batch.insert(inserted.first->second, bookID);
+    }
+}
+
+void FuzzyTermIndex::remove(int bookID, string_view text) {
+    batch.settle();
+    for (const auto& word : FullTextIndex::tokenize(text)) {
+        auto it = postings.find(word);
+        if (it == postings.end()) continue;
+
+        vector<int>& ids = it->second;
+        auto pos = lower_bound(ids.begin(), ids.end(), bookID);
+        if (pos != ids.end() && *pos == bookID) ids.erase(pos);
+    }
+}
+
+void FuzzyTermIndex::clear() {
+    batch.reset();
+    tree.clear();
+    postings.clear();
+}
+
+void FuzzyTermIndex::beginBatch() {
+    batch.begin();
+}
+
+void FuzzyTermIndex::endBatch() {
+    batch.end();
+}
+
+// BK-tree search: by the triangle inequality a match below a node at
+// distance d can only sit in children whose edge is within [d-k, d+k].
+void FuzzyTermIndex::termsWithin(const string& word, int maxDistance, vector<pair<const string*, int>>& out) const {
+    if (tree.empty()) return;
+
+    vector<int> pending{0};
+    while (!pending.empty()) {
+        const TreeNode& node = tree[pending.back()];
+        pending.pop_back();
+
+        int d = levenshtein(word, node.term);
+        if (d <= maxDistance) out.push_back({&node.term, d});
+
+        for (const auto& child : node.children) {
+            if (child.first >= d - maxDistance && child.first <= d + maxDistance) {
+                pending.push_back(child.second);
+            }
+        }
+    }
+}
+
+vector<FuzzyMatch> FuzzyTermIndex::search(string_view query, int maxDistance) const {
+    vector<FuzzyMatch> results;
+    vector<string> words = FullTextIndex::tokenize(query);
+    if (words.empty()) return results;
+
+    // Per query word: best distance of each book containing a close word
+    vector<unordered_map<int, int>> perWord;
+    for (const auto& word : words) {
+        vector<pair<const string*, int>> terms;
+        termsWithin(word, allowedDistance(word.size(), maxDistance), terms);
+
+        unordered_map<int, int> books;
+        for (const auto& term : terms) {
+            for (int bookID : postings.at(*term.first)) {
+                auto it = books.find(bookID);
+                if (it == books.end() || term.second < it->second) books[bookID] = term.second;
+            }
+        }
+        if (books.empty()) return results;
+        perWord.push_back(move(books));
+    }
+
+    // Intersect starting from the most selective word
+    sort(perWord.begin(), perWord.end(), [](const unordered_map<int, int>& a, const unordered_map<int, int>& b) {
+        return a.size() < b.size();
+    });
+    for (const auto& entry : perWord[0]) {
+        int total = entry.second;
+        bool everyWord = true;
+        for (size_t i = 1; i < perWord.size() && everyWord; i++) {
+            auto it = perWord[i].find(entry.first);
+            everyWord = it != perWord[i].end();
+            if (everyWord) total += it->second;
+        }
+        if (everyWord) results.push_back({entry.first, total});
+    }
+
+    sort(results.begin(), results.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.bookID < b.bookID;
+    });
+    return results;
+}
@@ -1,80 +1,607 @@
 #include "../../include/services/Library.h"
+#include "../../include/storage/WriteAheadLog.h"
+#include "../../include/storage/CatalogSegment.h"
+#include "../../include/utils/TextUtils.h"
 #include <iostream>
 #include <iomanip>
+#include <unordered_map>
+#include <stdexcept>
 using namespace std;
 
-Library::Library() {
+namespace {
 
-    booksByTitle = new BTree<Book>(3, Book::compareByTitle);
+// Changes are applied only once their record is in the write-ahead log.
+void requireLogged(uint64_t lsn) {
+    if (lsn == 0) throw runtime_error("Write-ahead log unavailable; change not applied");
+}
+
+}
+
+Library::Library() : catalog(nullptr), shadowedCount(0), outstandingLoans(0), indexesBuilt(true), wal(nullptr) {
+
+    booksByTitle = new BTree<int>(3, [this](const int& a, const int& b) {
+        int byTitle = Book::compareByTitle(books[a], books[b]);
+        return byTitle != 0 ? byTitle : Book::compareByID(books[a], books[b]);
+    });
 }
 
 Library::~Library() {
     delete booksByTitle;
+    delete catalog;
+}
+
+// Puts b into the heap layer, replacing any heap book with the same ID.
+int Library::storeBook(const Book& b) {
+    auto existing = bookSlots.find(b.getBookID());
+    if (existing.has_value()) {
+        int slot = existing.value();
+        updateIndexes(&books[slot], b);
+
+        booksByTitle->remove(slot);
+        books[slot] = b;
+        booksByTitle->insert(slot);
+        return slot;
+    }
+
+    int record = catalog ? catalog->findRecord(b.getBookID()) : -1;
+    if (record >= 0 && !shadowedRecords[record]) {
+        Book previous = catalog->toBook(record);
+        updateIndexes(&previous, b);
+    } else {
+        updateIndexes(nullptr, b);
+    }
+
+    int slot = (int)books.size();
+    books.push_back(b);
+    bookSlots.insert(b.getBookID(), slot);
+    booksByTitle->insert(slot);
+    markShadowed(b.getBookID());
+    return slot;
+}
+
+// Moves b's entries in the secondary indexes from `before` (null for a new
+// book) to `after`. Unchanged fields are left alone, so a copy-on-write of a
+// catalog record only touches availability.
+void Library::updateIndexes(const Book* before, const Book& after) {
+    int id = after.getBookID();
+    bool available = after.getAvailableCopies() > 0;
+
+    if (before && before->getCategoryId() == after.getCategoryId()) {
+        categories.setAvailable(after.getCategoryId(), before->getAvailableCopies() > 0, available);
+    } else {
+        if (before) categories.remove(id, before->getCategoryId(), before->getAvailableCopies() > 0);
+        categories.add(id, after.getCategoryId(), available);
+    }
+
+    if (indexesBuilt) updateTextIndexes(before, after);
+}
+
+void Library::updateTextIndexes(const Book* before, const Book& after) {
+    int id = after.getBookID();
+    long popularity = borrowCountOf(id);
+    bool titleChanged = !before || before->getTitle() != after.getTitle();
+    bool authorChanged = !before || before->getAuthorId() != after.getAuthorId();
+    if (titleChanged) {
+        if (before) {
+            titleTrigrams.remove(id, before->getTitleKey());
+            titleSuggestions.remove(before->getTitle(), popularity);
+            titleWords.remove(id, before->getTitleKey());
+        }
+        titleTrigrams.add(id, after.getTitleKey());
+        titleSuggestions.add(after.getTitle(), popularity);
+        titleWords.add(id, after.getTitleKey());
+    }
+    if (authorChanged) {
+        if (before) {
+            authorTrigrams.remove(id, before->getAuthorKey());
+            authorSuggestions.remove(before->getAuthor(), popularity);
+        }
+        authorTrigrams.add(id, after.getAuthorKey());
+        authorSuggestions.add(after.getAuthor(), popularity);
+    }
+
+    if (titleChanged || authorChanged || before->getCategoryId() != after.getCategoryId()) {
+        if (before) fullText.remove(id, searchableText(*before));
+        fullText.add(id, searchableText(after));
+    }
+}
+
+void Library::removeFromIndexes(const Book& b) {
+    int id = b.getBookID();
+    categories.remove(id, b.getCategoryId(), b.getAvailableCopies() > 0);
+    if (!indexesBuilt) return;
+
+    long popularity = borrowCountOf(id);
+    titleTrigrams.remove(id, b.getTitleKey());
+    titleSuggestions.remove(b.getTitle(), popularity);
+    titleWords.remove(id, b.getTitleKey());
+    authorTrigrams.remove(id, b.getAuthorKey());
+    authorSuggestions.remove(b.getAuthor(), popularity);
+    fullText.remove(id, searchableText(b));
+}
+
+int Library::borrowCountOf(int bookID) const {
+    return borrowCounts.find(bookID).value_or(0);
+}
+
+string Library::searchableText(const Book& b) {
+    return b.getTitle() + " " + b.getAuthor() + " " + b.getCategory();
+}
+
+// Heap slot for bookID, copying the catalog record into the overlay on the
+// first write. Returns -1 for unknown books.
+int Library::writableSlot(int bookID) {
+    auto slot = bookSlots.find(bookID);
+    if (slot.has_value()) {
+        return slot.value();
+    }
+
+    if (catalog) {
+        int record = catalog->findRecord(bookID);
+        if (record >= 0) {
+            return storeBook(catalog->toBook(record));
+        }
+    }
+    return -1;
+}
+
+void Library::markShadowed(int bookID) {
+    if (!catalog) return;
+
+    int record = catalog->findRecord(bookID);
+    if (record >= 0 && !shadowedRecords[record]) {
+        shadowedRecords[record] = true;
+        shadowedCount++;
+    }
+}
+
+// Rebuilds the category index, and with it the totals, from both layers. It
+// is a pass over integers and interned ids, so unlike the text indexes it is
+// done eagerly after every bulk load.
+void Library::rebuildCategories() {
+    categories.clear();
+    for (const auto& b : books) {
+        categories.add(b.getBookID(), b.getCategoryId(), b.getAvailableCopies() > 0);
+    }
+    if (!catalog) return;
+
+    // Segment strings are deduplicated, so each distinct category is interned once
+    StringPool& pool = StringPool::shared();
+    unordered_map<uint32_t, StringPool::Id> internedCategories;
+    for (size_t record = 0; record < catalog->size(); record++) {
+        if (shadowedRecords[record]) continue;
+
+        const CatalogRecord& rec = catalog->record(record);
+        auto cached = internedCategories.find(rec.category.offset);
+        if (cached == internedCategories.end()) {
+            cached = internedCategories.emplace(rec.category.offset, pool.intern(catalog->text(rec.category))).first;
+        }
+        categories.add(rec.bookID, cached->second, rec.availableCopies > 0);
+    }
+}
+
+// Rebuilds the text indexes from both layers after a bulk load.
+void Library::reindexBooks() {
+    indexesBuilt = true;
+    titleTrigrams.clear();
+    authorTrigrams.clear();
+    fullText.clear();
+    titleSuggestions.clear();
+    authorSuggestions.clear();
+    titleWords.clear();
+    beginIndexBatch();
+    for (const auto& b : books) {
+        updateTextIndexes(nullptr, b);
+    }
+
+    if (!catalog) {
+        endIndexBatch();
+        return;
+    }
+
+    for (size_t record = 0; record < catalog->size(); record++) {
+        if (shadowedRecords[record]) continue;
+
+        const CatalogRecord& rec = catalog->record(record);
+        string_view title = catalog->text(rec.title);
+        string_view author = catalog->text(rec.author);
+        string titleKey = TextUtils::toLower(title);
+        titleTrigrams.add(rec.bookID, titleKey);
+        titleWords.add(rec.bookID, titleKey);
+        authorTrigrams.add(rec.bookID, TextUtils::toLower(author));
+        fullText.add(rec.bookID, string(title) + " " + string(author) + " " + string(catalog->text(rec.category)));
+        titleSuggestions.add(title, borrowCountOf(rec.bookID));
+        authorSuggestions.add(author, borrowCountOf(rec.bookID));
+    }
+    endIndexBatch();
+}
+
+// Text indexes over a mapped catalog or a loaded snapshot are built on first
+// use rather than at startup, so a restart costs only the load. Until then
+// mutations skip their upkeep; the build reads the current books and counts.
+// The category index is kept current throughout (see rebuildCategories).
+void Library::invalidateIndexes() {
+    indexesBuilt = false;
+    titleTrigrams.clear();
+    authorTrigrams.clear();
+    fullText.clear();
+    titleSuggestions.clear();
+    authorSuggestions.clear();
+    titleWords.clear();
+}
+
+void Library::ensureIndexes() const {
+    // Logically const: the indexes are derived data
+    if (!indexesBuilt) const_cast<Library*>(this)->reindexBooks();
+}
+
+// Heap slots are not in ID order, so many books at once go through the
+// posting lists' batch mode instead of shifting them once per book.
+void Library::beginIndexBatch() {
+    titleTrigrams.beginBatch();
+    authorTrigrams.beginBatch();
+    titleWords.beginBatch();
+}
+
+void Library::endIndexBatch() {
+    titleTrigrams.endBatch();
+    authorTrigrams.endBatch();
+    titleWords.endBatch();
+}
+
+// Materializes the given books and returns those passing `keep`, in title order.
+vector<Book> Library::booksInTitleOrder(const vector<int>& bookIDs, const function<bool(const Book&)>& keep) {
+    vector<Book> results;
+    results.reserve(bookIDs.size());
+    for (int bookID : bookIDs) {
+        Book* book = findBookByID(bookID);
+        if (book && keep(*book)) results.push_back(*book);
+    }
+
+    sort(results.begin(), results.end(), [](const Book& a, const Book& b) {
+        int byTitle = Book::compareByTitle(a, b);
+        return byTitle != 0 ? byTitle < 0 : a.getBookID() < b.getBookID();
+    });
+    return results;
+}
+
+// Merges the heap overlay (B-tree order) with the catalog's prebuilt title
+// index. Catalog records are filtered on views into the mapping and only
+// matches are materialized.
+vector<Book> Library::collectBooks(const function<bool(const Book&)>& matchHeap,
+                                   const function<bool(const CatalogRecord&)>& matchRecord) const {
+    vector<Book> results;
+    vector<int> heapOrder = booksByTitle->getAllElements();
+    size_t catalogSize = catalog ? catalog->size() : 0;
+
+    size_t h = 0, rank = 0;
+    while (h < heapOrder.size() || rank < catalogSize) {
+        size_t record = 0;
+        if (rank < catalogSize) {
+            record = catalog->recordAtTitleRank(rank);
+            if (shadowedRecords[record]) {
+                rank++;
+                continue;
+            }
+        }
+
+        bool takeHeap = rank >= catalogSize;
+        if (!takeHeap && h < heapOrder.size()) {
+            const Book& heapBook = books[heapOrder[h]];
+            const CatalogRecord& rec = catalog->record(record);
+            int cmp = TextUtils::compareFolded(heapBook.getTitleKey(), catalog->text(rec.title));
+            takeHeap = cmp < 0 || (cmp == 0 && heapBook.getBookID() < rec.bookID);
+        }
+
+        if (takeHeap) {
+            const Book& b = books[heapOrder[h++]];
+            if (matchHeap(b)) {
+                results.push_back(b);
+            }
+        } else {
+            const CatalogRecord& rec = catalog->record(record);
+            if (matchRecord(rec)) {
+                results.push_back(catalog->toBook(record));
+            }
+            rank++;
+        }
+    }
+    return results;
 }
 
 void Library::addBook(const Book& b) {
-    booksByTitle->insert(b);
+    if (wal) requireLogged(wal->logAddBook(b));
+    storeBook(b);
     cout << "Book added: " << b.getTitle() << " by " << b.getAuthor() << endl;
 }
 
+// Bulk version of addBook for large imports: instead of one tree insert and
+// one update per secondary index for each book, the title tree is rebuilt
+// bottom-up from sorted slots and the indexes are rebuilt in a single pass.
+// A rebuild costs O(library), so batches that are small next to the library
+// (streamed imports) take the per-book path, which costs O(batch).
+void Library::addBooks(vector<Book> batch) {
+    if (batch.empty()) return;
+    // Logged as one write before any book is applied
+    if (wal) requireLogged(wal->logAddBooks(batch));
+
+    if (batch.size() * REBUILD_RATIO < (size_t)getTotalBooks()) {
+        beginIndexBatch();
+        for (const auto& b : batch) {
+            storeBook(b);
+        }
+        endIndexBatch();
+        return;
+    }
+
+    bookSlots.reserve((int)(books.size() + batch.size()));
+    for (auto& b : batch) {
+        int id = b.getBookID();
+        auto existing = bookSlots.find(id);
+        if (existing.has_value()) {
+            books[existing.value()] = move(b);
+        } else {
+            bookSlots.insert(id, (int)books.size());
+            books.push_back(move(b));
+        }
+        markShadowed(id);
+    }
+
+    vector<int> slots(books.size());
+    for (int slot = 0; slot < (int)slots.size(); slot++) slots[slot] = slot;
+    sort(slots.begin(), slots.end(), [this](int a, int b) {
+        int byTitle = Book::compareByTitle(books[a], books[b]);
+        return byTitle != 0 ? byTitle < 0 : Book::compareByID(books[a], books[b]) < 0;
+    });
+    booksByTitle->bulkLoad(slots);
+
+    rebuildCategories();
+    if (indexesBuilt) reindexBooks();
+}
+
+void Library::replaceBook(const Book& b) {
+    int onLoan = (int)getBorrowers(b.getBookID()).size();
+    int available = min(b.getAvailableCopies(), max(0, b.getCopies() - onLoan));
+    Book stored = b;
+    stored.setAvailableCopies(available);
+
+    if (wal) requireLogged(wal->logAddBook(stored));
+    storeBook(stored);
+}
+
+bool Library::removeBook(int bookID) {
+    auto slot = bookSlots.find(bookID);
+    if (!slot.has_value() || !getBorrowers(bookID).empty()) return false;
+    if (catalog && catalog->findRecord(bookID) >= 0) return false;
+
+    if (wal) requireLogged(wal->logRemoveBook(bookID));
+    int removed = slot.value();
+    int last = (int)books.size() - 1;
+    removeFromIndexes(books[removed]);
+    booksByTitle->remove(removed);
+
+    // The last book moves into the freed slot
+    if (removed != last) {
+        booksByTitle->remove(last);
+        books[removed] = move(books[last]);
+        bookSlots.insert(books[removed].getBookID(), removed);
+        booksByTitle->insert(removed);
+    }
+    books.pop_back();
+    bookSlots.remove(bookID);
+
+    // A later book with the same ID starts with no circulation history
+    borrowCounts.remove(bookID);
+    borrowRanking.erase(bookID);
+    coBorrows.removeBook(bookID);
+    return true;
+}
+
 void Library::printAllBooks() {
     cout << "\n ALL BOOKS \n";
-    booksByTitle->traverse([](const Book& b) {
+    for (const auto& b : getAllBooks()) {
         b.printBook();
-    });
+    }
     cout << "\n\n";
 }
 
+// Queries of at least three characters go through the trigram index and only
+// the candidates are verified; shorter ones fall back to a scan.
 vector<Book> Library::searchBookByTitle(const string& title) {
-    string searchLower = title;
-    transform(searchLower.begin(), searchLower.end(), searchLower.begin(), ::tolower);
+    ensureIndexes();
+    string searchLower = TextUtils::toLower(title);
 
-    return booksByTitle->searchByPredicate([searchLower](const Book& b) {
-        string bookTitle = b.getTitle();
-        transform(bookTitle.begin(), bookTitle.end(), bookTitle.begin(), ::tolower);
-        return bookTitle.find(searchLower) != string::npos;
-    });
+    if (searchLower.size() >= TrigramIndex::GRAM) {
+        return booksInTitleOrder(titleTrigrams.candidates(searchLower), [&searchLower](const Book& b) {
+            return b.getTitleKey().find(searchLower) != string::npos;
+        });
+    }
+
+    return collectBooks(
+        [&searchLower](const Book& b) { return b.getTitleKey().find(searchLower) != string::npos; },
+        [&](const CatalogRecord& rec) { return TextUtils::containsFolded(catalog->text(rec.title), searchLower); });
 }
 
 vector<Book> Library::searchBookByAuthor(const string& author) {
-    string searchLower = author;
-    transform(searchLower.begin(), searchLower.end(), searchLower.begin(), ::tolower);
+    ensureIndexes();
+    string searchLower = TextUtils::toLower(author);
+
+    if (searchLower.size() >= TrigramIndex::GRAM) {
+        return booksInTitleOrder(authorTrigrams.candidates(searchLower), [&searchLower](const Book& b) {
+            return b.getAuthorKey().find(searchLower) != string::npos;
+        });
+    }
 
-    return booksByTitle->searchByPredicate([searchLower](const Book& b) {
-        string bookAuthor = b.getAuthor();
-        transform(bookAuthor.begin(), bookAuthor.end(), bookAuthor.begin(), ::tolower);
-        return bookAuthor.find(searchLower) != string::npos;
+    return collectBooks(
+        [&searchLower](const Book& b) { return b.getAuthorKey().find(searchLower) != string::npos; },
+        [&](const CatalogRecord& rec) { return TextUtils::containsFolded(catalog->text(rec.author), searchLower); });
+}
+
+// Typo-tolerant title search: every query word must be within a small edit
+// distance (see FuzzyTermIndex::allowedDistance) of a word in the title.
+// Closest matches come first, then title order.
+vector<Book> Library::searchBookByTitleFuzzy(const string& title, int maxDistance) {
+    ensureIndexes();
+    vector<FuzzyMatch> matches = titleWords.search(title, maxDistance);
+
+    vector<pair<int, Book>> ranked;
+    ranked.reserve(matches.size());
+    for (const auto& match : matches) {
+        Book* book = findBookByID(match.bookID);
+        if (book) ranked.push_back({match.distance, *book});
+    }
+
+    stable_sort(ranked.begin(), ranked.end(), [](const pair<int, Book>& a, const pair<int, Book>& b) {
+        if (a.first != b.first) return a.first < b.first;
+        return Book::compareByTitle(a.second, b.second) < 0;
     });
+
+    vector<Book> results;
+    results.reserve(ranked.size());
+    for (auto& entry : ranked) {
+        results.push_back(move(entry.second));
+    }
+    return results;
 }
 
+// Case-insensitive match through the category index: only the matching
+// books are materialized.
 vector<Book> Library::searchBookByCategory(const string& category) {
-    string searchLower = category;
-    transform(searchLower.begin(), searchLower.end(), searchLower.begin(), ::tolower);
+    StringPool::Id wanted;
+    if (!StringPool::shared().find(TextUtils::toLower(category), wanted)) {
+        return vector<Book>();
+    }
+    return booksInTitleOrder(categories.find(wanted), [](const Book&) { return true; });
+}
 
-    return booksByTitle->searchByPredicate([searchLower](const Book& b) {
-        string bookCategory = b.getCategory();
-        transform(bookCategory.begin(), bookCategory.end(), bookCategory.begin(), ::tolower);
-        return bookCategory == searchLower;
-    });
+// Type-ahead completions weighted by how often the matching books were borrowed.
+vector<Completion> Library::suggestTitles(const string& prefix, int limit) const {
+    ensureIndexes();
+    return titleSuggestions.complete(prefix, limit);
 }
 
-Book* Library::findBookByID(int bookID) {
-    auto books = booksByTitle->searchByPredicate([bookID](const Book& b) {
-        return b.getBookID() == bookID;
+vector<Completion> Library::suggestAuthors(const string& prefix, int limit) const {
+    ensureIndexes();
+    return authorSuggestions.complete(prefix, limit);
+}
+
+vector<ScoredBook> Library::rankBooks(const string& query, int topK) const {
+    ensureIndexes();
+    return fullText.search(query, topK);
+}
+
+// Picks the access path expected to yield the fewest candidates. Substring
+// predicates shorter than a trigram cannot use an index.
+BookQueryPlan Library::planBookQuery(const BookQuery& query) const {
+    ensureIndexes();
+    if (query.bookID >= 0) {
+        return {BookAccessPath::ById, 1};
+    }
+
+    BookQueryPlan plan{BookAccessPath::FullScan, (size_t)getTotalBooks()};
+    auto consider = [&plan](BookAccessPath path, size_t estimate) {
+        if (estimate < plan.estimatedCandidates) plan = {path, estimate};
+    };
+
+    if (!query.category.empty()) {
+        StringPool::Id folded;
+        bool known = StringPool::shared().find(TextUtils::toLower(query.category), folded);
+        consider(BookAccessPath::Category, known ? categories.count(folded) : 0);
+    }
+    string title = TextUtils::toLower(query.title);
+    if (title.size() >= TrigramIndex::GRAM) {
+        consider(BookAccessPath::TitleTrigrams, titleTrigrams.estimate(title));
+    }
+    string author = TextUtils::toLower(query.author);
+    if (author.size() >= TrigramIndex::GRAM) {
+        consider(BookAccessPath::AuthorTrigrams, authorTrigrams.estimate(author));
+    }
+    return plan;
+}
+
+// Fetches candidates through the planned index and checks every predicate on
+// them; results are in title order.
+vector<Book> Library::findBooks(const BookQuery& query) {
+    ensureIndexes();
+    string title = TextUtils::toLower(query.title);
+    string author = TextUtils::toLower(query.author);
+
+    StringPool::Id category = StringPool::EMPTY;
+    if (!query.category.empty() && !StringPool::shared().find(TextUtils::toLower(query.category), category)) {
+        return vector<Book>();
+    }
+
+    auto matches = [&](const Book& b) {
+        return (query.bookID < 0 || b.getBookID() == query.bookID) &&
+               (title.empty() || b.getTitleKey().find(title) != string::npos) &&
+               (author.empty() || b.getAuthorKey().find(author) != string::npos) &&
+               (query.category.empty() || StringPool::shared().folded(b.getCategoryId()) == category) &&
+               (!query.availableOnly || b.getAvailableCopies() > 0);
+    };
+
+    BookQueryPlan plan = planBookQuery(query);
+    switch (plan.path) {
+        case BookAccessPath::ById:
+            return booksInTitleOrder({query.bookID}, matches);
+        case BookAccessPath::Category:
+            return booksInTitleOrder(categories.find(category), matches);
+        case BookAccessPath::TitleTrigrams:
+            return booksInTitleOrder(titleTrigrams.candidates(title), matches);
+        case BookAccessPath::AuthorTrigrams:
+            return booksInTitleOrder(authorTrigrams.candidates(author), matches);
+        case BookAccessPath::FullScan:
+            break;
+    }
+
+    return collectBooks(matches, [&](const CatalogRecord& rec) {
+        return (title.empty() || TextUtils::containsFolded(catalog->text(rec.title), title)) &&
+               (author.empty() || TextUtils::containsFolded(catalog->text(rec.author), author)) &&
+               (query.category.empty() || TextUtils::equalsFolded(catalog->text(rec.category), query.category)) &&
+               (!query.availableOnly || rec.availableCopies > 0);
     });
+}
 
-    if (!books.empty()) {
+// The returned pointer is only valid until the next mutation of the library.
+Book* Library::findBookByID(int bookID) {
+    auto slot = bookSlots.find(bookID);
+    if (slot.has_value()) {
+        return &books[slot.value()];
+    }
 
-        static Book foundBook;
-        foundBook = books[0];
-        return &foundBook;
+    if (catalog) {
+        int record = catalog->findRecord(bookID);
+        if (record >= 0) {
+            catalogScratch = catalog->toBook(record);
+            return &catalogScratch;
+        }
     }
     return nullptr;
 }
 
 void Library::addUser(const User& u) {
+    if (wal) requireLogged(wal->logAddUser(u));
+    auto previous = usersByID.find(u.getUserID());
+    if (!previous.has_value()) {
+        metrics.record(CirculationEvent::Registration, StringPool::EMPTY, time(nullptr));
+    } else {
+        for (int bookID : previous.value().getBorrowedBookIDs()) {
+            if (u.hasBorrowedBook(bookID)) continue;
+            loans.close(u.getUserID(), bookID);
+            removeBorrower(bookID, u.getUserID());
+        }
+    }
+    // Loans arriving with the user record get the default period unless known
+    time_t dueAt;
+    for (int bookID : u.getBorrowedBookIDs()) {
+        addBorrower(bookID, u.getUserID());
+        if (!loans.dueDate(u.getUserID(), bookID, dueAt)) {
+            loans.open(u.getUserID(), bookID, time(nullptr) + LoanSchedule::DEFAULT_LOAN_SECONDS);
+        }
+    }
     usersByID.insert(u.getUserID(), u);
     usersByEmail.insert(u.getEmail(), u);
+    outstandingLoans += u.getBorrowedBooksCount() - userActivity.count(u.getUserID());
+    userActivity.set(u.getUserID(), u.getBorrowedBooksCount());
     cout << "User added: " << u.getName() << " (ID: " << u.getUserID() << ")" << endl;
 }
 
@@ -107,7 +634,7 @@ void Library::printAllUsers() {
     cout << "\n\n";
 }
 
-bool Library::borrowBook(int userID, int bookID) {
+bool Library::borrowBook(int userID, int bookID, time_t dueAt) {
 
     auto userOpt = usersByID.find(userID);
     if (!userOpt.has_value()) {
@@ -122,22 +649,25 @@ bool Library::borrowBook(int userID, int bookID) {
         return false;
     }
 
-    auto books = booksByTitle->searchByPredicate([bookID](const Book& b) {
-        return b.getBookID() == bookID;
-    });
-
-    if (books.empty()) {
+    Book* book = findBookByID(bookID);
+    if (book == nullptr) {
         cout << "Error: Book ID " << bookID << " not found.\n";
         return false;
     }
 
-    Book book = books[0];
-
-    if (book.getAvailableCopies() <= 0) {
-        cout << "Error: No copies available for \"" << book.getTitle() << "\".\n";
+    if (book->getAvailableCopies() <= 0) {
+        cout << "Error: No copies available for \"" << book->getTitle() << "\".\n";
         return false;
     }
 
+    if (dueAt == 0) dueAt = time(nullptr) + LoanSchedule::DEFAULT_LOAN_SECONDS;
+    if (wal) requireLogged(wal->logBorrow(userID, bookID, dueAt));
+
+    Book& stored = books[writableSlot(bookID)];
+    bool wasAvailable = stored.getAvailableCopies() > 0;
+    stored.borrowBook();
+    categories.setAvailable(stored.getCategoryId(), wasAvailable, stored.getAvailableCopies() > 0);
+
     user.borrowBook(bookID);
     usersByID.insert(userID, user);
     usersByEmail.insert(user.getEmail(), user);
@@ -145,8 +675,20 @@ bool Library::borrowBook(int userID, int bookID) {
     auto countOpt = borrowCounts.find(bookID);
     int count = countOpt.has_value() ? countOpt.value() : 0;
     borrowCounts.insert(bookID, count + 1);
+    borrowRanking.add(bookID, 1);
+    userActivity.add(userID, 1);
+    outstandingLoans++;
+    circulation.recordBorrow(bookID, userID, stored.getCategoryId());
+    metrics.record(CirculationEvent::Borrow, stored.getCategoryId(), time(nullptr));
+    loans.open(userID, bookID, dueAt);
+    addBorrower(bookID, userID);
+    coBorrows.recordBorrow(bookID, user.getBorrowedBookIDs());
+    if (indexesBuilt) {
+        titleSuggestions.addWeight(stored.getTitle(), 1);
+        authorSuggestions.addWeight(stored.getAuthor(), 1);
+    }
 
-    cout << "Success: \"" << book.getTitle() << "\" borrowed by " << user.getName() << endl;
+    cout << "Success: \"" << stored.getTitle() << "\" borrowed by " << user.getName() << endl;
     return true;
 }
 
@@ -165,66 +707,126 @@ bool Library::returnBook(int userID, int bookID) {
         return false;
     }
 
-    auto books = booksByTitle->searchByPredicate([bookID](const Book& b) {
-        return b.getBookID() == bookID;
-    });
-
-    if (books.empty()) {
+    if (findBookByID(bookID) == nullptr) {
         cout << "Error: Book ID " << bookID << " not found.\n";
         return false;
     }
 
-    Book book = books[0];
+    if (wal) requireLogged(wal->logReturn(userID, bookID));
+
+    Book& stored = books[writableSlot(bookID)];
+    bool wasAvailable = stored.getAvailableCopies() > 0;
+    stored.returnBook();
+    categories.setAvailable(stored.getCategoryId(), wasAvailable, stored.getAvailableCopies() > 0);
 
     user.returnBook(bookID);
     usersByID.insert(userID, user);
     usersByEmail.insert(user.getEmail(), user);
+    userActivity.add(userID, -1);
+    outstandingLoans--;
+    metrics.record(CirculationEvent::Return, stored.getCategoryId(), time(nullptr));
+    loans.close(userID, bookID);
+    removeBorrower(bookID, userID);
 
-    cout << "Success: \"" << book.getTitle() << "\" returned by " << user.getName() << endl;
+    cout << "Success: \"" << stored.getTitle() << "\" returned by " << user.getName() << endl;
     return true;
 }
 
-vector<pair<int, int>> Library::getMostBorrowedBooks(int topN) {
-    vector<pair<int, int>> bookCounts;
-    auto bookIDs = borrowCounts.getAllKeys();
+vector<pair<int, int>> Library::getMostBorrowedBooks(int topN) const {
+    return borrowRanking.top(topN);
+}
+
+vector<pair<int, int>> Library::getMostActiveUsers(int topN) const {
+    return userActivity.top(topN);
+}
 
-    for (int id : bookIDs) {
-        auto count = borrowCounts.find(id);
-        if (count.has_value()) {
-            bookCounts.push_back({id, count.value()});
+// Rebuilds the rankings and loan count from borrowCounts and the user table
+// after they were replaced wholesale (snapshot load).
+void Library::rebuildUserAggregates() {
+    vector<pair<int, int>> bookCounts;
+    for (int bookID : borrowCounts.getAllKeys()) {
+        bookCounts.push_back({bookID, borrowCounts.find(bookID).value_or(0)});
+    }
+    borrowRanking.assign(bookCounts);
+
+    vector<pair<int, int>> userCounts;
+    outstandingLoans = 0;
+    borrowersByBook.clear();
+    for (const auto& user : usersByID.getAllValues()) {
+        userCounts.push_back({user.getUserID(), user.getBorrowedBooksCount()});
+        outstandingLoans += user.getBorrowedBooksCount();
+        for (int bookID : user.getBorrowedBookIDs()) {
+            addBorrower(bookID, user.getUserID());
         }
     }
+    userActivity.assign(userCounts);
+}
 
-    sort(bookCounts.begin(), bookCounts.end(),
-         [](const pair<int,int>& a, const pair<int,int>& b) {
-             return a.second > b.second;
-         });
+void Library::addBorrower(int bookID, int userID) {
+    vector<int>& borrowers = borrowersByBook[bookID];
+    auto it = lower_bound(borrowers.begin(), borrowers.end(), userID);
+    if (it == borrowers.end() || *it != userID) borrowers.insert(it, userID);
+}
 
-    if ((int)bookCounts.size() > topN) {
-        bookCounts.resize(topN);
-    }
+void Library::removeBorrower(int bookID, int userID) {
+    auto entry = borrowersByBook.find(bookID);
+    if (entry == borrowersByBook.end()) return;
 
-    return bookCounts;
+    vector<int>& borrowers = entry->second;
+    auto it = lower_bound(borrowers.begin(), borrowers.end(), userID);
+    if (it != borrowers.end() && *it == userID) borrowers.erase(it);
+    if (borrowers.empty()) borrowersByBook.erase(entry);
 }
 
-vector<pair<int, int>> Library::getMostActiveUsers(int topN) {
-    vector<pair<int, int>> userActivity;
-    auto users = usersByID.getAllValues();
+vector<HeavyHitter<int>> Library::recommendBooks(int bookID, int limit) const {
+    return coBorrows.recommend(bookID, limit);
+}
 
-    for (const auto& user : users) {
-        userActivity.push_back({user.getUserID(), user.getBorrowedBooksCount()});
-    }
+const vector<int>& Library::getBorrowers(int bookID) const {
+    static const vector<int> none;
+    auto entry = borrowersByBook.find(bookID);
+    return entry == borrowersByBook.end() ? none : entry->second;
+}
 
-    sort(userActivity.begin(), userActivity.end(),
-         [](const pair<int,int>& a, const pair<int,int>& b) {
-             return a.second > b.second;
-         });
+vector<CategoryStats> Library::getCategoryStats() const {
+    return categories.stats();
+}
 
-    if ((int)userActivity.size() > topN) {
-        userActivity.resize(topN);
-    }
+const CirculationSketches& Library::getCirculationSketches() const {
+    return circulation;
+}
+
+const CirculationMetrics& Library::getCirculationMetrics() const {
+    return metrics;
+}
 
-    return userActivity;
+void Library::resetCirculationMetrics() {
+    metrics.clear();
+}
+
+int Library::processDueLoans(time_t now) {
+    return loans.advance(now);
+}
+
+vector<Loan> Library::getOverdueLoans(int limit) const {
+    return loans.overdueLoans(limit);
+}
+
+int Library::getOverdueCount() const {
+    return (int)loans.overdueCount();
+}
+
+bool Library::getLoanDueDate(int userID, int bookID, time_t& dueAt) const {
+    return loans.dueDate(userID, bookID, dueAt);
+}
+
+bool Library::isLoanOverdue(int userID, int bookID) const {
+    return loans.isOverdue(userID, bookID);
+}
+
+LibraryTotals Library::getTotals() const {
+    const CategoryStats& books = categories.totals();
+    return {books.totalBooks, books.availableBooks, books.borrowedBooks, getTotalUsers(), outstandingLoans};
 }
 
 void Library::printStatistics() {
@@ -237,11 +839,9 @@ void Library::printStatistics() {
     for (size_t i = 0; i < topBooks.size(); i++) {
         int bookID = topBooks[i].first;
         int count = topBooks[i].second;
-        auto books = booksByTitle->searchByPredicate([bookID](const Book& b) {
-            return b.getBookID() == bookID;
-        });
-        if (!books.empty()) {
-            cout << "  " << books[0].getTitle() << " - " << count << " times\n";
+        Book* book = findBookByID(bookID);
+        if (book) {
+            cout << "  " << book->getTitle() << " - " << count << " times\n";
         }
     }
 
@@ -260,7 +860,8 @@ void Library::printStatistics() {
 }
 
 int Library::getTotalBooks() const {
-    return booksByTitle->getAllElements().size();
+    int catalogBooks = catalog ? (int)catalog->size() - shadowedCount : 0;
+    return (int)books.size() + catalogBooks;
 }
 
 int Library::getTotalUsers() const {
@@ -268,9 +869,42 @@ int Library::getTotalUsers() const {
 }
 
 vector<Book> Library::getAllBooks() const {
-    return booksByTitle->getAllElements();
+    return collectBooks([](const Book&) { return true; }, [](const CatalogRecord&) { return true; });
 }
 
 vector<User> Library::getAllUsers() const {
     return usersByID.getAllValues();
 }
+
+// Maps a compiled catalog segment underneath the heap books. Existing heap
+// books with matching IDs shadow their catalog records.
+bool Library::attachCatalog(const string& path) {
+    CatalogSegment* segment = new CatalogSegment();
+    if (!segment->open(path)) {
+        delete segment;
+        return false;
+    }
+
+    delete catalog;
+    catalog = segment;
+    shadowedRecords.assign(catalog->size(), false);
+    shadowedCount = 0;
+    for (const auto& b : books) {
+        markShadowed(b.getBookID());
+    }
+    rebuildCategories();
+    invalidateIndexes();
+    return true;
+}
+
+bool Library::hasCatalog() const {
+    return catalog != nullptr;
+}
+
+void Library::setWriteAheadLog(WriteAheadLog* log) {
+    wal = log;
+}
+
+WriteAheadLog* Library::getWriteAheadLog() const {
+    return wal;
+}
@@ -0,0 +1,89 @@
+#include "../../include/services/LoanSchedule.h"
+
+LoanSchedule::LoanSchedule(time_t start) : wheel((uint64_t)start / TICK_SECONDS) {}
+
+uint64_t LoanSchedule::keyOf(int userID, int bookID) {
+    return ((uint64_t)(uint32_t)userID << 32) | (uint32_t)bookID;
+}
+
+Loan LoanSchedule::loanOf(uint64_t key, time_t dueAt) {
+    return {(int)(uint32_t)(key >> 32), (int)(uint32_t)key, dueAt};
+}
+
+uint64_t LoanSchedule::tickOf(time_t dueAt) {
+    if (dueAt <= 0) return 0;
+    return ((uint64_t)dueAt + TICK_SECONDS - 1) / TICK_SECONDS;
+}
+
+void LoanSchedule::open(int userID, int bookID, time_t dueAt) {
+    close(userID, bookID);
+
+    uint64_t key = keyOf(userID, bookID);
+    dueDates[key] = dueAt;
+    wheel.schedule(key, tickOf(dueAt));
+}
+
+void LoanSchedule::close(int userID, int bookID) {
+    uint64_t key = keyOf(userID, bookID);
+    auto it = dueDates.find(key);
+    if (it == dueDates.end()) return;
+
+    if (!wheel.cancel(key)) {
+        overdue.erase({it->second, key});
+    }
+    dueDates.erase(it);
+}
+
+void LoanSchedule::clear(time_t start) {
+    wheel.reset((uint64_t)start / TICK_SECONDS);
+    dueDates.clear();
+    overdue.clear();
+}
+
+int LoanSchedule::advance(time_t now) {
+    int fired = 0;
+    wheel.advance((uint64_t)now / TICK_SECONDS, [this, &fired](uint64_t key, uint64_t) {
+        overdue.insert({dueDates.at(key), key});
+        fired++;
+    });
+    return fired;
+}
+
+bool LoanSchedule::dueDate(int userID, int bookID, time_t& dueAt) const {
+    auto it = dueDates.find(keyOf(userID, bookID));
+    if (it == dueDates.end()) return false;
+    dueAt = it->second;
+    return true;
+}
+
+bool LoanSchedule::isOverdue(int userID, int bookID) const {
+    uint64_t key = keyOf(userID, bookID);
+    auto it = dueDates.find(key);
+    return it != dueDates.end() && overdue.count({it->second, key}) > 0;
+}
+
+size_t LoanSchedule::openCount() const {
+    return dueDates.size();
+}
+
+size_t LoanSchedule::overdueCount() const {
+    return overdue.size();
+}
+
+vector<Loan> LoanSchedule::overdueLoans(int limit) const {
+    vector<Loan> result;
+    for (const auto& entry : overdue) {
+        if ((int)result.size() >= limit) break;
+        result.push_back(loanOf(entry.second, entry.first));
+    }
+    return result;
+}
+
+vector<Loan> LoanSchedule::openLoans() const {
+    vector<Loan> result;
+    result.reserve(dueDates.size());
+    for (const auto& entry : dueDates) {
+        result.push_back(loanOf(entry.first, entry.second));
+    }
+    return result;
+}
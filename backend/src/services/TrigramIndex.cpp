@@ -0,0 +1,88 @@
+#include "../../include/services/TrigramIndex.h"
+#include <algorithm>
+
+vector<uint32_t> TrigramIndex::trigramsOf(string_view text) {
+    vector<uint32_t> grams;
+    if (text.size() < GRAM) return grams;
+
+    grams.reserve(text.size() - GRAM + 1);
+    for (size_t i = 0; i + GRAM <= text.size(); i++) {
+        grams.push_back(((uint32_t)(unsigned char)text[i] << 16) |
+                        ((uint32_t)(unsigned char)text[i + 1] << 8) |
+                        (uint32_t)(unsigned char)text[i + 2]);
+    }
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+void TrigramIndex::add(int bookID, string_view foldedText) {
+    // IDs mostly arrive in ascending order, so this is usually an append
+    for (uint32_t gram : trigramsOf(foldedText)) {
+        batch.insert(postings[gram], bookID);
+    }
+}
+
+void TrigramIndex::remove(int bookID, string_view foldedText) {
+    batch.settle();
+    for (uint32_t gram : trigramsOf(foldedText)) {
+        auto it = postings.find(gram);
+        if (it == postings.end()) continue;
+
+        vector<int>& list = it->second;
+        auto pos = lower_bound(list.begin(), list.end(), bookID);
+        if (pos != list.end() && *pos == bookID) {
+            list.erase(pos);
+        }
+        if (list.empty()) {
+            postings.erase(it);
+        }
+    }
+}
+
+void TrigramIndex::clear() {
+    batch.reset();
+    postings.clear();
+}
+
+void TrigramIndex::beginBatch() {
+    batch.begin();
+}
+
+void TrigramIndex::endBatch() {
+    batch.end();
+}
+
+vector<int> TrigramIndex::candidates(string_view foldedQuery) const {
+    vector<const vector<int>*> lists;
+    for (uint32_t gram : trigramsOf(foldedQuery)) {
+        auto it = postings.find(gram);
+        if (it == postings.end()) return {};
+        lists.push_back(&it->second);
+    }
+    if (lists.empty()) return {};
+
+    // Intersect from the rarest trigram so the working set only shrinks
+    sort(lists.begin(), lists.end(), [](const vector<int>* a, const vector<int>* b) {
+        return a->size() < b->size();
+    });
+
+    vector<int> result = *lists[0];
+    vector<int> next;
+    for (size_t i = 1; i < lists.size() && !result.empty(); i++) {
+        next.clear();
+        set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(), back_inserter(next));
+        result.swap(next);
+    }
+    return result;
+}
+
+size_t TrigramIndex::estimate(string_view foldedQuery) const {
+    size_t shortest = SIZE_MAX;
+    for (uint32_t gram : trigramsOf(foldedQuery)) {
+        auto it = postings.find(gram);
+        if (it == postings.end()) return 0;
+        shortest = min(shortest, it->second.size());
+    }
+    return shortest == SIZE_MAX ? 0 : shortest;
+}
@@ -0,0 +1,291 @@
+#include "../../include/storage/CatalogSegment.h"
+#include "../../include/storage/BinaryIO.h"
+#include "../../include/utils/TextUtils.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <iostream>
+
+namespace {
+
+const char SEGMENT_MAGIC[8] = {'L', 'I', 'B', 'C', 'A', 'T', 'S', 'G'};
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t linkCount;
+    uint32_t recordSize;
+    uint64_t recordsOffset;
+    uint64_t titleIndexOffset;
+    uint64_t linksOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+static_assert(sizeof(CatalogRecord) == 72, "CatalogRecord layout changed; bump FORMAT_VERSION");
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader layout changed; bump FORMAT_VERSION");
+
+uint64_t alignTo8(uint64_t n) {
+    return (n + 7) & ~(uint64_t)7;
+}
+
+// Deduplicating string pool: repeated authors and categories are stored once.
+// String refs are 32-bit, so the pool cannot grow past UINT32_MAX bytes;
+// `overflow` is set instead and the segment must not be written.
+class StringPoolBuilder {
+public:
+    string bytes;
+    unordered_map<string, CatalogStringRef> seen;
+    bool overflow = false;
+
+    CatalogStringRef add(const string& s) {
+        auto it = seen.find(s);
+        if (it != seen.end()) return it->second;
+        if (bytes.size() + s.size() > UINT32_MAX) {
+            overflow = true;
+            return CatalogStringRef{0, 0};
+        }
+
+        CatalogStringRef ref{(uint32_t)bytes.size(), (uint32_t)s.size()};
+        bytes.append(s);
+        seen.emplace(s, ref);
+        return ref;
+    }
+};
+
+}
+
+CatalogSegment::CatalogSegment()
+    : base(nullptr), mappedSize(0), records(nullptr), recordCount(0), titleIndex(nullptr),
+      links(nullptr), linkCount(0), strings(nullptr), stringsSize(0) {}
+
+CatalogSegment::~CatalogSegment() {
+    close();
+}
+
+bool CatalogSegment::build(const vector<Book>& books, const string& path) {
+    vector<size_t> byID(books.size());
+    iota(byID.begin(), byID.end(), 0);
+    stable_sort(byID.begin(), byID.end(), [&books](size_t a, size_t b) {
+        return books[a].getBookID() < books[b].getBookID();
+    });
+
+    // A segment holds one record per book ID; the first occurrence wins.
+    vector<size_t> unique;
+    for (size_t idx : byID) {
+        if (unique.empty() || books[unique.back()].getBookID() != books[idx].getBookID()) {
+            unique.push_back(idx);
+        }
+    }
+
+    StringPoolBuilder pool;
+    vector<CatalogRecord> recordTable;
+    vector<CatalogStringRef> linkTable;
+    recordTable.reserve(unique.size());
+
+    for (size_t idx : unique) {
+        const Book& b = books[idx];
+        CatalogRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.bookID = b.getBookID();
+        rec.copies = b.getCopies();
+        rec.availableCopies = b.getAvailableCopies();
+        rec.title = pool.add(b.getTitle());
+        rec.author = pool.add(b.getAuthor());
+        rec.isbn = pool.add(b.getISBN());
+        rec.category = pool.add(b.getCategory());
+        rec.coverImage = pool.add(b.getCoverImage());
+        rec.type = pool.add(b.getType());
+
+        vector<string> bookLinks = b.getDownloadLinks();
+        rec.firstLink = (uint32_t)linkTable.size();
+        rec.linkCount = (uint32_t)bookLinks.size();
+        for (const auto& link : bookLinks) {
+            linkTable.push_back(pool.add(link));
+        }
+        recordTable.push_back(rec);
+    }
+    if (pool.overflow || recordTable.size() > UINT32_MAX || linkTable.size() > UINT32_MAX) {
+        cerr << "Catalog: " << path << " would exceed the segment format's 4 GiB string and record limits\n";
+        return false;
+    }
+
+    vector<uint32_t> titleOrder(recordTable.size());
+    iota(titleOrder.begin(), titleOrder.end(), 0);
+    sort(titleOrder.begin(), titleOrder.end(), [&](uint32_t a, uint32_t b) {
+        const CatalogRecord& ra = recordTable[a];
+        const CatalogRecord& rb = recordTable[b];
+        int cmp = TextUtils::compareFolded(string_view(pool.bytes.data() + ra.title.offset, ra.title.length),
+                                           string_view(pool.bytes.data() + rb.title.offset, rb.title.length));
+        return cmp != 0 ? cmp < 0 : ra.bookID < rb.bookID;
+    });
+
+    SegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.recordCount = (uint32_t)recordTable.size();
+    header.linkCount = (uint32_t)linkTable.size();
+    header.recordSize = sizeof(CatalogRecord);
+    header.recordsOffset = sizeof(SegmentHeader);
+    header.titleIndexOffset = header.recordsOffset + recordTable.size() * sizeof(CatalogRecord);
+    header.linksOffset = alignTo8(header.titleIndexOffset + titleOrder.size() * sizeof(uint32_t));
+    header.stringsOffset = header.linksOffset + linkTable.size() * sizeof(CatalogStringRef);
+    header.stringsSize = pool.bytes.size();
+
+    string image;
+    image.reserve(header.stringsOffset + header.stringsSize);
+    image.append((const char*)&header, sizeof(header));
+    image.append((const char*)recordTable.data(), recordTable.size() * sizeof(CatalogRecord));
+    image.append((const char*)titleOrder.data(), titleOrder.size() * sizeof(uint32_t));
+    image.resize(header.linksOffset, '\0');
+    image.append((const char*)linkTable.data(), linkTable.size() * sizeof(CatalogStringRef));
+    image.append(pool.bytes);
+
+    string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "Catalog: cannot create " << tmpPath << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    bool ok = BinaryIO::writeFully(fd, image.data(), image.size()) && fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        cerr << "Catalog: cannot write " << path << ": " << strerror(errno) << "\n";
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CatalogSegment::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SegmentHeader)) {
+        cerr << "Catalog: " << path << " is too small to be a catalog segment\n";
+        ::close(fd);
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        cerr << "Catalog: cannot map " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    base = (const char*)mapping;
+    mappedSize = (size_t)st.st_size;
+
+    SegmentHeader header;
+    memcpy(&header, base, sizeof(header));
+
+    bool valid = memcmp(header.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) == 0 &&
+                 header.version == FORMAT_VERSION &&
+                 header.recordSize == sizeof(CatalogRecord) &&
+                 header.recordsOffset + (uint64_t)header.recordCount * sizeof(CatalogRecord) <= header.titleIndexOffset &&
+                 header.titleIndexOffset + (uint64_t)header.recordCount * sizeof(uint32_t) <= header.linksOffset &&
+                 header.linksOffset + (uint64_t)header.linkCount * sizeof(CatalogStringRef) <= header.stringsOffset &&
+                 header.stringsOffset + header.stringsSize <= mappedSize &&
+                 header.recordsOffset % 8 == 0 && header.linksOffset % 8 == 0;
+    if (!valid) {
+        cerr << "Catalog: " << path << " is not a version " << FORMAT_VERSION << " catalog segment\n";
+        close();
+        return false;
+    }
+
+    // Title ranks index `records` directly, so a bad entry would read out of bounds
+    const uint32_t* ranks = (const uint32_t*)(base + header.titleIndexOffset);
+    for (uint32_t rank = 0; rank < header.recordCount; rank++) {
+        if (ranks[rank] >= header.recordCount) {
+            cerr << "Catalog: " << path << " has a corrupt title index\n";
+            close();
+            return false;
+        }
+    }
+
+    records = (const CatalogRecord*)(base + header.recordsOffset);
+    recordCount = header.recordCount;
+    titleIndex = ranks;
+    links = (const CatalogStringRef*)(base + header.linksOffset);
+    linkCount = header.linkCount;
+    strings = base + header.stringsOffset;
+    stringsSize = header.stringsSize;
+    return true;
+}
+
+void CatalogSegment::close() {
+    if (base) {
+        munmap((void*)base, mappedSize);
+    }
+    base = nullptr;
+    mappedSize = 0;
+    records = nullptr;
+    recordCount = 0;
+    titleIndex = nullptr;
+    links = nullptr;
+    linkCount = 0;
+    strings = nullptr;
+    stringsSize = 0;
+}
+
+bool CatalogSegment::isOpen() const {
+    return base != nullptr;
+}
+
+size_t CatalogSegment::size() const {
+    return recordCount;
+}
+
+const CatalogRecord& CatalogSegment::record(size_t index) const {
+    return records[index];
+}
+
+size_t CatalogSegment::recordAtTitleRank(size_t rank) const {
+    return titleIndex[rank];
+}
+
+int CatalogSegment::findRecord(int bookID) const {
+    int lo = 0, hi = (int)recordCount - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (records[mid].bookID == bookID) return mid;
+        if (records[mid].bookID < bookID) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+string_view CatalogSegment::text(const CatalogStringRef& ref) const {
+    if ((uint64_t)ref.offset + ref.length > stringsSize) return string_view();
+    return string_view(strings + ref.offset, ref.length);
+}
+
+vector<string> CatalogSegment::downloadLinks(size_t index) const {
+    const CatalogRecord& rec = records[index];
+    vector<string> out;
+    for (uint32_t i = 0; i < rec.linkCount && rec.firstLink + i < linkCount; i++) {
+        out.push_back(string(text(links[rec.firstLink + i])));
+    }
+    return out;
+}
+
+Book CatalogSegment::toBook(size_t index) const {
+    const CatalogRecord& rec = records[index];
+    return Book(rec.bookID, text(rec.title), text(rec.author), string(text(rec.isbn)), text(rec.category),
+                rec.copies, rec.availableCopies, string(text(rec.coverImage)), text(rec.type), downloadLinks(index));
+}
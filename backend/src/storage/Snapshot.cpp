@@ -0,0 +1,403 @@
+#include "../../include/storage/Snapshot.h"
+#include "../../include/storage/BinaryIO.h"
+#include "../../include/storage/RecordCodec.h"
+#include "../../include/storage/WriteAheadLog.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// File layout:
+//   header : 8-byte magic, u32 version, u32 CRC-32 of body, u64 WAL LSN, u64 body length
+//   body   : u32 book count,  heap-layer books in title order (RecordCodec format)
+//            u32 user count,  users followed by u32 loan count + loans, each a
+//                             book ID and (v3) u64 due time
+//            u32 entry count, (book ID, borrow count) pairs
+//            (v2) circulation sketches, see putSketches()
+//            (v4) co-borrowing neighbours, see putCoBorrows()
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'L', 'I', 'B', 'S', 'N', 'A', 'P', '\0'};
+const size_t SNAPSHOT_HEADER_SIZE = 32;
+
+string registerBytes(const HyperLogLog& hll) {
+    const vector<uint8_t>& registers = hll.getRegisters();
+    return string(registers.begin(), registers.end());
+}
+
+}
+
+//   u64 total, u32 cell count, Count-Min cells
+//   u32 count, (book ID, count, error) heavy hitters
+//   u32 count, (book ID, HLL registers as a string)
+//   u32 count, (category name, HLL registers as a string)
+void LibrarySnapshot::putSketches(string& body, const CirculationSketches& sketches) {
+    BinaryIO::putU64(body, sketches.borrowFrequency.getTotal());
+    const vector<uint32_t>& cells = sketches.borrowFrequency.getCells();
+    BinaryIO::putU32(body, (uint32_t)cells.size());
+    for (uint32_t cell : cells) {
+        BinaryIO::putU32(body, cell);
+    }
+
+    vector<HeavyHitter<int>> hitters = sketches.popularBooks.top(sketches.popularBooks.getCapacity());
+    BinaryIO::putU32(body, (uint32_t)hitters.size());
+    for (const auto& hitter : hitters) {
+        BinaryIO::putInt(body, hitter.key);
+        BinaryIO::putInt(body, hitter.count);
+        BinaryIO::putInt(body, hitter.error);
+    }
+
+    BinaryIO::putU32(body, (uint32_t)sketches.borrowersByBook.size());
+    for (const auto& entry : sketches.borrowersByBook) {
+        BinaryIO::putInt(body, entry.first);
+        BinaryIO::putString(body, registerBytes(entry.second));
+    }
+
+    BinaryIO::putU32(body, (uint32_t)sketches.borrowersByCategory.size());
+    for (const auto& entry : sketches.borrowersByCategory) {
+        BinaryIO::putString(body, StringPool::shared().str(entry.first));
+        BinaryIO::putString(body, registerBytes(entry.second));
+    }
+}
+
+bool LibrarySnapshot::readSketches(BinaryReader& in, CirculationSketches& sketches) {
+    sketches.clear();
+
+    uint64_t total = in.readU64();
+    vector<uint32_t> cells(in.ok ? in.readU32() : 0);
+    if (!in.has(cells.size() * 4)) return false;
+    for (auto& cell : cells) {
+        cell = in.readU32();
+    }
+    if (!sketches.borrowFrequency.restore(cells, total)) return false;
+
+    uint32_t hitterCount = in.readU32();
+    vector<HeavyHitter<int>> hitters;
+    for (uint32_t i = 0; i < hitterCount && in.ok; i++) {
+        int bookID = in.readInt();
+        int count = in.readInt();
+        int error = in.readInt();
+        hitters.push_back({bookID, count, error});
+    }
+    sketches.popularBooks.restore(hitters);
+
+    uint32_t bookSketches = in.readU32();
+    for (uint32_t i = 0; i < bookSketches && in.ok; i++) {
+        int bookID = in.readInt();
+        string bytes = in.readString();
+        // Older snapshots kept a sketch for every borrowed book
+        if (!sketches.popularBooks.contains(bookID)) continue;
+        HyperLogLog& hll = sketches.borrowersByBook.try_emplace(bookID, CirculationSketches::BOOK_PRECISION).first->second;
+        if (!hll.restore(vector<uint8_t>(bytes.begin(), bytes.end()))) return false;
+    }
+
+    uint32_t categorySketches = in.readU32();
+    for (uint32_t i = 0; i < categorySketches && in.ok; i++) {
+        StringPool::Id category = StringPool::shared().intern(in.readString());
+        string bytes = in.readString();
+        HyperLogLog& hll = sketches.borrowersByCategory.try_emplace(category, CirculationSketches::CATEGORY_PRECISION).first->second;
+        if (!hll.restore(vector<uint8_t>(bytes.begin(), bytes.end()))) return false;
+    }
+    return in.ok;
+}
+
+//   u32 book count, per book: book ID, u32 count, (neighbour ID, count, error)
+void LibrarySnapshot::putCoBorrows(string& body, const CoBorrowIndex& index) {
+    BinaryIO::putU32(body, (uint32_t)index.neighbors.size());
+    for (const auto& entry : index.neighbors) {
+        vector<HeavyHitter<int>> partners = entry.second.top(CoBorrowIndex::NEIGHBORS);
+        BinaryIO::putInt(body, entry.first);
+        BinaryIO::putU32(body, (uint32_t)partners.size());
+        for (const auto& partner : partners) {
+            BinaryIO::putInt(body, partner.key);
+            BinaryIO::putInt(body, partner.count);
+            BinaryIO::putInt(body, partner.error);
+        }
+    }
+}
+
+bool LibrarySnapshot::readCoBorrows(BinaryReader& in, CoBorrowIndex& index) {
+    index.clear();
+
+    uint32_t bookCount = in.readU32();
+    for (uint32_t i = 0; i < bookCount && in.ok; i++) {
+        int bookID = in.readInt();
+        uint32_t partnerCount = in.readU32();
+        vector<HeavyHitter<int>> partners;
+        for (uint32_t j = 0; j < partnerCount && in.ok; j++) {
+            int partner = in.readInt();
+            int count = in.readInt();
+            int error = in.readInt();
+            partners.push_back({partner, count, error});
+        }
+        index.neighborsOf(bookID).restore(partners);
+    }
+    return in.ok;
+}
+
+bool LibrarySnapshot::write(const Library& library, const string& path, uint64_t walLsn, SnapshotInfo* info) {
+    string body;
+
+    // Only the heap layer is written; an attached catalog segment is the
+    // base the snapshot is restored on top of.
+    vector<int> titleOrder = library.booksByTitle->getAllElements();
+    BinaryIO::putU32(body, (uint32_t)titleOrder.size());
+    for (int slot : titleOrder) {
+        RecordCodec::putBook(body, library.books[slot]);
+    }
+
+    vector<User> users = library.usersByID.getAllValues();
+    BinaryIO::putU32(body, (uint32_t)users.size());
+    for (const auto& user : users) {
+        RecordCodec::putUser(body, user);
+        const vector<int>& loans = user.getBorrowedBookIDs();
+        BinaryIO::putU32(body, (uint32_t)loans.size());
+        for (int bookID : loans) {
+            time_t dueAt = 0;
+            library.getLoanDueDate(user.getUserID(), bookID, dueAt);
+            BinaryIO::putInt(body, bookID);
+            BinaryIO::putU64(body, (uint64_t)dueAt);
+        }
+    }
+
+    vector<int> countedBooks = library.borrowCounts.getAllKeys();
+    BinaryIO::putU32(body, (uint32_t)countedBooks.size());
+    for (int bookID : countedBooks) {
+        BinaryIO::putInt(body, bookID);
+        BinaryIO::putInt(body, library.borrowCounts.find(bookID).value_or(0));
+    }
+
+    putSketches(body, library.circulation);
+    putCoBorrows(body, library.coBorrows);
+
+    string header(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    BinaryIO::putU32(header, FORMAT_VERSION);
+    BinaryIO::putU32(header, BinaryIO::crc32(body.data(), body.size()));
+    BinaryIO::putU64(header, walLsn);
+    BinaryIO::putU64(header, body.size());
+
+    // Write to a temporary file and rename so a crash never leaves a
+    // half-written snapshot in place.
+    string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        cerr << "Snapshot: cannot create " << tmpPath << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    bool ok = BinaryIO::writeFully(fd, header.data(), header.size()) &&
+              BinaryIO::writeFully(fd, body.data(), body.size()) &&
+              fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        cerr << "Snapshot: cannot write " << path << ": " << strerror(errno) << "\n";
+        remove(tmpPath.c_str());
+        return false;
+    }
+
+    if (info) {
+        info->version = FORMAT_VERSION;
+        info->walLsn = walLsn;
+        info->books = (int)titleOrder.size();
+        info->users = (int)users.size();
+    }
+    return true;
+}
+
+bool LibrarySnapshot::load(Library& library, const string& path, SnapshotInfo* info) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    string image;
+    bool readOk = BinaryIO::readWholeFile(fd, image);
+    ::close(fd);
+
+    if (!readOk || image.size() < SNAPSHOT_HEADER_SIZE ||
+        memcmp(image.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        cerr << "Snapshot: " << path << " is not a library snapshot\n";
+        return false;
+    }
+
+    uint32_t version = BinaryIO::readU32(image.data() + 8);
+    uint32_t crc = BinaryIO::readU32(image.data() + 12);
+    uint64_t walLsn = BinaryIO::readU64(image.data() + 16);
+    uint64_t bodyLen = BinaryIO::readU64(image.data() + 24);
+
+    if (version < 1 || version > FORMAT_VERSION) {
+        cerr << "Snapshot: unsupported format version " << version << " in " << path << "\n";
+        return false;
+    }
+
+    const char* body = image.data() + SNAPSHOT_HEADER_SIZE;
+    if (image.size() - SNAPSHOT_HEADER_SIZE != bodyLen || BinaryIO::crc32(body, bodyLen) != crc) {
+        cerr << "Snapshot: " << path << " is truncated or corrupt\n";
+        return false;
+    }
+
+    BinaryReader in(body, body + bodyLen);
+
+    uint32_t bookCount = in.readU32();
+    vector<Book> books;
+    books.reserve(in.ok ? bookCount : 0);
+    for (uint32_t i = 0; i < bookCount && in.ok; i++) {
+        books.push_back(RecordCodec::readBook(in));
+    }
+
+    uint32_t userCount = in.readU32();
+    vector<User> users;
+    vector<Loan> loans;
+    users.reserve(in.ok ? userCount : 0);
+    time_t defaultDue = time(nullptr) + LoanSchedule::DEFAULT_LOAN_SECONDS;
+    for (uint32_t i = 0; i < userCount && in.ok; i++) {
+        User user = RecordCodec::readUser(in);
+        uint32_t loanCount = in.readU32();
+        for (uint32_t j = 0; j < loanCount && in.ok; j++) {
+            int bookID = in.readInt();
+            time_t dueAt = version >= 3 ? (time_t)in.readU64() : 0;
+            user.borrowBook(bookID);
+            loans.push_back({user.getUserID(), bookID, dueAt > 0 ? dueAt : defaultDue});
+        }
+        users.push_back(user);
+    }
+
+    uint32_t countEntries = in.readU32();
+    vector<pair<int, int>> counts;
+    counts.reserve(in.ok ? countEntries : 0);
+    for (uint32_t i = 0; i < countEntries && in.ok; i++) {
+        int bookID = in.readInt();
+        int count = in.readInt();
+        counts.push_back({bookID, count});
+    }
+
+    CirculationSketches sketches;
+    if (version >= 2) {
+        in.ok = readSketches(in, sketches);
+    } else {
+        // Older snapshots carry no sketches; exact counts are the best seed
+        for (const auto& entry : counts) {
+            sketches.borrowFrequency.add((uint64_t)entry.first, (uint32_t)entry.second);
+            sketches.popularBooks.offer(entry.first, entry.second);
+        }
+    }
+
+    CoBorrowIndex coBorrows;
+    if (version >= 4 && in.ok) {
+        in.ok = readCoBorrows(in, coBorrows);
+    }
+
+    if (!in.ok) {
+        cerr << "Snapshot: " << path << " has malformed records\n";
+        return false;
+    }
+
+    // Books were written in title order: slot i is the i-th title, so the
+    // tree is rebuilt bottom-up from 0..n-1.
+    int bookCountLoaded = (int)books.size();
+    library.books = move(books);
+    library.bookSlots.clear();
+    library.bookSlots.reserve(bookCountLoaded);
+    vector<int> slots(bookCountLoaded);
+    for (int slot = 0; slot < bookCountLoaded; slot++) {
+        library.bookSlots.insert(library.books[slot].getBookID(), slot);
+        slots[slot] = slot;
+    }
+    library.booksByTitle->bulkLoad(slots);
+
+    library.shadowedRecords.assign(library.shadowedRecords.size(), false);
+    library.shadowedCount = 0;
+    for (const auto& book : library.books) {
+        library.markShadowed(book.getBookID());
+    }
+
+    library.usersByID.clear();
+    library.usersByEmail.clear();
+    library.usersByID.reserve((int)users.size());
+    library.usersByEmail.reserve((int)users.size());
+    for (const auto& user : users) {
+        library.usersByID.insert(user.getUserID(), user);
+        library.usersByEmail.insert(user.getEmail(), user);
+    }
+
+    library.loans.clear();
+    for (const auto& loan : loans) {
+        library.loans.open(loan.userID, loan.bookID, loan.dueAt);
+    }
+
+    library.borrowCounts.clear();
+    library.borrowCounts.reserve((int)counts.size());
+    for (const auto& entry : counts) {
+        library.borrowCounts.insert(entry.first, entry.second);
+    }
+
+    library.circulation = move(sketches);
+    library.coBorrows = move(coBorrows);
+
+    // The category index and totals are rebuilt now; the text indexes depend
+    // on the borrow counts too and are rebuilt when first queried
+    library.rebuildCategories();
+    library.invalidateIndexes();
+    library.rebuildUserAggregates();
+
+    if (info) {
+        info->version = version;
+        info->walLsn = walLsn;
+        info->books = bookCountLoaded;
+        info->users = (int)users.size();
+    }
+    return true;
+}
+
+SnapshotManager::SnapshotManager(Library& lib, WriteAheadLog* log, const string& snapshotPath, int intervalSeconds)
+    : library(lib), wal(log), path(snapshotPath), interval(intervalSeconds),
+      lastSnapshot(chrono::steady_clock::now()), lastSnapshotLsn(0) {}
+
+bool SnapshotManager::restore(SnapshotInfo* info) {
+    SnapshotInfo loaded;
+    if (!LibrarySnapshot::load(library, path, &loaded)) {
+        return false;
+    }
+
+    lastSnapshotLsn = loaded.walLsn;
+    lastSnapshot = chrono::steady_clock::now();
+    if (info) *info = loaded;
+    return true;
+}
+
+bool SnapshotManager::snapshotNow(SnapshotInfo* info) {
+    bool logging = wal && wal->isOpen();
+    uint64_t lsn = logging ? wal->getLastLsn() : lastSnapshotLsn;
+
+    if (logging) {
+        wal->sync();
+    }
+    if (!LibrarySnapshot::write(library, path, lsn, info)) {
+        return false;
+    }
+    if (logging) {
+        wal->reset();
+    }
+
+    lastSnapshotLsn = lsn;
+    lastSnapshot = chrono::steady_clock::now();
+    return true;
+}
+
+bool SnapshotManager::maybeSnapshot() {
+    if (interval.count() <= 0 || !wal || !wal->isOpen()) return false;
+    if (wal->getLastLsn() == lastSnapshotLsn) return false;
+    if (chrono::steady_clock::now() - lastSnapshot < interval) return false;
+    return snapshotNow();
+}
+
+string SnapshotManager::getPath() const {
+    return path;
+}
+
+uint64_t SnapshotManager::getLastSnapshotLsn() const {
+    return lastSnapshotLsn;
+}
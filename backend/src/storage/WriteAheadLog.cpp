@@ -0,0 +1,425 @@
+#include "../../include/storage/WriteAheadLog.h"
+#include "../../include/services/Library.h"
+#include "../../include/storage/BinaryIO.h"
+#include "../../include/storage/RecordCodec.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <functional>
+
+// File layout:
+//   header  : 8-byte magic, u64 base LSN (LSN of the last record removed by reset())
+//   record* : u32 body length, u32 CRC-32 of body, body = u64 LSN, u8 type, payload
+// Integers are stored little-endian; strings as u32 length + bytes.
+
+namespace {
+
+const char WAL_MAGIC[8] = {'L', 'I', 'B', 'W', 'A', 'L', '0', '1'};
+const size_t WAL_HEADER_SIZE = 16;
+const size_t RECORD_PREFIX_SIZE = 8;
+const size_t PENDING_FLUSH_THRESHOLD = 1 << 20;
+
+// Walks the records of a WAL image, stopping at the first torn or corrupt
+// one. Returns the offset just past the last valid record.
+size_t forEachRecord(const string& image,
+                     const function<void(uint64_t, WalRecordType, const char*, const char*)>& visit) {
+    size_t pos = WAL_HEADER_SIZE;
+    while (image.size() - pos >= RECORD_PREFIX_SIZE) {
+        uint32_t bodyLen = BinaryIO::readU32(image.data() + pos);
+        uint32_t crc = BinaryIO::readU32(image.data() + pos + 4);
+        if (bodyLen < 9 || image.size() - pos - RECORD_PREFIX_SIZE < bodyLen) break;
+
+        const char* body = image.data() + pos + RECORD_PREFIX_SIZE;
+        if (BinaryIO::crc32(body, bodyLen) != crc) break;
+
+        visit(BinaryIO::readU64(body), (WalRecordType)(uint8_t)body[8], body + 9, body + bodyLen);
+        pos += RECORD_PREFIX_SIZE + bodyLen;
+    }
+    return pos;
+}
+
+}
+
+WalOptions WalOptions::parse(const string& mode, int intervalMs) {
+    WalOptions opts;
+    if (mode == "always" || mode == "every" || mode == "sync") {
+        opts.syncMode = WalSyncMode::EveryOperation;
+    } else if (mode == "none" || mode == "off") {
+        opts.syncMode = WalSyncMode::None;
+    } else {
+        opts.syncMode = WalSyncMode::Interval;
+    }
+    opts.syncIntervalMs = intervalMs > 0 ? intervalMs : 10;
+    return opts;
+}
+
+WriteAheadLog::WriteAheadLog(const string& filePath, WalOptions opts)
+    : path(filePath), options(opts), fd(-1), stopping(false), flushing(false),
+      lastLsn(0), durableLsn(0), writtenEnd(0), failed(false), deferSync(false) {}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+bool WriteAheadLog::open() {
+    if (fd >= 0) return true;
+
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        cerr << "WAL: cannot open " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    if (!scanExisting()) {
+        ::close(fd);
+        fd = -1;
+        return false;
+    }
+
+    stopping = false;
+    if (options.syncMode != WalSyncMode::EveryOperation) {
+        flusher = thread(&WriteAheadLog::flusherLoop, this);
+    }
+    return true;
+}
+
+void WriteAheadLog::close() {
+    {
+        lock_guard<mutex> lock(mtx);
+        if (fd < 0) return;
+        stopping = true;
+    }
+    flushRequested.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+
+    unique_lock<mutex> lock(mtx);
+    waitDurable(lastLsn, lock);
+    ::close(fd);
+    fd = -1;
+}
+
+bool WriteAheadLog::isOpen() const {
+    lock_guard<mutex> lock(mtx);
+    return fd >= 0;
+}
+
+bool WriteAheadLog::writeHeader(uint64_t baseLsn) {
+    string header(WAL_MAGIC, sizeof(WAL_MAGIC));
+    BinaryIO::putU64(header, baseLsn);
+    return BinaryIO::writeFully(fd, header.data(), header.size());
+}
+
+bool WriteAheadLog::scanExisting() {
+    string image;
+    if (!BinaryIO::readWholeFile(fd, image)) {
+        cerr << "WAL: cannot read " << path << "\n";
+        return false;
+    }
+
+    if (image.size() < WAL_HEADER_SIZE) {
+        // New (or never fully initialised) log.
+        if (ftruncate(fd, 0) != 0 || !writeHeader(0) || fdatasync(fd) != 0) {
+            cerr << "WAL: cannot initialise " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        lastLsn = durableLsn = 0;
+        writtenEnd = (off_t)WAL_HEADER_SIZE;
+        failed = false;
+        return true;
+    }
+
+    if (memcmp(image.data(), WAL_MAGIC, sizeof(WAL_MAGIC)) != 0) {
+        cerr << "WAL: " << path << " is not a write-ahead log\n";
+        return false;
+    }
+
+    uint64_t maxLsn = BinaryIO::readU64(image.data() + sizeof(WAL_MAGIC));
+    size_t validEnd = forEachRecord(image, [&maxLsn](uint64_t lsn, WalRecordType, const char*, const char*) {
+        if (lsn > maxLsn) maxLsn = lsn;
+    });
+
+    if (validEnd < image.size()) {
+        cerr << "WAL: discarding " << (image.size() - validEnd)
+             << " bytes of torn tail in " << path << "\n";
+        if (ftruncate(fd, (off_t)validEnd) != 0) {
+            cerr << "WAL: cannot truncate " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+    }
+
+    lastLsn = durableLsn = maxLsn;
+    writtenEnd = (off_t)validEnd;
+    failed = false;
+    return true;
+}
+
+uint64_t WriteAheadLog::append(WalRecordType type, const string& payload) {
+    unique_lock<mutex> lock(mtx);
+    if (fd < 0 || failed) return 0;
+    return commit(queueRecord(type, payload), lock);
+}
+
+// Frames one record onto `pending`; mtx must be held.
+uint64_t WriteAheadLog::queueRecord(WalRecordType type, const string& payload) {
+    string body;
+    body.reserve(9 + payload.size());
+    uint64_t lsn = ++lastLsn;
+    BinaryIO::putU64(body, lsn);
+    body.push_back((char)type);
+    body.append(payload);
+
+    BinaryIO::putU32(pending, (uint32_t)body.size());
+    BinaryIO::putU32(pending, BinaryIO::crc32(body.data(), body.size()));
+    pending.append(body);
+    return lsn;
+}
+
+// Makes everything up to `lsn` as durable as the sync mode asks for.
+uint64_t WriteAheadLog::commit(uint64_t lsn, unique_lock<mutex>& lock) {
+    if (options.syncMode == WalSyncMode::EveryOperation && deferSync) {
+        // There is no flusher thread in this mode; write without syncing
+        if (pending.size() >= PENDING_FLUSH_THRESHOLD && !flushing && !flushPending(lock, false)) return 0;
+    } else if (options.syncMode == WalSyncMode::EveryOperation) {
+        if (!waitDurable(lsn, lock)) return 0;
+    } else if (pending.size() >= PENDING_FLUSH_THRESHOLD) {
+        flushRequested.notify_one();
+    }
+    return lsn;
+}
+
+// Group commit: whoever finds no flush in progress becomes the leader and
+// writes everything queued so far with a single fsync; the others wait on
+// `flushed` and are usually covered by that same fsync. Returns false if the
+// record can no longer become durable.
+bool WriteAheadLog::waitDurable(uint64_t lsn, unique_lock<mutex>& lock) {
+    while (durableLsn < lsn) {
+        if (fd < 0 || failed) return false;
+        if (flushing) {
+            flushed.wait(lock);
+        } else if (!flushPending(lock, true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WriteAheadLog::flushPending(unique_lock<mutex>& lock, bool doSync) {
+    flushing = true;
+    string batch;
+    batch.swap(pending);
+    uint64_t target = lastLsn;
+    int file = fd;
+
+    lock.unlock();
+    bool ok = BinaryIO::writeFully(file, batch.data(), batch.size());
+    if (ok && doSync) {
+        ok = fdatasync(file) == 0;
+    }
+    lock.lock();
+
+    flushing = false;
+    if (ok) {
+        writtenEnd += (off_t)batch.size();
+        if (doSync && target > durableLsn) durableLsn = target;
+    } else {
+        // Cut off whatever part of the batch reached the file, so a torn
+        // record cannot hide the records written after it from replay. The
+        // batch's records are lost, so stop accepting new ones: changes the
+        // caller already applied (interval mode) are only safe again once a
+        // snapshot has been taken and reset() has run.
+        cerr << "WAL: write to " << path << " failed: " << strerror(errno) << "\n";
+        if (ftruncate(file, writtenEnd) != 0) {
+            cerr << "WAL: cannot truncate " << path << ": " << strerror(errno) << "\n";
+        }
+        failed = true;
+        pending.clear();
+    }
+    flushed.notify_all();
+    return ok;
+}
+
+void WriteAheadLog::flusherLoop() {
+    unique_lock<mutex> lock(mtx);
+    bool doSync = options.syncMode == WalSyncMode::Interval;
+
+    while (!stopping) {
+        flushRequested.wait_for(lock, chrono::milliseconds(options.syncIntervalMs));
+        if (flushing || failed) continue;
+        if (!pending.empty() || (doSync && durableLsn < lastLsn)) {
+            flushPending(lock, doSync);
+        }
+    }
+}
+
+uint64_t WriteAheadLog::logAddBook(const Book& b) {
+    string payload;
+    RecordCodec::putBook(payload, b);
+    return append(WalRecordType::AddBook, payload);
+}
+
+// One AddBook record per book, queued under one lock and committed with a
+// single write (and fsync in EveryOperation mode) for the whole batch.
+uint64_t WriteAheadLog::logAddBooks(const vector<Book>& books) {
+    string payload;
+    unique_lock<mutex> lock(mtx);
+    if (fd < 0 || failed) return 0;
+    if (books.empty()) return lastLsn;
+
+    uint64_t lsn = 0;
+    for (const auto& b : books) {
+        payload.clear();
+        RecordCodec::putBook(payload, b);
+        lsn = queueRecord(WalRecordType::AddBook, payload);
+    }
+    return commit(lsn, lock);
+}
+
+uint64_t WriteAheadLog::logAddUser(const User& u) {
+    string payload;
+    RecordCodec::putUser(payload, u);
+    return append(WalRecordType::AddUser, payload);
+}
+
+uint64_t WriteAheadLog::logBorrow(int userID, int bookID, int64_t dueAt) {
+    string payload;
+    BinaryIO::putInt(payload, userID);
+    BinaryIO::putInt(payload, bookID);
+    BinaryIO::putU64(payload, (uint64_t)dueAt);
+    return append(WalRecordType::BorrowBook, payload);
+}
+
+uint64_t WriteAheadLog::logReturn(int userID, int bookID) {
+    string payload;
+    BinaryIO::putInt(payload, userID);
+    BinaryIO::putInt(payload, bookID);
+    return append(WalRecordType::ReturnBook, payload);
+}
+
+uint64_t WriteAheadLog::logRemoveBook(int bookID) {
+    string payload;
+    BinaryIO::putInt(payload, bookID);
+    return append(WalRecordType::RemoveBook, payload);
+}
+
+void WriteAheadLog::setDeferredSync(bool deferred) {
+    lock_guard<mutex> lock(mtx);
+    deferSync = deferred;
+}
+
+bool WriteAheadLog::sync() {
+    unique_lock<mutex> lock(mtx);
+    return waitDurable(lastLsn, lock);
+}
+
+// Drops every record once the caller has persisted the state they describe
+// (e.g. in a snapshot). LSNs keep counting from where they left off.
+bool WriteAheadLog::reset() {
+    unique_lock<mutex> lock(mtx);
+    if (fd < 0) return false;
+
+    waitDurable(lastLsn, lock);
+    while (flushing) flushed.wait(lock);
+    pending.clear();
+
+    if (ftruncate(fd, 0) != 0 || !writeHeader(lastLsn) || fdatasync(fd) != 0) {
+        cerr << "WAL: cannot reset " << path << ": " << strerror(errno) << "\n";
+        failed = true;
+        return false;
+    }
+    durableLsn = lastLsn;
+    writtenEnd = (off_t)WAL_HEADER_SIZE;
+    failed = false;
+    return true;
+}
+
+// Re-applies every record newer than `afterLsn`. The library's own log is
+// detached for the duration so replayed operations are not logged twice.
+int WriteAheadLog::replay(Library& library, uint64_t afterLsn) {
+    string image;
+    {
+        lock_guard<mutex> lock(mtx);
+        if (fd < 0 || !BinaryIO::readWholeFile(fd, image)) return 0;
+    }
+    if (image.size() < WAL_HEADER_SIZE) return 0;
+
+    WriteAheadLog* attached = library.getWriteAheadLog();
+    library.setWriteAheadLog(nullptr);
+
+    int applied = 0;
+    forEachRecord(image, [&](uint64_t lsn, WalRecordType type, const char* begin, const char* end) {
+        if (lsn <= afterLsn) return;
+
+        BinaryReader in(begin, end);
+        switch (type) {
+            case WalRecordType::AddBook: {
+                Book book = RecordCodec::readBook(in);
+                if (in.ok) library.addBook(book);
+                break;
+            }
+            case WalRecordType::AddUser: {
+                User user = RecordCodec::readUser(in);
+                if (in.ok) library.addUser(user);
+                break;
+            }
+            case WalRecordType::BorrowBook: {
+                int userID = in.readInt();
+                int bookID = in.readInt();
+                // Records written before due dates existed stop here
+                time_t dueAt = in.has(8) ? (time_t)in.readU64() : 0;
+                if (in.ok) library.borrowBook(userID, bookID, dueAt);
+                break;
+            }
+            case WalRecordType::ReturnBook: {
+                int userID = in.readInt();
+                int bookID = in.readInt();
+                if (in.ok) library.returnBook(userID, bookID);
+                break;
+            }
+            case WalRecordType::RemoveBook: {
+                int bookID = in.readInt();
+                if (in.ok) library.removeBook(bookID);
+                break;
+            }
+            default:
+                in.ok = false;
+                break;
+        }
+
+        if (in.ok) {
+            applied++;
+        } else {
+            cerr << "WAL: skipping malformed record at LSN " << lsn << "\n";
+        }
+    });
+
+    library.setWriteAheadLog(attached);
+    return applied;
+}
+
+uint64_t WriteAheadLog::getLastLsn() const {
+    lock_guard<mutex> lock(mtx);
+    return lastLsn;
+}
+
+uint64_t WriteAheadLog::getDurableLsn() const {
+    lock_guard<mutex> lock(mtx);
+    return durableLsn;
+}
+
+bool WriteAheadLog::hasFailed() const {
+    lock_guard<mutex> lock(mtx);
+    return failed;
+}
+
+string WriteAheadLog::getPath() const {
+    return path;
+}
+
+WalOptions WriteAheadLog::getOptions() const {
+    return options;
+}
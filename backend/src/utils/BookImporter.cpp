@@ -0,0 +1,344 @@
+#include "../../include/utils/BookImporter.h"
+#include "../../include/utils/JsonStreamParser.h"
+#include <cstring>
+#include <cctype>
+#include <climits>
+
+using namespace std;
+
+struct BookImporter::Fields {
+    string id, title, author, isbn, category, copies, available, cover, type;
+
+    void clear() {
+        id.clear(); title.clear(); author.clear(); isbn.clear(); category.clear();
+        copies.clear(); available.clear(); cover.clear(); type.clear();
+    }
+
+    string* find(string_view name) {
+        if (name == "bookID" || name == "id") return &id;
+        if (name == "title") return &title;
+        if (name == "author") return &author;
+        if (name == "isbn") return &isbn;
+        if (name == "category") return &category;
+        if (name == "copies") return &copies;
+        if (name == "availableCopies") return &available;
+        if (name == "cover" || name == "coverImage") return &cover;
+        if (name == "type") return &type;
+        return nullptr;
+    }
+};
+
+// Copies the top-level members of one JSON object into Fields; nested values
+// are skipped.
+class BookImporter::RecordHandler : public JsonHandler {
+public:
+    Fields* fields = nullptr;
+    int depth = 0;
+    bool object = false;
+    string* target = nullptr;
+
+    void reset(Fields* f) {
+        fields = f;
+        depth = 0;
+        object = false;
+        target = nullptr;
+    }
+
+    void startObject() override {
+        if (depth == 0) object = true;
+        depth++;
+        target = nullptr;
+    }
+    void endObject() override { depth--; target = nullptr; }
+    void startArray() override { depth++; target = nullptr; }
+    void endArray() override { depth--; target = nullptr; }
+    void key(string_view k) override { target = depth == 1 ? fields->find(k) : nullptr; }
+    void stringValue(string_view v) override { set(v); }
+    void numberValue(string_view v) override { set(v); }
+
+private:
+    void set(string_view v) {
+        if (depth == 1 && target) target->assign(v.data(), v.size());
+        target = nullptr;
+    }
+};
+
+namespace {
+
+bool parseCount(const string& text, int& out) {
+    if (text.empty() || text.size() > 10) return false;
+    long long value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    if (value > INT_MAX) return false;
+    out = (int)value;
+    return true;
+}
+
+bool isBlank(string_view text) {
+    for (char c : text) {
+        if (!isspace((unsigned char)c)) return false;
+    }
+    return true;
+}
+
+string trim(string_view text) {
+    size_t b = 0, e = text.size();
+    while (b < e && isspace((unsigned char)text[b])) b++;
+    while (e > b && isspace((unsigned char)text[e - 1])) e--;
+    return string(text.substr(b, e - b));
+}
+
+} // namespace
+
+BookImporter::BookImporter(Library& lib, Format fmt)
+    : library(lib), format(fmt), failed(false), skipping(false), inQuotes(false), records(0),
+      haveHeader(false), fields(new Fields()), handler(new RecordHandler()),
+      parser(new JsonStreamParser(*handler, 1)) {
+    batch.reserve(BATCH_SIZE);
+}
+
+BookImporter::~BookImporter() = default;
+
+bool BookImporter::parseFormat(const string& name, Format& out) {
+    string value = name.substr(0, name.find(';'));
+    value = trim(value);
+    for (auto& c : value) c = (char)tolower((unsigned char)c);
+
+    if (value == "ndjson" || value == "jsonl" || value == "application/x-ndjson" ||
+        value == "application/ndjson" || value == "application/jsonl") {
+        out = Format::NDJSON;
+        return true;
+    }
+    if (value == "csv" || value == "text/csv" || value == "application/csv") {
+        out = Format::CSV;
+        return true;
+    }
+    return false;
+}
+
+// Returns the offset of the newline ending the record that continues at
+// `from`, or npos. CSV newlines inside quoted fields do not end a record;
+// an escaped quote ("") toggles the state twice, so it needs no special case.
+size_t BookImporter::findEnd(string_view data, size_t from) {
+    if (format == Format::NDJSON) {
+        const void* nl = memchr(data.data() + from, '\n', data.size() - from);
+        return nl ? (const char*)nl - data.data() : string_view::npos;
+    }
+    for (size_t i = from; i < data.size(); i++) {
+        char c = data[i];
+        if (c == '"') inQuotes = !inQuotes;
+        else if (c == '\n' && !inQuotes) return i;
+    }
+    return string_view::npos;
+}
+
+void BookImporter::feed(string_view data) {
+    size_t pos = 0;
+    while (pos < data.size() && !failed) {
+        size_t end = findEnd(data, pos);
+        size_t stop = end == string_view::npos ? data.size() : end;
+        string_view piece = data.substr(pos, stop - pos);
+
+        if (!skipping && pending.size() + piece.size() > MAX_RECORD_BYTES) {
+            skipping = true;
+            pending.clear();
+            pending.shrink_to_fit();
+        }
+
+        if (end == string_view::npos) {
+            if (!skipping) pending.append(piece);
+            break;
+        }
+
+        if (skipping) {
+            records++;
+            reject("Record is longer than " + to_string(MAX_RECORD_BYTES) + " bytes");
+            skipping = false;
+        } else if (pending.empty()) {
+            endRecord(piece);
+        } else {
+            pending.append(piece);
+            endRecord(pending);
+            pending.clear();
+        }
+        pos = end + 1;
+    }
+}
+
+ImportReport BookImporter::finish() {
+    if (failed) {
+        return report;
+    }
+    if (skipping) {
+        records++;
+        reject("Record is longer than " + to_string(MAX_RECORD_BYTES) + " bytes");
+        skipping = false;
+    } else if (!pending.empty()) {
+        endRecord(pending);
+        pending.clear();
+    }
+    flush();
+    return report;
+}
+
+void BookImporter::endRecord(string_view text) {
+    if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+
+    if (format == Format::CSV) {
+        if (isBlank(text)) return;
+        if (!haveHeader) {
+            haveHeader = true;
+            if (!splitCsv(text)) return;
+            columns.clear();
+            for (const auto& v : values) columns.push_back(trim(v));
+            return;
+        }
+    }
+
+    // NDJSON errors are reported by line, so blank lines still count
+    records++;
+    if (format == Format::NDJSON && isBlank(text)) return;
+
+    fields->clear();
+    string error;
+    bool ok = format == Format::NDJSON ? readJson(text, error) : readCsv(text, error);
+
+    Book book;
+    if (!ok || !validate(book, error)) {
+        reject(error);
+        return;
+    }
+
+    batchIDs.insert(book.getBookID());
+    batch.push_back(move(book));
+    if (batch.size() >= BATCH_SIZE) flush();
+}
+
+bool BookImporter::readJson(string_view text, string& error) {
+    handler->reset(fields.get());
+    if (!parser->parse(text)) {
+        error = "Invalid JSON: " + parser->getError();
+        return false;
+    }
+    if (!handler->object) {
+        error = "Expected a JSON object";
+        return false;
+    }
+    return true;
+}
+
+bool BookImporter::readCsv(string_view text, string& error) {
+    if (!splitCsv(text)) {
+        error = "Unterminated quoted field";
+        return false;
+    }
+    if (values.size() != columns.size()) {
+        error = "Expected " + to_string(columns.size()) + " fields, found " + to_string(values.size());
+        return false;
+    }
+    for (size_t i = 0; i < columns.size(); i++) {
+        string* target = fields->find(columns[i]);
+        if (target) target->swap(values[i]);
+    }
+    return true;
+}
+
+// Splits one CSV record into `values`, reusing its strings between records.
+bool BookImporter::splitCsv(string_view text) {
+    size_t count = 0;
+    size_t i = 0;
+    while (true) {
+        if (count == values.size()) values.emplace_back();
+        string& value = values[count++];
+        value.clear();
+
+        if (i < text.size() && text[i] == '"') {
+            i++;
+            while (true) {
+                if (i >= text.size()) return false;
+                char c = text[i++];
+                if (c != '"') {
+                    value += c;
+                } else if (i < text.size() && text[i] == '"') {
+                    value += '"';
+                    i++;
+                } else {
+                    break;
+                }
+            }
+            // Anything between the closing quote and the comma is kept as is
+            while (i < text.size() && text[i] != ',') value += text[i++];
+        } else {
+            size_t comma = text.find(',', i);
+            size_t stop = comma == string_view::npos ? text.size() : comma;
+            value.append(text.data() + i, stop - i);
+            i = stop;
+        }
+
+        if (i >= text.size()) break;
+        i++;  // comma
+    }
+    values.resize(count);
+    return true;
+}
+
+bool BookImporter::validate(Book& book, string& error) {
+    const Fields& f = *fields;
+
+    int id = 0;
+    if (!parseCount(trim(f.id), id) || id <= 0) {
+        error = "bookID must be a positive integer";
+        return false;
+    }
+    string title = trim(f.title);
+    if (title.empty()) {
+        error = "title is required";
+        return false;
+    }
+
+    int copies = 1;
+    string copiesText = trim(f.copies);
+    if (!copiesText.empty() && !parseCount(copiesText, copies)) {
+        error = "copies must be a non-negative integer";
+        return false;
+    }
+    int available = copies;
+    string availableText = trim(f.available);
+    if (!availableText.empty() && (!parseCount(availableText, available) || available > copies)) {
+        error = "availableCopies must be between 0 and copies";
+        return false;
+    }
+
+    if (batchIDs.count(id) || library.findBookByID(id)) {
+        error = "Book ID " + to_string(id) + " already exists";
+        return false;
+    }
+
+    book = Book(id, title, f.author, f.isbn, f.category.empty() ? "General" : f.category,
+                copies, available, f.cover, f.type);
+    return true;
+}
+
+void BookImporter::reject(const string& message) {
+    report.rejected++;
+    if (report.errors.size() < MAX_ERRORS) report.errors.push_back({records, message});
+}
+
+void BookImporter::flush() {
+    if (batch.empty()) return;
+    size_t count = batch.size();
+    try {
+        // addBooks applies all of a batch or none of it
+        library.addBooks(move(batch));
+        report.imported += count;
+    } catch (const exception& e) {
+        failed = true;
+        report.failure = e.what();
+    }
+    batch.clear();
+    batch.reserve(BATCH_SIZE);
+    batchIDs.clear();
+}
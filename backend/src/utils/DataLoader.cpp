@@ -0,0 +1,668 @@
+#include "../../include/utils/DataLoader.h"
+#include "../../include/utils/JsonStreamParser.h"
+#include "../../include/utils/JsonStructuralIndex.h"
+#include "../../include/utils/MappedFile.h"
+#include <iostream>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <deque>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <algorithm>
+
+namespace {
+
+enum class Section { None, Books, Users };
+
+using BookSink = std::function<void(Book&&)>;
+using UserSink = std::function<void(User&&)>;
+
+// A text field of the record being read: a view into the input when the
+// input outlives the record, otherwise a copy held here.
+struct TextField {
+    std::string_view value;
+    std::string copy;
+
+    void set(std::string_view text, bool stable) {
+        if (stable) {
+            value = text;
+        } else {
+            copy.assign(text.data(), text.size());
+            value = copy;
+        }
+    }
+};
+
+// Field values of the record being read, and how they become a Book or User.
+// Strings are only copied (or interned) by the Book and User constructors.
+class RecordBuilder {
+private:
+    Section section = Section::None;
+    int id = 0;
+    TextField title, author, isbn, category, cover, coverImage, type;
+    TextField name, email, role;
+    int copies = 0;
+    int availableCopies = 0;
+
+    static int toInt(std::string_view text) {
+        return (int)std::strtol(std::string(text).c_str(), nullptr, 10);
+    }
+
+    int* intField(std::string_view field) {
+        if (section == Section::Books) {
+            if (field == "bookID") return &id;
+            if (field == "copies") return &copies;
+            if (field == "availableCopies") return &availableCopies;
+        } else if (field == "id" || field == "userID") {
+            return &id;
+        }
+        return nullptr;
+    }
+
+    TextField* textField(std::string_view field) {
+        if (section == Section::Books) {
+            if (field == "title") return &title;
+            if (field == "author") return &author;
+            if (field == "isbn") return &isbn;
+            if (field == "category") return &category;
+            if (field == "cover") return &cover;
+            if (field == "coverImage") return &coverImage;
+            if (field == "type") return &type;
+        } else {
+            if (field == "name") return &name;
+            if (field == "email") return &email;
+            if (field == "role") return &role;
+        }
+        return nullptr;
+    }
+
+public:
+    void reset(Section s) {
+        section = s;
+        id = copies = availableCopies = 0;
+        for (TextField* field : {&title, &author, &isbn, &category, &cover, &coverImage, &type, &name, &email, &role}) {
+            field->value = {};
+        }
+    }
+
+    Section getSection() const {
+        return section;
+    }
+
+    void number(std::string_view field, std::string_view value) {
+        if (int* target = intField(field)) *target = toInt(value);
+    }
+
+    // Integer fields also accept quoted numbers. A stable value stays valid
+    // until finish() and is not copied.
+    void text(std::string_view field, std::string_view value, bool stable) {
+        if (int* target = intField(field)) *target = toInt(value);
+        else if (TextField* target = textField(field)) target->set(value, stable);
+    }
+
+    void finish(const BookSink& onBook, const UserSink& onUser) {
+        // Real covers ("cover") take precedence over the original coverImage
+        if (section == Section::Books && id > 0 && !title.value.empty()) {
+            std::string_view image = cover.value.empty() ? coverImage.value : cover.value;
+            onBook(Book(id, title.value, author.value, std::string(isbn.value), category.value, copies,
+                        availableCopies, std::string(image), type.value));
+        } else if (section == Section::Users && id > 0 && !name.value.empty()) {
+            onUser(User(id, std::string(name.value), std::string(email.value), role.value));
+        }
+    }
+};
+
+// Turns streaming parser events into records: the objects directly inside
+// the top-level "books" and "users" arrays. Nested values inside a record
+// are skipped. Strings that point into `source` (a mapped file) are kept as
+// views; anything else is copied.
+class CatalogHandler : public JsonHandler {
+private:
+    static const int RECORD_DEPTH = 3;  // root object > section array > record
+
+    BookSink onBook;
+    UserSink onUser;
+    RecordBuilder record;
+    const MappedFile* source;
+    int depth = 0;
+    Section section = Section::None;
+    std::string field;
+
+    void enterContainer(bool isArray) {
+        depth++;
+        field.clear();
+        if (depth == RECORD_DEPTH - 1 && !isArray) section = Section::None;
+        if (depth == RECORD_DEPTH) record.reset(section);
+    }
+
+    bool inRecordField() const {
+        return depth == RECORD_DEPTH && section != Section::None && !field.empty();
+    }
+
+public:
+    CatalogHandler(BookSink onBook, UserSink onUser, const MappedFile* source = nullptr)
+        : onBook(std::move(onBook)), onUser(std::move(onUser)), source(source) {}
+
+    void startObject() override { enterContainer(false); }
+    void startArray() override { enterContainer(true); }
+
+    void endObject() override {
+        if (depth == RECORD_DEPTH) record.finish(onBook, onUser);
+        depth--;
+        field.clear();
+    }
+
+    void endArray() override {
+        if (depth == RECORD_DEPTH - 1) section = Section::None;
+        depth--;
+        field.clear();
+    }
+
+    void key(std::string_view label) override {
+        if (depth == 1) {
+            section = label == "books" ? Section::Books : (label == "users" ? Section::Users : Section::None);
+        } else if (depth == RECORD_DEPTH) {
+            field = label;
+        }
+    }
+
+    void stringValue(std::string_view value) override {
+        if (inRecordField()) record.text(field, value, source && source->contains(value));
+        field.clear();
+    }
+
+    void numberValue(std::string_view value) override {
+        if (inRecordField()) record.number(field, value);
+        field.clear();
+    }
+
+    void boolValue(bool) override { field.clear(); }
+    void nullValue() override { field.clear(); }
+};
+
+bool isBlank(std::string_view text) {
+    for (char c : text) {
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view text) {
+    size_t first = 0;
+    size_t last = text.size();
+    while (first < last && isBlank(text.substr(first, 1))) first++;
+    while (last > first && isBlank(text.substr(last - 1, 1))) last--;
+    return text.substr(first, last - first);
+}
+
+// Plain integers (the common case) need no further checking
+bool isPlainInteger(std::string_view text) {
+    size_t i = !text.empty() && text[0] == '-' ? 1 : 0;
+    if (i >= text.size() || (text[i] == '0' && text.size() > i + 1)) return false;
+    for (; i < text.size(); i++) {
+        if (text[i] < '0' || text[i] > '9') return false;
+    }
+    return true;
+}
+
+// Stage 2: builds one record by walking its structural offsets (from
+// JsonStructuralIndex) rather than its bytes. Strings without escapes are
+// used in place; escaped strings, unusual scalars and nested values are
+// handed to JsonStreamParser, which decodes and validates them.
+class StructuralRecordReader : public JsonHandler {
+private:
+    enum class Kind { None, String, Number, Other };
+
+    RecordBuilder record;
+    JsonStreamParser parser;
+    Kind kind = Kind::None;
+    std::string decoded;
+    std::string error;
+    size_t errorAt = 0;
+
+    std::string_view text;
+    const uint32_t* pos = nullptr;
+
+    bool fail(const std::string& message, size_t at) {
+        error = message;
+        errorAt = at;
+        return false;
+    }
+
+    // The string between the quotes at offsets[k] and offsets[k + 1]
+    bool stringAt(size_t k, std::string_view& out) {
+        std::string_view raw = text.substr(pos[k] + 1, pos[k + 1] - pos[k] - 1);
+        if (raw.find('\\') == std::string_view::npos) {
+            out = raw;
+            return true;
+        }
+        if (!parser.parse(text.substr(pos[k], pos[k + 1] - pos[k] + 1))) {
+            return fail(parser.getError(), pos[k] + parser.getOffset());
+        }
+        out = decoded;
+        return true;
+    }
+
+    bool scalar(std::string_view field, std::string_view value, size_t at) {
+        if (isPlainInteger(value)) {
+            record.number(field, value);
+            return true;
+        }
+        if (!parser.parse(value)) return fail(parser.getError(), at + parser.getOffset());
+        if (kind == Kind::Number) record.number(field, decoded);
+        return true;
+    }
+
+    // Index of the offset closing the container opened at offsets[k]
+    size_t matching(size_t k, size_t count) {
+        int depth = 0;
+        for (; k < count; k++) {
+            char c = text[pos[k]];
+            if (c == '"') k++;
+            else if (c == '{' || c == '[') depth++;
+            else if ((c == '}' || c == ']') && --depth == 0) return k;
+        }
+        return count;
+    }
+
+public:
+    StructuralRecordReader() : parser(*this) {}
+
+    void stringValue(std::string_view value) override { kind = Kind::String; decoded = value; }
+    void numberValue(std::string_view value) override { kind = Kind::Number; decoded = value; }
+    void boolValue(bool) override { kind = Kind::Other; }
+    void nullValue() override { kind = Kind::Other; }
+
+    const std::string& getError() const { return error; }
+    size_t getErrorOffset() const { return errorAt; }
+
+    // offsets[0, count) are the record's structurals, from its opening to
+    // its closing brace.
+    bool read(std::string_view source, const uint32_t* offsets, size_t count, Section section,
+              const BookSink& onBook, const UserSink& onUser) {
+        text = source;
+        pos = offsets;
+        record.reset(section);
+        auto at = [&](size_t k) { return text[pos[k]]; };
+        auto blankBetween = [&](size_t k) { return isBlank(text.substr(pos[k - 1] + 1, pos[k] - pos[k - 1] - 1)); };
+
+        size_t k = 1;
+        if (count == 2 && at(1) == '}' && blankBetween(1)) {
+            record.finish(onBook, onUser);
+            return true;
+        }
+        while (true) {
+            if (k + 2 >= count || at(k) != '"' || at(k + 1) != '"' || at(k + 2) != ':' || !blankBetween(k) ||
+                !blankBetween(k + 2)) {
+                return fail("Expected a key", pos[std::min(k, count - 1)]);
+            }
+            std::string_view field;
+            if (!stringAt(k, field)) return false;
+            std::string fieldName(field);
+            k += 3;
+
+            std::string_view gap = trim(text.substr(pos[k - 1] + 1, pos[k] - pos[k - 1] - 1));
+            bool isScalar = !gap.empty();
+            if (isScalar) {
+                if (!scalar(fieldName, gap, gap.data() - text.data())) return false;
+            } else if (at(k) == '"') {
+                if (k + 1 >= count) return fail("Unterminated string", pos[k]);
+                std::string_view value;
+                if (!stringAt(k, value)) return false;
+                // Only decoded strings live outside the chunk's text
+                record.text(fieldName, value, value.data() != decoded.data());
+                k += 2;
+            } else if (at(k) == '{' || at(k) == '[') {
+                size_t close = matching(k, count);
+                if (close >= count - 1) return fail("Unbalanced brackets", pos[k]);
+                if (!parser.parse(text.substr(pos[k], pos[close] - pos[k] + 1))) {
+                    return fail(parser.getError(), pos[k] + parser.getOffset());
+                }
+                k = close + 1;
+            } else {
+                return fail("Expected a value", pos[k]);
+            }
+
+            if (k >= count || (!isScalar && !blankBetween(k))) return fail("Expected ',' or '}'", pos[std::min(k, count - 1)]);
+            if (at(k) == ',') {
+                k++;
+            } else if (at(k) == '}' && k == count - 1) {
+                record.finish(onBook, onUser);
+                return true;
+            } else {
+                return fail("Expected ',' or '}'", pos[k]);
+            }
+        }
+    }
+};
+
+struct RecordSpan {
+    size_t first;  // index of the opening brace in the chunk's structurals
+    size_t last;   // index of the closing brace
+    Section section;
+};
+
+// Finds where catalog records start and end by walking structural offsets,
+// tracking only nesting and the top-level keys. State carries over from one
+// block to the next. Text outside the records is not validated.
+class RecordSplitter {
+private:
+    static constexpr size_t MAX_KEY = 16;
+
+    int depth = 0;
+    bool inString = false;
+    bool malformed = false;
+    size_t stringStart = 0;
+    std::string lastString;  // last string at the top level of the root object
+    std::string lastKey;
+    Section section = Section::None;
+    size_t recordStart = NONE;  // index of an unfinished record's opening brace
+
+public:
+    static const size_t NONE = (size_t)-1;
+
+    void scan(std::string_view text, const std::vector<uint32_t>& offsets, size_t from,
+              std::vector<RecordSpan>& records) {
+        for (size_t k = from; k < offsets.size(); k++) {
+            size_t p = offsets[k];
+            char c = text[p];
+            if (c == '"') {
+                if (!inString) {
+                    stringStart = p + 1;
+                } else if (depth == 1) {
+                    lastString = std::string(text.substr(stringStart, std::min(p - stringStart, MAX_KEY)));
+                }
+                inString = !inString;
+                continue;
+            }
+
+            switch (c) {
+                case ':':
+                    if (depth == 1) lastKey = lastString;
+                    break;
+                case '{':
+                case '[':
+                    depth++;
+                    if (depth == 2) {
+                        section = c != '[' ? Section::None
+                                  : lastKey == "books" ? Section::Books
+                                  : lastKey == "users" ? Section::Users : Section::None;
+                    } else if (depth == 3 && c == '{' && section != Section::None) {
+                        recordStart = k;
+                    }
+                    break;
+                case '}':
+                case ']':
+                    if (depth == 3 && recordStart != NONE) {
+                        records.push_back({recordStart, k, section});
+                        recordStart = NONE;
+                    }
+                    if (--depth < 0) malformed = true;
+                    break;
+            }
+        }
+    }
+
+    // First byte still needed: an unfinished record or top-level string.
+    size_t keepFrom(std::string_view text, const std::vector<uint32_t>& offsets) const {
+        if (recordStart != NONE) return offsets[recordStart];
+        if (inString && depth == 1) return stringStart - 1;
+        return text.size();
+    }
+
+    // The window now starts at byte `bytes`, structural `index`
+    void rebase(size_t bytes, size_t index) {
+        if (recordStart != NONE) recordStart -= index;
+        if (inString) stringStart -= bytes;
+    }
+
+    bool complete() const {
+        return depth == 0 && !inString && !malformed;
+    }
+};
+
+// A window of the mapped file, its structurals and the records found in it.
+// Tasks share it and read disjoint ranges of its records; the last one to
+// finish releases the bytes no later window needs.
+struct Chunk {
+    std::string_view text;
+    std::vector<uint32_t> offsets;
+    std::vector<RecordSpan> records;
+    size_t fileOffset = 0;
+    const MappedFile* file = nullptr;
+    size_t consumed = 0;
+
+    ~Chunk() {
+        if (file) file->release(fileOffset, fileOffset + consumed);
+    }
+};
+
+struct TaskResult {
+    std::vector<Book> books;
+    std::vector<User> users;
+    std::string error;
+};
+
+struct Task {
+    std::shared_ptr<const Chunk> chunk;
+    size_t first;
+    size_t last;
+    TaskResult* result;
+};
+
+// Bounded so the reader cannot run arbitrarily far ahead of the parsers.
+class TaskQueue {
+private:
+    std::queue<Task> tasks;
+    std::mutex lock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    const size_t capacity;
+    bool closed = false;
+
+public:
+    explicit TaskQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(Task task) {
+        std::unique_lock<std::mutex> guard(lock);
+        notFull.wait(guard, [this] { return tasks.size() < capacity; });
+        tasks.push(std::move(task));
+        notEmpty.notify_one();
+    }
+
+    bool pop(Task& task) {
+        std::unique_lock<std::mutex> guard(lock);
+        notEmpty.wait(guard, [this] { return closed || !tasks.empty(); });
+        if (tasks.empty()) return false;
+        task = std::move(tasks.front());
+        tasks.pop();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> guard(lock);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+const size_t RECORDS_PER_TASK = 512;
+
+// On each worker: build the task's records from their structurals
+void parseTasks(TaskQueue& queue) {
+    TaskResult* current = nullptr;
+    BookSink onBook = [&current](Book&& b) { current->books.push_back(std::move(b)); };
+    UserSink onUser = [&current](User&& u) { current->users.push_back(std::move(u)); };
+    StructuralRecordReader reader;
+
+    Task task;
+    while (queue.pop(task)) {
+        current = task.result;
+        const Chunk& chunk = *task.chunk;
+        for (size_t r = task.first; r < task.last; r++) {
+            const RecordSpan& span = chunk.records[r];
+            if (!reader.read(chunk.text, chunk.offsets.data() + span.first, span.last - span.first + 1,
+                             span.section, onBook, onUser)) {
+                current->error = "byte " + std::to_string(chunk.fileOffset + reader.getErrorOffset()) + ": " +
+                                 reader.getError();
+                break;
+            }
+        }
+        task.chunk.reset();
+    }
+}
+
+const size_t RELEASE_STEP = 1 << 20;
+
+// Streams one document into the library and reports what was loaded. Parts
+// of a mapped `source` are released as the parse moves past them.
+bool loadDocument(Library& library, const std::string& name, const MappedFile* source,
+                  const std::function<bool(JsonStreamParser&)>& parse) {
+    int books = 0;
+    int users = 0;
+    size_t released = 0;
+    JsonStreamParser* progress = nullptr;
+    auto recordDone = [&]() {
+        if (source && progress->getOffset() - released >= RELEASE_STEP) {
+            source->release(released, progress->getOffset());
+            released = progress->getOffset();
+        }
+    };
+    CatalogHandler handler([&](Book&& b) { library.addBook(b); books++; recordDone(); },
+                           [&](User&& u) { library.addUser(u); users++; recordDone(); }, source);
+    JsonStreamParser parser(handler);
+    progress = &parser;
+    bool ok = parse(parser);
+
+    std::cout << "Loaded " << books << " books from file\n";
+    std::cout << "Loaded " << users << " users from file\n";
+    if (!ok) {
+        std::cerr << "Error: " << name << " at byte " << parser.getOffset() << ": " << parser.getError() << std::endl;
+    }
+    return ok;
+}
+
+}
+
+bool DataLoader::loadFromFile(Library& library, const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+    return loadDocument(library, filename, &file, [&](JsonStreamParser& parser) { return parser.parse(file.text()); });
+}
+
+bool DataLoader::loadFromStream(Library& library, std::istream& in, const std::string& name) {
+    return loadDocument(library, name, nullptr, [&](JsonStreamParser& parser) { return parser.parse(in); });
+}
+
+bool DataLoader::parseFileParallel(const std::string& filename, int threads,
+                                   std::vector<Book>& books, std::vector<User>& users, size_t blockSize,
+                                   bool copyFile) {
+    MappedFile file;
+    if (!(copyFile ? file.load(filename) : file.open(filename))) {
+        std::cerr << "Error: Could not open " << filename << std::endl;
+        return false;
+    }
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    TaskQueue queue((size_t)threads * 4);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(parseTasks, std::ref(queue));
+    }
+
+    // On this thread: grow a window over the mapping one block at a time,
+    // index the new block's structurals and hand the window's complete
+    // records to the workers. The window then restarts at the first
+    // unfinished record. Records are parsed in place; nothing is copied
+    // until strings enter a Book or User.
+    std::deque<TaskResult> results;  // in file order; deque keeps them in place
+    JsonStructuralIndex::State indexState;
+    RecordSplitter splitter;
+    std::string_view input = file.text();
+    std::vector<uint32_t> offsets;  // relative to the window
+    size_t windowStart = 0;
+    size_t scanned = 0;
+    while (true) {
+        size_t indexed = offsets.size();
+        size_t got = std::min(blockSize, input.size() - windowStart - scanned);
+        std::string_view window = input.substr(windowStart, scanned + got);
+
+        auto chunk = std::make_shared<Chunk>();
+        JsonStructuralIndex::index(window.data() + scanned, got, (uint32_t)scanned, indexState, offsets);
+        splitter.scan(window, offsets, indexed, chunk->records);
+
+        size_t keepBytes = splitter.keepFrom(window, offsets);
+        size_t keepIndex = std::lower_bound(offsets.begin(), offsets.end(), (uint32_t)keepBytes) - offsets.begin();
+        std::vector<uint32_t> carryOffsets(offsets.begin() + keepIndex, offsets.end());
+        for (auto& offset : carryOffsets) offset -= (uint32_t)keepBytes;
+
+        if (!chunk->records.empty()) {
+            chunk->text = window;
+            chunk->offsets = std::move(offsets);
+            chunk->fileOffset = windowStart;
+            chunk->file = &file;
+            chunk->consumed = keepBytes;
+            for (size_t first = 0; first < chunk->records.size(); first += RECORDS_PER_TASK) {
+                results.emplace_back();
+                queue.push({chunk, first, std::min(first + RECORDS_PER_TASK, chunk->records.size()), &results.back()});
+            }
+        }
+        offsets = std::move(carryOffsets);
+        splitter.rebase(keepBytes, keepIndex);
+        windowStart += keepBytes;
+        scanned = window.size() - keepBytes;
+
+        if (got == 0) break;
+    }
+
+    queue.close();
+    for (auto& worker : workers) worker.join();
+
+    // Merge in file order, stopping at the first bad record
+    for (auto& result : results) {
+        books.insert(books.end(), std::make_move_iterator(result.books.begin()),
+                     std::make_move_iterator(result.books.end()));
+        users.insert(users.end(), std::make_move_iterator(result.users.begin()),
+                     std::make_move_iterator(result.users.end()));
+        if (!result.error.empty()) {
+            std::cerr << "Error: " << filename << " at " << result.error << std::endl;
+            return false;
+        }
+    }
+    if (indexState.controlCharAt != JsonStructuralIndex::NONE) {
+        std::cerr << "Error: " << filename << ": control character in a string" << std::endl;
+        return false;
+    }
+    if (!splitter.complete() || indexState.inString) {
+        std::cerr << "Error: " << filename << " at byte " << input.size()
+                  << ": Unexpected end of input" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool DataLoader::loadFromFileParallel(Library& library, const std::string& filename, int threads) {
+    std::vector<Book> books;
+    std::vector<User> users;
+    if (!parseFileParallel(filename, threads, books, users)) {
+        std::cerr << "Error: " << filename << " was not loaded" << std::endl;
+        return false;
+    }
+
+    size_t bookCount = books.size();
+    library.addBooks(std::move(books));
+    for (const auto& user : users) {
+        library.addUser(user);
+    }
+
+    std::cout << "Loaded " << bookCount << " books from file\n";
+    std::cout << "Loaded " << users.size() << " users from file\n";
+    return true;
+}
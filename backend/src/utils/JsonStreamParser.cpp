@@ -0,0 +1,303 @@
+#include "../../include/utils/JsonStreamParser.h"
+
+static bool isDigit(int c) {
+    return c >= '0' && c <= '9';
+}
+
+JsonStreamParser::JsonStreamParser(JsonHandler& handler, size_t bufferSize)
+    : handler(handler), buffer(bufferSize > 0 ? bufferSize : 1),
+      base(nullptr), pos(nullptr), end(nullptr), input(nullptr), consumed(0) {}
+
+bool JsonStreamParser::refill() {
+    if (!input) return false;
+    consumed += end - base;
+    input->read(buffer.data(), buffer.size());
+    size_t n = (size_t)input->gcount();
+    base = pos = buffer.data();
+    end = pos + n;
+    return n > 0;
+}
+
+int JsonStreamParser::peek() {
+    if (pos == end && !refill()) return -1;
+    return (unsigned char)*pos;
+}
+
+int JsonStreamParser::next() {
+    int c = peek();
+    if (c >= 0) pos++;
+    return c;
+}
+
+bool JsonStreamParser::skipWhitespace() {
+    while (true) {
+        int c = peek();
+        if (c < 0) return false;
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return true;
+        pos++;
+    }
+}
+
+bool JsonStreamParser::fail(const string& message) {
+    if (error.empty()) error = message;
+    return false;
+}
+
+void JsonStreamParser::appendUtf8(unsigned code) {
+    if (code < 0x80) {
+        scratch.push_back((char)code);
+    } else if (code < 0x800) {
+        scratch.push_back((char)(0xC0 | (code >> 6)));
+        scratch.push_back((char)(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        scratch.push_back((char)(0xE0 | (code >> 12)));
+        scratch.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+        scratch.push_back((char)(0x80 | (code & 0x3F)));
+    } else {
+        scratch.push_back((char)(0xF0 | (code >> 18)));
+        scratch.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+        scratch.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+        scratch.push_back((char)(0x80 | (code & 0x3F)));
+    }
+}
+
+bool JsonStreamParser::parseHex4(unsigned& code) {
+    code = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = next();
+        code <<= 4;
+        if (isDigit(c)) code |= c - '0';
+        else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return fail("Invalid \\u escape");
+    }
+    return true;
+}
+
+bool JsonStreamParser::parseEscape() {
+    int c = next();
+    switch (c) {
+        case '"': scratch.push_back('"'); return true;
+        case '\\': scratch.push_back('\\'); return true;
+        case '/': scratch.push_back('/'); return true;
+        case 'b': scratch.push_back('\b'); return true;
+        case 'f': scratch.push_back('\f'); return true;
+        case 'n': scratch.push_back('\n'); return true;
+        case 'r': scratch.push_back('\r'); return true;
+        case 't': scratch.push_back('\t'); return true;
+        case 'u': break;
+        default: return fail("Invalid escape sequence");
+    }
+
+    unsigned code;
+    if (!parseHex4(code)) return false;
+    if (code >= 0xDC00 && code <= 0xDFFF) return fail("Unpaired surrogate in \\u escape");
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        // A high surrogate must be followed by an escaped low surrogate
+        unsigned low;
+        if (next() != '\\' || next() != 'u' || !parseHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+            return fail("Unpaired surrogate in \\u escape");
+        }
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+    }
+    appendUtf8(code);
+    return true;
+}
+
+// Called after the opening quote; leaves the unescaped text in `token`.
+// A string with no escapes that lies within the current buffer is not
+// copied: token points into the input.
+bool JsonStreamParser::parseString() {
+    const char* run = pos;
+    while (run < end && *run != '"' && *run != '\\' && (unsigned char)*run >= 0x20) run++;
+    if (run < end && *run == '"') {
+        token = string_view(pos, run - pos);
+        pos = run + 1;
+        return true;
+    }
+
+    scratch.clear();
+    while (true) {
+        if (pos == end && !refill()) return fail("Unterminated string");
+
+        // Copy the run of plain bytes in one go
+        const char* run = pos;
+        while (run < end && *run != '"' && *run != '\\' && (unsigned char)*run >= 0x20) run++;
+        scratch.append(pos, run);
+        pos = run;
+        if (pos == end) continue;
+
+        char c = *pos++;
+        if (c == '"') {
+            token = scratch;
+            return true;
+        }
+        if (c != '\\') return fail("Control character in string");
+        if (!parseEscape()) return false;
+    }
+}
+
+bool JsonStreamParser::parseNumber(int first) {
+    scratch.clear();
+    scratch.push_back((char)first);
+
+    int c = first;
+    if (c == '-') {
+        c = next();
+        if (!isDigit(c)) return fail("Invalid number");
+        scratch.push_back((char)c);
+    }
+    if (c == '0') {
+        if (isDigit(peek())) return fail("Leading zeros are not allowed");
+    } else {
+        while (isDigit(peek())) scratch.push_back((char)next());
+    }
+
+    if (peek() == '.') {
+        scratch.push_back((char)next());
+        if (!isDigit(peek())) return fail("Invalid number");
+        while (isDigit(peek())) scratch.push_back((char)next());
+    }
+    if (peek() == 'e' || peek() == 'E') {
+        scratch.push_back((char)next());
+        if (peek() == '+' || peek() == '-') scratch.push_back((char)next());
+        if (!isDigit(peek())) return fail("Invalid number");
+        while (isDigit(peek())) scratch.push_back((char)next());
+    }
+
+    handler.numberValue(scratch);
+    return true;
+}
+
+bool JsonStreamParser::parseLiteral(const char* word) {
+    for (const char* p = word; *p; p++) {
+        if (next() != *p) return fail("Invalid literal");
+    }
+    return true;
+}
+
+bool JsonStreamParser::parseScalar(int c) {
+    if (c == '"') {
+        if (!parseString()) return false;
+        handler.stringValue(token);
+        return true;
+    }
+    if (c == '-' || isDigit(c)) return parseNumber(c);
+    if (c == 't') {
+        if (!parseLiteral("rue")) return false;
+        handler.boolValue(true);
+        return true;
+    }
+    if (c == 'f') {
+        if (!parseLiteral("alse")) return false;
+        handler.boolValue(false);
+        return true;
+    }
+    if (c == 'n') {
+        if (!parseLiteral("ull")) return false;
+        handler.nullValue();
+        return true;
+    }
+    return fail("Unexpected character");
+}
+
+// Iterative over an explicit container stack, so deep nesting cannot
+// overflow the call stack.
+bool JsonStreamParser::run() {
+    enum class State { Value, FirstKey, Key, FirstElement, AfterValue, Done };
+
+    stack.clear();
+    error.clear();
+    State state = State::Value;
+
+    while (true) {
+        bool more = skipWhitespace();
+        if (state == State::Done) return more ? fail("Unexpected data after document") : true;
+        if (!more) return fail("Unexpected end of input");
+
+        int c = next();
+        switch (state) {
+            case State::FirstElement:
+                if (c == ']') {
+                    stack.pop_back();
+                    handler.endArray();
+                    state = State::AfterValue;
+                    break;
+                }
+                // fall through
+            case State::Value:
+                if (c == '{' || c == '[') {
+                    if (stack.size() >= MAX_DEPTH) return fail("Nesting too deep");
+                    bool object = c == '{';
+                    stack.push_back(object ? Container::Object : Container::Array);
+                    if (object) handler.startObject();
+                    else handler.startArray();
+                    state = object ? State::FirstKey : State::FirstElement;
+                } else {
+                    if (!parseScalar(c)) return false;
+                    state = State::AfterValue;
+                }
+                break;
+
+            case State::FirstKey:
+                if (c == '}') {
+                    stack.pop_back();
+                    handler.endObject();
+                    state = State::AfterValue;
+                    break;
+                }
+                // fall through
+            case State::Key:
+                if (c != '"') return fail("Expected a string key");
+                if (!parseString()) return false;
+                handler.key(token);
+                if (!skipWhitespace() || next() != ':') return fail("Expected ':' after key");
+                state = State::Value;
+                break;
+
+            case State::AfterValue:
+                if (c == ',') {
+                    state = stack.back() == Container::Object ? State::Key : State::Value;
+                } else if (c == '}' && stack.back() == Container::Object) {
+                    stack.pop_back();
+                    handler.endObject();
+                } else if (c == ']' && stack.back() == Container::Array) {
+                    stack.pop_back();
+                    handler.endArray();
+                } else {
+                    return fail("Expected ',' or a closing bracket");
+                }
+                break;
+
+            case State::Done:
+                break;
+        }
+
+        if (state == State::AfterValue && stack.empty()) state = State::Done;
+    }
+}
+
+bool JsonStreamParser::parse(istream& in) {
+    input = &in;
+    consumed = 0;
+    base = pos = end = buffer.data();
+    bool ok = run();
+    input = nullptr;
+    return ok;
+}
+
+bool JsonStreamParser::parse(string_view text) {
+    input = nullptr;
+    consumed = 0;
+    base = pos = text.data();
+    end = text.data() + text.size();
+    return run();
+}
+
+const string& JsonStreamParser::getError() const {
+    return error;
+}
+
+size_t JsonStreamParser::getOffset() const {
+    return consumed + (pos - base);
+}
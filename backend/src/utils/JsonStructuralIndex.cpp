@@ -0,0 +1,141 @@
+#include "../../include/utils/JsonStructuralIndex.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const size_t BLOCK = 64;
+
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;       // { } [ ] : ,
+    uint64_t control;  // bytes below 0x20
+};
+
+void classifyScalar(const char* p, size_t n, BlockMasks& m) {
+    m = BlockMasks{0, 0, 0, 0};
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)p[i];
+        uint64_t bit = 1ull << i;
+        switch (c) {
+            case '"': m.quote |= bit; break;
+            case '\\': m.backslash |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': m.op |= bit; break;
+            default:
+                if (c < 0x20) m.control |= bit;
+        }
+    }
+}
+
+#if defined(__SSE2__)
+uint64_t bitsOf(__m128i matches, int lane) {
+    return (uint64_t)(uint16_t)_mm_movemask_epi8(matches) << (16 * lane);
+}
+
+// Exactly one 64-byte block, as four 16-byte lanes.
+void classifySse2(const char* p, BlockMasks& m) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i openBracket = _mm_set1_epi8('[');
+    const __m128i closeBracket = _mm_set1_epi8(']');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lastControl = _mm_set1_epi8(0x1F);
+
+    m = BlockMasks{0, 0, 0, 0};
+    for (int lane = 0; lane < 4; lane++) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * lane));
+        __m128i ops = _mm_or_si128(
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, openBrace), _mm_cmpeq_epi8(v, closeBrace)),
+                         _mm_or_si128(_mm_cmpeq_epi8(v, openBracket), _mm_cmpeq_epi8(v, closeBracket))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+
+        m.quote |= bitsOf(_mm_cmpeq_epi8(v, quote), lane);
+        m.backslash |= bitsOf(_mm_cmpeq_epi8(v, backslash), lane);
+        m.op |= bitsOf(ops, lane);
+        // Unsigned v <= 0x1F exactly when max(v, 0x1F) == 0x1F
+        m.control |= bitsOf(_mm_cmpeq_epi8(_mm_max_epu8(v, lastControl), lastControl), lane);
+    }
+}
+#endif
+
+int lowestBit(uint64_t x) {
+    return __builtin_ctzll(x);
+}
+
+// Bit i becomes the XOR of bits 0..i, turning quote positions into the
+// region between each opening quote and its closing quote.
+uint64_t prefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+}
+
+bool JsonStructuralIndex::simdEnabled() {
+#if defined(__SSE2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void JsonStructuralIndex::index(const char* text, size_t length, uint32_t offset, State& state,
+                                vector<uint32_t>& out, bool scalarOnly) {
+    for (size_t start = 0; start < length; start += BLOCK) {
+        size_t n = length - start < BLOCK ? length - start : BLOCK;
+        uint64_t valid = n == BLOCK ? ~0ull : (1ull << n) - 1;
+
+        BlockMasks m;
+#if defined(__SSE2__)
+        if (n == BLOCK && !scalarOnly) classifySse2(text + start, m);
+        else classifyScalar(text + start, n, m);
+#else
+        (void)scalarOnly;
+        classifyScalar(text + start, n, m);
+#endif
+
+        // Backslashes are rare, so escapes are resolved one backslash at a
+        // time; an escaped backslash escapes nothing
+        uint64_t escaped = 0;
+        if (state.escapeNext) {
+            escaped = 1;
+            state.escapeNext = false;
+        }
+        uint64_t backslashes = m.backslash & ~escaped;
+        while (backslashes) {
+            int i = lowestBit(backslashes);
+            backslashes &= backslashes - 1;
+            if ((size_t)i + 1 >= n) {
+                state.escapeNext = true;
+            } else {
+                escaped |= 1ull << (i + 1);
+                backslashes &= ~(1ull << (i + 1));
+            }
+        }
+
+        uint64_t quotes = m.quote & ~escaped & valid;
+        uint64_t inString = prefixXor(quotes) ^ (state.inString ? ~0ull : 0);
+        state.inString = (inString >> (n - 1)) & 1;
+
+        uint64_t badControl = m.control & inString & valid;
+        if (badControl && state.controlCharAt == NONE) {
+            state.controlCharAt = offset + start + lowestBit(badControl);
+        }
+
+        uint64_t structural = ((m.op & ~inString) | quotes) & valid;
+        while (structural) {
+            out.push_back(offset + (uint32_t)start + (uint32_t)lowestBit(structural));
+            structural &= structural - 1;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#include "../../include/utils/MappedFile.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+
+namespace {
+const char EMPTY_FILE[1] = {0};
+}
+
+MappedFile::MappedFile() : base(nullptr), mappedSize(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        base = EMPTY_FILE;
+        return true;
+    }
+
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        cerr << "Error: cannot map " << path << ": " << strerror(errno) << "\n";
+        return false;
+    }
+    madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    base = (const char*)mapping;
+    mappedSize = (size_t)st.st_size;
+    return true;
+}
+
+bool MappedFile::load(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    // The size is only a hint: a writer may still be changing the file, so
+    // whatever read() returns up to end of file is what gets parsed
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        copy.reserve((size_t)st.st_size);
+    }
+    char buffer[1 << 16];
+    ssize_t n;
+    while ((n = ::read(fd, buffer, sizeof(buffer))) != 0) {
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            cerr << "Error: cannot read " << path << ": " << strerror(errno) << "\n";
+            ::close(fd);
+            copy.clear();
+            return false;
+        }
+        copy.append(buffer, (size_t)n);
+    }
+    ::close(fd);
+
+    base = copy.empty() ? EMPTY_FILE : copy.data();
+    mappedSize = copy.size();
+    return true;
+}
+
+void MappedFile::close() {
+    if (base && mappedSize > 0 && copy.empty()) {
+        munmap((void*)base, mappedSize);
+    }
+    base = nullptr;
+    mappedSize = 0;
+    copy.clear();
+    copy.shrink_to_fit();
+}
+
+bool MappedFile::isOpen() const {
+    return base != nullptr;
+}
+
+string_view MappedFile::text() const {
+    return string_view(base ? base : EMPTY_FILE, mappedSize);
+}
+
+void MappedFile::release(size_t from, size_t to) const {
+    if (!copy.empty()) return;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t first = (from + page - 1) / page * page;
+    size_t last = (to < mappedSize ? to : mappedSize) / page * page;
+    if (first < last) {
+        madvise((void*)(base + first), last - first, MADV_DONTNEED);
+    }
+}
+
+bool MappedFile::contains(string_view part) const {
+    uintptr_t start = (uintptr_t)base;
+    uintptr_t at = (uintptr_t)part.data();
+    return mappedSize > 0 && at >= start && at + part.size() <= start + mappedSize;
+}
@@ -399,6 +399,34 @@ async function loadAllBooksForSearch() {
     }
 }
 
+// Type-ahead suggestions for the search box
+let suggestRequest = 0;
+document.getElementById('searchQuery').addEventListener('input', async (event) => {
+    const prefix = event.target.value.trim();
+    const list = document.getElementById('searchSuggestions');
+    const requestId = ++suggestRequest;
+
+    if (prefix.length < 2) {
+        list.innerHTML = '';
+        return;
+    }
+
+    try {
+        const response = await fetch(`${API_URL}/books/suggest?prefix=${encodeURIComponent(prefix)}&limit=8`);
+        const data = await response.json();
+        if (requestId !== suggestRequest || data.status !== 'success') return;
+
+        list.innerHTML = '';
+        data.data.forEach(suggestion => {
+            const option = document.createElement('option');
+            option.value = suggestion.text;
+            list.appendChild(option);
+        });
+    } catch (error) {
+        console.error('Error loading suggestions:', error);
+    }
+});
+
 async function searchBooks() {
     const query = document.getElementById('searchQuery').value;
     
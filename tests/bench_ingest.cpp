@@ -0,0 +1,124 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include "../include/services/Library.h"
+#include "../include/utils/DataLoader.h"
+#include "../include/utils/JsonStructuralIndex.h"
+#include "../include/utils/BookImporter.h"
+
+using namespace std;
+
+// Catalog ingest benchmark: indexes a synthetic catalog's structurals,
+// parses it with 1..N threads, bulk loads the last result into a Library, then
+// streams the same books as NDJSON through BookImporter into another one.
+//   bench_ingest [books=5000000] [maxThreads=hardware threads]
+
+static const char* CATEGORIES[] = {"Novel - Classic", "Novel - Science Fiction", "Comic - Crime",
+                                   "Poetry", "History", "Biography", "Reference", "Children"};
+static const char* WORDS[] = {"Silent", "River", "Empire", "Garden", "Winter", "Machine", "Letters",
+                              "Shadow", "Island", "Crown", "Night", "Journey", "Glass", "Harbor"};
+
+static void writeCatalog(const string& path, int books) {
+    ofstream out(path, ios::binary);
+    out << "{\n  \"books\": [\n";
+    string record;
+    for (int id = 1; id <= books; id++) {
+        record.clear();
+        record += "    {\"bookID\": " + to_string(id);
+        record += ", \"title\": \"";
+        record += WORDS[id % 14];
+        record += " ";
+        record += WORDS[(id / 14) % 14];
+        record += " " + to_string(id) + "\", \"author\": \"Author, ";
+        record += WORDS[(id / 7) % 14];
+        record += " " + to_string(id % 5000) + "\", \"isbn\": \"ISBN-" + to_string(id) + "\", \"category\": \"";
+        record += CATEGORIES[id % 8];
+        record += "\", \"type\": \"Novel\", \"copies\": 5, \"availableCopies\": " + to_string(id % 6);
+        record += ", \"cover\": \"http://covers.example.com/" + to_string(id) + ".jpg\"}";
+        record += id < books ? ",\n" : "\n";
+        out << record;
+    }
+    out << "  ],\n  \"users\": []\n}\n";
+}
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int books = argc > 1 ? atoi(argv[1]) : 5000000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : (int)max(1u, thread::hardware_concurrency());
+    const string path = "bench_catalog.json";
+
+    auto start = chrono::steady_clock::now();
+    writeCatalog(path, books);
+    cout << "Generated " << books << " books in " << secondsSince(start) << " s\n";
+
+    {
+        stringstream contents;
+        contents << ifstream(path, ios::binary).rdbuf();
+        string text = contents.str();
+        vector<uint32_t> offsets;
+        offsets.reserve(text.size() / 4);
+        for (bool scalarOnly : {false, true}) {
+            offsets.clear();
+            JsonStructuralIndex::State state;
+            start = chrono::steady_clock::now();
+            JsonStructuralIndex::index(text.data(), text.size(), 0, state, offsets, scalarOnly);
+            double seconds = secondsSince(start);
+            cout << "index  " << (scalarOnly || !JsonStructuralIndex::simdEnabled() ? "scalar" : "sse2  ") << "  "
+                 << offsets.size() << " structurals  " << seconds << " s  " << (long)(text.size() / seconds / 1e6)
+                 << " MB/s\n";
+        }
+    }
+
+    // Strings are interned process-wide, so a first pass warms the pool and
+    // every measured run does the same work
+    vector<Book> parsed;
+    vector<User> users;
+    DataLoader::parseFileParallel(path, maxThreads, parsed, users);
+
+    for (int threads = 1; threads <= maxThreads; threads++) {
+        parsed.clear();
+        users.clear();
+        start = chrono::steady_clock::now();
+        bool ok = DataLoader::parseFileParallel(path, threads, parsed, users);
+        double seconds = secondsSince(start);
+        cout << "parse  threads=" << threads << "  " << parsed.size() << " records  " << seconds << " s  "
+             << (long)(parsed.size() / seconds) << " records/s" << (ok ? "" : "  (FAILED)") << "\n";
+    }
+
+    Library library;
+    size_t count = parsed.size();
+    start = chrono::steady_clock::now();
+    library.addBooks(move(parsed));
+    double seconds = secondsSince(start);
+    cout << "bulk load  " << count << " books  " << seconds << " s  " << (long)(count / seconds) << " records/s\n";
+
+    // NDJSON upload, fed in 64 KB pieces as a request body would arrive
+    string ndjson;
+    for (const Book& b : library.getAllBooks()) {
+        ndjson += "{\"bookID\": " + to_string(b.getBookID()) + ", \"title\": \"" + b.getTitle() +
+                  "\", \"author\": \"" + b.getAuthor() + "\", \"isbn\": \"" + b.getISBN() +
+                  "\", \"category\": \"" + b.getCategory() + "\", \"copies\": " + to_string(b.getCopies()) + "}\n";
+    }
+    Library imported;
+    BookImporter importer(imported, BookImporter::Format::NDJSON);
+    start = chrono::steady_clock::now();
+    for (size_t pos = 0; pos < ndjson.size(); pos += 64 * 1024) {
+        importer.feed(string_view(ndjson).substr(pos, 64 * 1024));
+    }
+    ImportReport report = importer.finish();
+    seconds = secondsSince(start);
+    cout << "import  " << report.imported << " books  " << seconds << " s  " << (long)(report.imported / seconds)
+         << " records/s\n";
+
+    remove(path.c_str());
+    return 0;
+}
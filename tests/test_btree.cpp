@@ -2,8 +2,34 @@
 #include <cassert>
 #include <vector>
 #include <string>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <csignal>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include "../include/services/Library.h"
 #include "../include/data_structures/BTree.h"
+#include "../include/data_structures/RankedCounter.h"
+#include "../include/data_structures/Sketches.h"
+#include "../include/data_structures/RollingCounter.h"
+#include "../include/data_structures/TimingWheel.h"
+#include "../include/storage/WriteAheadLog.h"
+#include "../include/storage/Snapshot.h"
+#include "../include/storage/CatalogSegment.h"
+#include "../include/utils/JsonStreamParser.h"
+#include "../include/utils/JsonStructuralIndex.h"
+#include "../include/utils/MappedFile.h"
+#include "../include/services/CatalogWatcher.h"
+#include "../include/utils/BookImporter.h"
+#include "../include/utils/DataLoader.h"
 
 using namespace std;
 
@@ -157,6 +183,114 @@ void testBTreeLargeDataset() {
     }
 }
 
+void testBTreeBulkLoad() {
+    printTestHeader("B-Tree Bulk Load Test");
+
+    BTree<int> tree(3, [](const int& a, const int& b) {
+        if (a < b) return -1;
+        if (a > b) return 1;
+        return 0;
+    });
+
+    vector<int> sorted;
+    for (int i = 0; i < 1000; i++) {
+        sorted.push_back(i * 2);
+    }
+    tree.bulkLoad(sorted);
+
+    bool allFound = true;
+    for (int v : sorted) {
+        if (tree.search(v) == nullptr) {
+            allFound = false;
+            break;
+        }
+    }
+
+    tree.insert(7);
+    tree.insert(2001);
+    vector<int> traversed = tree.getAllElements();
+    bool ordered = traversed.size() == 1002;
+    for (size_t i = 1; i < traversed.size() && ordered; i++) {
+        ordered = traversed[i - 1] <= traversed[i];
+    }
+
+    if (allFound && ordered && tree.search(7) != nullptr) {
+        testPassed("Bulk loaded B-Tree is searchable and accepts inserts");
+    } else {
+        testFailed("Bulk loaded B-Tree is inconsistent");
+    }
+}
+
+void testBTreeRemove() {
+    printTestHeader("B-Tree Remove Test");
+
+    BTree<int> tree(2, [](const int& a, const int& b) {
+        if (a < b) return -1;
+        if (a > b) return 1;
+        return 0;
+    });
+
+    for (int i = 0; i < 200; i++) {
+        tree.insert(i);
+    }
+    bool removedAll = true;
+    for (int i = 0; i < 200; i += 2) {
+        removedAll = tree.remove(i) && removedAll;
+    }
+    bool missingRejected = !tree.remove(0) && !tree.remove(1000);
+
+    vector<int> remaining = tree.getAllElements();
+    bool onlyOdd = remaining.size() == 100;
+    for (size_t i = 0; i < remaining.size() && onlyOdd; i++) {
+        onlyOdd = remaining[i] == (int)(2 * i + 1);
+    }
+
+    if (removedAll && missingRejected && onlyOdd && tree.search(4) == nullptr && tree.search(5) != nullptr) {
+        testPassed("Removed keys are gone and the rest stay ordered");
+    } else {
+        testFailed("B-Tree remove left the tree inconsistent");
+    }
+}
+
+void testPrecomputedSortKeys() {
+    printTestHeader("Precomputed Sort Keys Test");
+
+    Book a(1, "The Hobbit", "Tolkien, J.R.R.", "ISBN001", "Fantasy", 1, 1);
+    Book b(2, "the hobbit", "TOLKIEN, J.R.R.", "ISBN002", "Fantasy", 1, 1);
+    Book c(3, "Beowulf", "Anonymous", "ISBN003", "Epic", 1, 1);
+
+    bool keys = a.getTitleKey() == "the hobbit" && a.getAuthorKey() == "tolkien, j.r.r.";
+    bool ties = Book::compareByTitle(a, b) == 0 && Book::compareByAuthor(a, b) == 0;
+    bool ordered = Book::compareByTitle(c, a) < 0 && Book::compareByAuthor(a, c) > 0;
+
+    if (keys && ties && ordered) {
+        testPassed("Comparators order by the precomputed lowercase keys");
+    } else {
+        testFailed("Precomputed sort keys compare incorrectly");
+    }
+}
+
+void testBookColdDetails() {
+    printTestHeader("Book Cold Details Test");
+
+    Book original(1, "Dracula", "Stoker, Bram", "ISBN-345", "Horror", 2, 2,
+                  "http://covers/dracula.jpg", "Novel", {"http://dl/dracula.epub"});
+    Book copy = original;
+    copy.borrowBook();
+
+    bool shared = &copy.getCoverImage() == &original.getCoverImage() &&
+                  &copy.getDownloadLinks() == &original.getDownloadLinks();
+    bool independent = copy.getAvailableCopies() == 1 && original.getAvailableCopies() == 2;
+    bool intact = copy.getISBN() == "ISBN-345" && copy.getDownloadLinks().size() == 1 &&
+                  copy.getTitle() == "Dracula" && Book().getCoverImage().empty();
+
+    if (shared && independent && intact) {
+        testPassed("Copies share cold details and keep their own counts");
+    } else {
+        testFailed("Cold book details were not shared correctly");
+    }
+}
+
 void testLibraryAddBooks() {
     printTestHeader("Library Add Books Test");
     
@@ -367,6 +501,49 @@ void testBookComparison() {
     }
 }
 
+void testStringInterning() {
+    printTestHeader("String Interning Test");
+
+    Book a(1, "Emma", "Austen, Jane", "ISBN001", "Novel - Romance", 1, 1);
+    Book b(2, "Persuasion", "Austen, Jane", "ISBN002", "novel - romance", 1, 1);
+    User u(1, "Alice", "alice@example.com", "Student");
+
+    StringPool& pool = StringPool::shared();
+    SharedStringTable& authors = SharedStringTable::authors();
+    Book lower(5, "Sanditon", "austen, jane", "", "Novel - Romance", 1, 1);
+    bool sameAuthor = a.getAuthorId() != nullptr && a.getAuthorId() == b.getAuthorId() &&
+                      &a.getAuthor() == &b.getAuthor() && a.getAuthor() == "Austen, Jane" &&
+                      lower.getAuthorId() != a.getAuthorId() &&
+                      lower.getAuthorId() == a.getAuthorId()->folded() && a.getAuthorKey() == "austen, jane";
+    bool foldedEqual = a.getCategoryId() != b.getCategoryId() &&
+                       pool.folded(a.getCategoryId()) == pool.folded(b.getCategoryId()) &&
+                       b.getCategory() == "novel - romance";
+    bool roleKept = u.getRole() == "Student" && u.getRoleId() == pool.intern("Student");
+    size_t pooled = pool.size();
+    size_t authorCount = authors.size();
+    bool textOwned;
+    {
+        // Authors are interned with their lowercase form and freed with their last book
+        Book unique(4, "A Title Seen Once", "An Author Seen Once", "", "Novel - Romance", 1, 1);
+        Book copy = unique;
+        textOwned = pool.size() == pooled && unique.getTitleKey() == "a title seen once" &&
+                    authors.size() == authorCount + 2 && copy.getAuthorId() == unique.getAuthorId();
+    }
+    bool authorReleased = authors.size() == authorCount;
+
+    Library lib;
+    lib.addBook(a);
+    lib.addBook(b);
+    lib.addBook(Book(3, "Dracula", "Stoker, Bram", "ISBN003", "Horror", 1, 1));
+
+    if (sameAuthor && foldedEqual && roleKept && textOwned && authorReleased && lib.searchBookByCategory("NOVEL - ROMANCE").size() == 2 &&
+        lib.searchBookByCategory("Unknown Category").empty()) {
+        testPassed("Repeated categories and authors share ids; unused authors are released");
+    } else {
+        testFailed("Interned fields did not round trip");
+    }
+}
+
 void testCaseInsensitiveSearch() {
     printTestHeader("Case-Insensitive Search Test");
     
@@ -385,6 +562,1186 @@ void testCaseInsensitiveSearch() {
     }
 }
 
+void testCategoryIndexCounts() {
+    printTestHeader("Category Index Counts Test");
+
+    Library lib;
+    lib.addBook(Book(1, "Dune", "Frank Herbert", "ISBN001", "Sci-Fi", 1, 1));
+    lib.addBook(Book(2, "Hyperion", "Dan Simmons", "ISBN002", "Sci-Fi", 2, 2));
+    lib.addBook(Book(3, "Dracula", "Bram Stoker", "ISBN003", "Horror", 1, 1));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+
+    lib.borrowBook(101, 1);
+    vector<CategoryStats> afterBorrow = lib.getCategoryStats();
+
+    lib.returnBook(101, 1);
+    lib.addBook(Book(3, "Dracula", "Bram Stoker", "ISBN003", "Sci-Fi", 1, 1));
+    vector<CategoryStats> afterMove = lib.getCategoryStats();
+
+    bool borrowCounted = afterBorrow.size() == 2 &&
+                         StringPool::shared().str(afterBorrow[1].category) == "Sci-Fi" &&
+                         afterBorrow[1].availableBooks == 1 && afterBorrow[1].borrowedBooks == 1;
+    bool moved = afterMove.size() == 1 && afterMove[0].totalBooks == 3 && afterMove[0].availableBooks == 3;
+    auto sciFi = lib.searchBookByCategory("sci-fi");
+
+    if (borrowCounted && moved && sciFi.size() == 3 && sciFi[0].getTitle() == "Dracula") {
+        testPassed("Category counters follow borrows, returns and re-categorized books");
+    } else {
+        testFailed("Category index counts are out of date");
+    }
+}
+
+void testTrigramSearch() {
+    printTestHeader("Trigram Search Test");
+
+    const vector<string> words = {"Shadow", "River", "Night", "Garden", "Storm", "Crown", "Silver", "Winter"};
+    Library lib;
+    for (int i = 0; i < 400; i++) {
+        string title = words[i % 8] + " of the " + words[(i / 8) % 8] + " " + to_string(i);
+        lib.addBook(Book(i + 1, title, "Author " + words[(i * 3) % 8], "ISBN", "Fiction", 1, 1));
+    }
+    lib.addBook(Book(7, "Completely Renamed", "Author Storm", "ISBN", "Fiction", 1, 1));
+
+    bool matchesScan = true;
+    for (const string& query : {string("the"), string("WINTER"), string("r of"), string("ver 1"), string("ri"), string("zzz")}) {
+        string lower = query;
+        transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+        vector<int> expected;
+        for (const auto& b : lib.getAllBooks()) {
+            if (b.getTitleKey().find(lower) != string::npos) expected.push_back(b.getBookID());
+        }
+        vector<int> actual;
+        for (const auto& b : lib.searchBookByTitle(query)) {
+            actual.push_back(b.getBookID());
+        }
+        matchesScan = matchesScan && actual == expected;
+    }
+
+    bool renamed = lib.searchBookByTitle("renamed").size() == 1 && lib.searchBookByTitle("Shadow of the Shadow 7").empty();
+    bool byAuthor = lib.searchBookByAuthor("author sto").size() == 51;
+
+    if (matchesScan && renamed && byAuthor) {
+        testPassed("Trigram search agrees with a full scan");
+    } else {
+        testFailed("Trigram search results differ from a full scan");
+    }
+}
+
+void testRankedFullTextSearch() {
+    printTestHeader("Ranked Full-Text Search Test");
+
+    const vector<string> words = {"war", "peace", "river", "night", "garden", "storm", "crown", "winter", "king", "sea"};
+    FullTextIndex index;
+    unsigned seed = 7;
+    auto next = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7fff; };
+    vector<string> texts(1);
+    for (int id = 1; id <= 3000; id++) {
+        string text;
+        int length = 2 + next() % 6;
+        for (int w = 0; w < length; w++) text += words[next() % words.size()] + " ";
+        index.add(id, text);
+        texts.push_back(text);
+    }
+    // Enough removals to trigger compaction
+    for (int id = 1; id <= 3000; id++) {
+        if (id % 4 != 0) index.remove(id, texts[id]);
+    }
+
+    // Top-k with WAND pruning must equal the head of an exhaustive ranking
+    bool prefixMatches = true;
+    for (const string& query : {string("war peace"), string("Storm KING sea"), string("night")}) {
+        vector<ScoredBook> top = index.search(query, 10);
+        vector<ScoredBook> all = index.search(query, 100000);
+        prefixMatches = prefixMatches && top.size() == 10 && index.size() == 750;
+        for (size_t i = 0; i < top.size() && prefixMatches; i++) {
+            prefixMatches = top[i].bookID == all[i].bookID && top[i].score == all[i].score && top[i].bookID % 4 == 0;
+        }
+    }
+
+    Library lib;
+    lib.addBook(Book(1, "The Old Man and the Sea", "Ernest Hemingway", "ISBN001", "Fiction", 1, 1));
+    lib.addBook(Book(2, "Sea of Tranquility", "Emily St. John Mandel", "ISBN002", "Science Fiction", 1, 1));
+    lib.addBook(Book(3, "Moby Dick", "Herman Melville", "ISBN003", "Adventure", 1, 1));
+    vector<ScoredBook> ranked = lib.rankBooks("hemingway sea", 2);
+
+    if (prefixMatches && ranked.size() == 2 && ranked[0].bookID == 1 && ranked[1].bookID == 2 &&
+        lib.rankBooks("whale", 5).empty()) {
+        testPassed("WAND top-k matches exhaustive BM25 ranking");
+    } else {
+        testFailed("Ranked search returned the wrong top results");
+    }
+}
+
+void testAutocompleteTrie() {
+    printTestHeader("Autocomplete Trie Test");
+
+    AutocompleteTrie trie;
+    trie.add("The Hobbit", 5);
+    trie.add("The Hound of the Baskervilles", 9);
+    trie.add("The Hours", 1);
+    trie.add("Hamlet", 3);
+    trie.add("The Hobbit", 2);
+    trie.add("Thermodynamics", 0);
+    trie.remove("The Hours", 1);
+    trie.addWeight("Hamlet", 20);
+
+    vector<Completion> the = trie.complete("THE HO", 5);
+    vector<Completion> all = trie.complete("", 2);
+    vector<Completion> split = trie.complete("the", 10);
+
+    bool ranked = the.size() == 2 && the[0].text == "The Hound of the Baskervilles" &&
+                  the[1].text == "The Hobbit" && the[1].weight == 7;
+    bool global = all.size() == 2 && all[0].text == "Hamlet" && all[1].weight == 9;
+    bool removed = trie.size() == 4 && split.size() == 3 && split[2].text == "Thermodynamics" &&
+                   trie.complete("the hours", 5).empty();
+
+    Library lib;
+    lib.addBook(Book(1, "Dune", "Frank Herbert", "ISBN001", "Sci-Fi", 3, 3));
+    lib.addBook(Book(2, "Dune Messiah", "Frank Herbert", "ISBN002", "Sci-Fi", 3, 3));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lib.borrowBook(101, 2);
+    vector<Completion> titles = lib.suggestTitles("du", 5);
+    vector<Completion> authors = lib.suggestAuthors("fr", 5);
+
+    if (ranked && global && removed && titles.size() == 2 && titles[0].text == "Dune Messiah" &&
+        authors.size() == 1 && authors[0].weight == 1) {
+        testPassed("Completions are ranked by popularity and follow updates");
+    } else {
+        testFailed("Autocomplete returned the wrong completions");
+    }
+}
+
+void testFuzzyTitleSearch() {
+    printTestHeader("Fuzzy Title Search Test");
+
+    Library lib;
+    lib.addBook(Book(1, "Pride and Prejudice", "Jane Austen", "ISBN001", "Romance", 1, 1));
+    lib.addBook(Book(2, "The Brothers Karamazov", "Fyodor Dostoevsky", "ISBN002", "Classic", 1, 1));
+    lib.addBook(Book(3, "Crime and Punishment", "Fyodor Dostoevsky", "ISBN003", "Classic", 1, 1));
+    lib.addBook(Book(4, "Prince Caspian", "C. S. Lewis", "ISBN004", "Fantasy", 1, 1));
+
+    auto typo = lib.searchBookByTitleFuzzy("pride prejudise");
+    auto twoEdits = lib.searchBookByTitleFuzzy("brothrs karamzov");
+    auto oneOnly = lib.searchBookByTitleFuzzy("brthrs karamazov", 1);
+    auto shortWord = lib.searchBookByTitleFuzzy("te");
+
+    // Brute force over a vocabulary: BK-tree lookup must find exactly the words within distance
+    FuzzyTermIndex index;
+    const vector<string> vocabulary = {"garden", "warden", "harden", "gardens", "burden", "golden", "sudden", "gander"};
+    for (size_t i = 0; i < vocabulary.size(); i++) {
+        index.add((int)i, vocabulary[i]);
+    }
+    vector<FuzzyMatch> near = index.search("garden", 2);
+    size_t expected = 0;
+    for (const auto& word : vocabulary) {
+        if (FuzzyTermIndex::levenshtein("garden", word) <= 2) expected++;
+    }
+
+    if (typo.size() == 1 && typo[0].getBookID() == 1 && twoEdits.size() == 1 && twoEdits[0].getBookID() == 2 &&
+        oneOnly.empty() && shortWord.empty() && near.size() == expected && near[0].distance == 0) {
+        testPassed("Misspelled titles are found within the allowed edit distance");
+    } else {
+        testFailed("Fuzzy title search returned the wrong books");
+    }
+}
+
+void testQueryPlanner() {
+    printTestHeader("Combined Filter Query Planner Test");
+
+    Library lib;
+    for (int i = 1; i <= 60; i++) {
+        string title = (i % 20 == 0 ? "Rare Atlas " : "Common Volume ") + to_string(i);
+        string author = i % 3 == 0 ? "Ursula Le Guin" : "Terry Pratchett";
+        string category = i % 10 == 0 ? "Fantasy" : "Science";
+        lib.addBook(Book(i, title, author, "ISBN" + to_string(i), category, 1, i % 4 == 0 ? 0 : 1));
+    }
+
+    BookQuery rare;
+    rare.title = "atlas";
+    rare.category = "fantasy";
+    BookQuery byAuthor;
+    byAuthor.author = "le guin";
+    byAuthor.category = "FANTASY";
+    byAuthor.availableOnly = true;
+    BookQuery shortTitle;
+    shortTitle.title = "1";
+    shortTitle.author = "te";
+    BookQuery unknown;
+    unknown.title = "common";
+    unknown.category = "Poetry";
+
+    bool plans = lib.planBookQuery(rare).path == BookAccessPath::TitleTrigrams &&
+                 lib.planBookQuery(byAuthor).path == BookAccessPath::Category &&
+                 lib.planBookQuery(shortTitle).path == BookAccessPath::FullScan &&
+                 lib.planBookQuery(unknown).estimatedCandidates == 0;
+
+    // Every query must agree with a brute-force filter over all books
+    bool agrees = true;
+    for (const BookQuery& q : {rare, byAuthor, shortTitle, unknown}) {
+        vector<int> expected;
+        for (const Book& b : lib.getAllBooks()) {
+            string title = b.getTitle(), author = b.getAuthor(), category = b.getCategory();
+            for (string* s : {&title, &author, &category}) {
+                transform(s->begin(), s->end(), s->begin(), ::tolower);
+            }
+            string wanted = q.category;
+            transform(wanted.begin(), wanted.end(), wanted.begin(), ::tolower);
+            if (title.find(q.title) != string::npos && author.find(q.author) != string::npos &&
+                (wanted.empty() || category == wanted) && (!q.availableOnly || b.getAvailableCopies() > 0)) {
+                expected.push_back(b.getBookID());
+            }
+        }
+        vector<int> actual;
+        for (const Book& b : lib.findBooks(q)) actual.push_back(b.getBookID());
+        sort(expected.begin(), expected.end());
+        sort(actual.begin(), actual.end());
+        agrees = agrees && actual == expected;
+    }
+
+    if (plans && agrees && lib.findBooks(rare).size() == 3) {
+        testPassed("Combined filters use the most selective index and match a full scan");
+    } else {
+        testFailed("Query planner chose the wrong path or returned the wrong books");
+    }
+}
+
+void testRankedCounterTopK() {
+    printTestHeader("Incremental Top-K Ranking Test");
+
+    // Random +1/-1 steps and resets, checked against a plain map after each one
+    RankedCounter<int> ranking;
+    vector<int> model(50, 0);
+    vector<bool> present(50, false);
+    unsigned seed = 7;
+    bool consistent = true;
+    for (int step = 0; step < 5000 && consistent; step++) {
+        seed = seed * 1103515245 + 12345;
+        int key = (seed >> 8) % 50;
+        int action = (seed >> 20) % 10;
+        if (action < 6) {
+            ranking.add(key, 1);
+            model[key]++;
+        } else if (action < 9 && model[key] > 0) {
+            ranking.add(key, -1);
+            model[key]--;
+        } else {
+            ranking.set(key, 0);
+            model[key] = 0;
+        }
+        present[key] = true;
+
+        vector<int> expected;
+        for (int k = 0; k < 50; k++) {
+            if (present[k]) expected.push_back(model[k]);
+        }
+        sort(expected.rbegin(), expected.rend());
+        expected.resize(min((size_t)5, expected.size()));
+
+        vector<pair<int, int>> top = ranking.top(5);
+        consistent = top.size() == expected.size() && ranking.count(key) == model[key];
+        for (size_t i = 0; i < top.size() && consistent; i++) {
+            consistent = top[i].second == expected[i] && model[top[i].first] == top[i].second;
+        }
+    }
+
+    Library lib;
+    lib.addBook(Book(1, "1984", "George Orwell", "ISBN001", "Dystopian", 5, 5));
+    lib.addBook(Book(2, "Emma", "Jane Austen", "ISBN002", "Romance", 5, 5));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lib.addUser(User(102, "Bob Jones", "bob@example.com", "Student"));
+    lib.addUser(User(103, "Carol White", "carol@example.com", "Student"));
+    lib.borrowBook(101, 1);
+    lib.borrowBook(101, 2);
+    lib.borrowBook(102, 2);
+    lib.returnBook(101, 1);
+    lib.returnBook(101, 2);
+
+    auto books = lib.getMostBorrowedBooks(5);
+    auto users = lib.getMostActiveUsers(2);
+
+    if (consistent && books.size() == 2 && books[0] == make_pair(2, 2) && books[1] == make_pair(1, 1) &&
+        users.size() == 2 && users[0] == make_pair(102, 1) && users[1].second == 0) {
+        testPassed("Rankings stay sorted through borrows, returns and resets");
+    } else {
+        testFailed("Incremental ranking disagreed with a full sort");
+    }
+}
+
+void testDashboardTotals() {
+    printTestHeader("Materialized Dashboard Totals Test");
+
+    const string snapshotPath = "test_library.snapshot";
+    remove(snapshotPath.c_str());
+
+    Library lib;
+    lib.addBook(Book(1, "Dune", "Frank Herbert", "ISBN001", "Sci-Fi", 1, 1));
+    lib.addBook(Book(2, "Emma", "Jane Austen", "ISBN002", "Romance", 2, 2));
+    lib.addBook(Book(3, "Hamlet", "William Shakespeare", "ISBN003", "Drama", 1, 1));
+    lib.addBook(Book(3, "Hamlet", "William Shakespeare", "ISBN003", "Tragedy", 1, 0));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lib.addUser(User(102, "Bob Jones", "bob@example.com", "Student"));
+    lib.borrowBook(101, 1);
+    lib.borrowBook(101, 2);
+    lib.borrowBook(102, 2);
+    lib.returnBook(101, 2);
+
+    // Totals must match a full recount over every book and user
+    auto recount = [](const Library& l) {
+        LibraryTotals t{0, 0, 0, 0, 0};
+        for (const Book& b : l.getAllBooks()) {
+            t.totalBooks++;
+            if (b.getAvailableCopies() > 0) t.availableBooks++;
+            else t.borrowedBooks++;
+        }
+        for (const User& u : l.getAllUsers()) {
+            t.totalUsers++;
+            t.outstandingLoans += u.getBorrowedBooksCount();
+        }
+        return t;
+    };
+    auto same = [](const LibraryTotals& a, const LibraryTotals& b) {
+        return a.totalBooks == b.totalBooks && a.availableBooks == b.availableBooks &&
+               a.borrowedBooks == b.borrowedBooks && a.totalUsers == b.totalUsers &&
+               a.outstandingLoans == b.outstandingLoans;
+    };
+
+    LibraryTotals live = lib.getTotals();
+    vector<CategoryStats> categories = lib.getCategoryStats();
+
+    LibrarySnapshot::write(lib, snapshotPath, 1);
+    Library restored;
+    LibrarySnapshot::load(restored, snapshotPath);
+
+    if (same(live, recount(lib)) && live.totalBooks == 3 && live.borrowedBooks == 2 && live.outstandingLoans == 2 &&
+        categories.size() == 3 && StringPool::shared().str(categories[2].category) == "Tragedy" &&
+        same(restored.getTotals(), live)) {
+        testPassed("Dashboard totals follow every mutation and survive a snapshot");
+    } else {
+        testFailed("Maintained totals drifted from a full recount");
+    }
+
+    remove(snapshotPath.c_str());
+}
+
+void testCirculationSketches() {
+    printTestHeader("Approximate Circulation Sketches Test");
+
+    // Skewed stream: key k occurs (200 / k) times
+    CountMinSketch frequency(512, 4);
+    SpaceSaving<int> hitters(32);
+    HyperLogLog distinct(11);
+    vector<int> exact(1001, 0);
+    for (int key = 1; key <= 1000; key++) {
+        for (int n = 0; n < 200 / key + 1; n++) {
+            frequency.add(key);
+            hitters.offer(key);
+            exact[key]++;
+        }
+    }
+    for (int user = 0; user < 20000; user++) {
+        distinct.add(user);
+        distinct.add(user);
+    }
+
+    bool neverUnder = true;
+    int withinBound = 0;
+    double bound = 2.72 * frequency.getTotal() / 512;
+    for (int key = 1; key <= 1000; key++) {
+        uint32_t estimate = frequency.estimate(key);
+        neverUnder = neverUnder && estimate >= (uint32_t)exact[key];
+        if (estimate - exact[key] <= bound) withinBound++;
+    }
+
+    vector<HeavyHitter<int>> top = hitters.top(3);
+    bool heavy = top.size() == 3 && top[0].key == 1 && top[0].count - top[0].error <= exact[1] &&
+                 top[0].count >= exact[1] && top[1].key == 2;
+    bool cardinality = fabs(distinct.estimate() - 20000) < 20000 * 0.05;
+
+    const string snapshotPath = "test_library.snapshot";
+    remove(snapshotPath.c_str());
+    Library lib;
+    lib.addBook(Book(1, "Dune", "Frank Herbert", "ISBN001", "Sci-Fi", 50, 50));
+    for (int user = 1; user <= 30; user++) {
+        lib.addUser(User(user, "Reader " + to_string(user), "reader" + to_string(user) + "@example.com", "Student"));
+        lib.borrowBook(user, 1);
+    }
+    LibrarySnapshot::write(lib, snapshotPath, 1);
+    Library restored;
+    LibrarySnapshot::load(restored, snapshotPath);
+    remove(snapshotPath.c_str());
+
+    StringPool::Id sciFi = StringPool::shared().intern("sci-fi");
+    const CirculationSketches& live = lib.getCirculationSketches();
+    const CirculationSketches& reloaded = restored.getCirculationSketches();
+    bool fed = live.estimateBorrows(1) == 30 && fabs(live.estimateBorrowers(1) - 30) <= 3 &&
+               fabs(live.estimateCategoryBorrowers(sciFi) - 30) <= 3 && live.mostBorrowed(1)[0].key == 1;
+    bool persisted = reloaded.estimateBorrows(1) == 30 && reloaded.estimateBorrowers(1) == live.estimateBorrowers(1) &&
+                     reloaded.estimateCategoryBorrowers(sciFi) == live.estimateCategoryBorrowers(sciFi);
+
+    // Per-book borrower sketches follow the heavy hitters, so they stay bounded
+    CirculationSketches bounded;
+    for (int book = 1; book <= 200; book++) bounded.recordBorrow(book, book, sciFi);
+    int sketched = 0;
+    for (int book = 1; book <= 200; book++) sketched += bounded.estimateBorrowers(book) > 0;
+    bool capped = sketched == 64 && bounded.estimateBorrowers(1) == 0 && bounded.estimateBorrowers(200) > 0;
+
+    if (neverUnder && withinBound >= 980 && heavy && cardinality && fed && persisted && capped) {
+        testPassed("Sketches stay within their error bounds and survive a snapshot");
+    } else {
+        testFailed("Sketch estimates were outside their bounds or lost on reload");
+    }
+}
+
+void testRollingWindowMetrics() {
+    printTestHeader("Rolling Window Metrics Test");
+
+    // Minute windows over a ring of 5; times are explicit so the test is deterministic
+    RollingCounter counter(60, 5);
+    counter.add(600);
+    counter.add(610, 2);
+    counter.add(680);
+    counter.add(800);
+    vector<uint32_t> early = counter.recent(800, 5);
+    counter.add(300);            // older than the ring: dropped
+    counter.add(1000);           // skips ahead, expiring everything before minute 12
+    vector<uint32_t> late = counter.recent(1000, 5);
+    vector<uint32_t> idle = counter.recent(5000, 3);
+
+    bool ring = early == vector<uint32_t>({1, 0, 1, 3, 0}) && late == vector<uint32_t>({1, 0, 0, 1, 0}) &&
+                idle == vector<uint32_t>({0, 0, 0});
+
+    CirculationMetrics metrics;
+    StringPool::Id fantasy = StringPool::shared().intern("Fantasy");
+    StringPool::Id fantasyFolded = StringPool::shared().folded(fantasy);
+    time_t base = 86400 * 100;
+    metrics.record(CirculationEvent::Borrow, fantasy, base);
+    metrics.record(CirculationEvent::Borrow, fantasy, base + 3600);
+    metrics.record(CirculationEvent::Borrow, StringPool::shared().intern("Poetry"), base + 3610);
+    metrics.record(CirculationEvent::Return, fantasy, base + 3620);
+    metrics.record(CirculationEvent::Registration, StringPool::EMPTY, base + 3630);
+
+    time_t now = base + 3700;
+    auto sum = [](const vector<uint32_t>& v) { uint32_t t = 0; for (uint32_t c : v) t += c; return t; };
+    bool series = sum(metrics.recent(CirculationEvent::Borrow, MetricsResolution::Minute, 60, now)) == 2 &&
+                  sum(metrics.recent(CirculationEvent::Borrow, MetricsResolution::Hour, 2, now)) == 3 &&
+                  sum(metrics.recent(CirculationEvent::Borrow, MetricsResolution::Day, 1, now, fantasyFolded)) == 2 &&
+                  sum(metrics.recent(CirculationEvent::Return, MetricsResolution::Minute, 60, now, fantasyFolded)) == 1 &&
+                  sum(metrics.recent(CirculationEvent::Registration, MetricsResolution::Day, 90, now)) == 1 &&
+                  metrics.recent(CirculationEvent::Borrow, MetricsResolution::Day, 500, now).size() == 90;
+
+    Library lib;
+    lib.addBook(Book(1, "Dune", "Frank Herbert", "ISBN001", "Sci-Fi", 2, 2));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Staff"));
+    lib.borrowBook(101, 1);
+    lib.returnBook(101, 1);
+    time_t t = time(nullptr);
+    const CirculationMetrics& live = lib.getCirculationMetrics();
+    bool wired = sum(live.recent(CirculationEvent::Borrow, MetricsResolution::Hour, 2, t)) == 1 &&
+                 sum(live.recent(CirculationEvent::Return, MetricsResolution::Hour, 2, t)) == 1 &&
+                 sum(live.recent(CirculationEvent::Registration, MetricsResolution::Hour, 2, t)) == 1;
+
+    if (ring && series && wired) {
+        testPassed("Windowed counters roll forward and expire old windows");
+    } else {
+        testFailed("Rolling window counts were wrong");
+    }
+}
+
+void testLoanDueDates() {
+    printTestHeader("Loan Due Dates and Timing Wheel Test");
+
+    // Random timers across several wheel levels, checked against a plain map
+    TimingWheel wheel(1000);
+    map<uint64_t, uint64_t> model;
+    unsigned seed = 11;
+    bool exact = true;
+    for (int round = 0; round < 400 && exact; round++) {
+        for (int i = 0; i < 20; i++) {
+            seed = seed * 1103515245 + 12345;
+            uint64_t id = (seed >> 4) % 500;
+            uint64_t span = (seed >> 16) % 4 == 0 ? 300000 : 5000;
+            seed = seed * 1103515245 + 12345;
+            uint64_t expiry = wheel.now() + (seed >> 8) % span;
+            if ((seed >> 24) % 5 == 0) {
+                wheel.cancel(id);
+                model.erase(id);
+            } else {
+                wheel.schedule(id, expiry);
+                model[id] = expiry;
+            }
+        }
+
+        uint64_t target = wheel.now() + (round % 50 == 0 ? 100000 : 700);
+        vector<pair<uint64_t, uint64_t>> fired;
+        wheel.advance(target, [&fired](uint64_t id, uint64_t expiry) { fired.push_back({id, expiry}); });
+
+        size_t expected = 0;
+        for (auto it = model.begin(); it != model.end();) {
+            if (it->second <= target) {
+                expected++;
+                it = model.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        exact = fired.size() == expected && wheel.size() == model.size();
+        for (size_t i = 1; i < fired.size() && exact; i++) {
+            exact = fired[i - 1].second <= fired[i].second;
+        }
+    }
+
+    const string snapshotPath = "test_library.snapshot";
+    remove(snapshotPath.c_str());
+
+    time_t now = time(nullptr);
+    Library lib;
+    lib.addBook(Book(1, "Dune", "Frank Herbert", "ISBN001", "Sci-Fi", 3, 3));
+    lib.addBook(Book(2, "Emma", "Jane Austen", "ISBN002", "Romance", 3, 3));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lib.addUser(User(102, "Bob Jones", "bob@example.com", "Student"));
+    lib.borrowBook(101, 1, now + 3600);
+    lib.borrowBook(101, 2, now + 7200);
+    lib.borrowBook(102, 1);
+
+    int none = lib.processDueLoans(now + 60);
+    int first = lib.processDueLoans(now + 3700);
+    bool oneOverdue = lib.getOverdueCount() == 1 && lib.isLoanOverdue(101, 1) && !lib.isLoanOverdue(101, 2);
+    lib.returnBook(101, 1);
+    lib.processDueLoans(now + 8000);
+    vector<Loan> overdue = lib.getOverdueLoans(10);
+
+    time_t defaultDue = 0;
+    lib.getLoanDueDate(102, 1, defaultDue);
+
+    LibrarySnapshot::write(lib, snapshotPath, 1);
+    Library restored;
+    LibrarySnapshot::load(restored, snapshotPath);
+    remove(snapshotPath.c_str());
+    time_t restoredDue = 0;
+    restored.getLoanDueDate(101, 2, restoredDue);
+    restored.processDueLoans(now + 8000);
+
+    if (exact && none == 0 && first == 1 && oneOverdue && overdue.size() == 1 && overdue[0].bookID == 2 &&
+        defaultDue >= now + LoanSchedule::DEFAULT_LOAN_SECONDS && restoredDue == now + 7200 &&
+        restored.getOverdueCount() == 1) {
+        testPassed("Loans turn overdue on time and keep their due dates across a snapshot");
+    } else {
+        testFailed("Overdue tracking fired at the wrong time or lost due dates");
+    }
+}
+
+void testBorrowerReverseIndex() {
+    printTestHeader("Book to Borrowers Index Test");
+
+    Library lib;
+    for (int b = 1; b <= 6; b++) {
+        lib.addBook(Book(b, "Volume " + to_string(b), "Author", "ISBN" + to_string(b), "Reference", 10, 10));
+    }
+    for (int u = 1; u <= 8; u++) {
+        lib.addUser(User(u, "Reader " + to_string(u), "reader" + to_string(u) + "@example.com", "Student"));
+    }
+
+    unsigned seed = 3;
+    for (int step = 0; step < 300; step++) {
+        seed = seed * 1103515245 + 12345;
+        int user = 1 + (seed >> 8) % 8;
+        int book = 1 + (seed >> 16) % 6;
+        if (lib.findUserByID(user)->hasBorrowedBook(book)) lib.returnBook(user, book);
+        else lib.borrowBook(user, book);
+    }
+
+    // Compare the index with a scan of every user's loans
+    auto agrees = [](Library& l) {
+        for (int book = 1; book <= 6; book++) {
+            vector<int> expected;
+            for (const User& u : l.getAllUsers()) {
+                if (u.hasBorrowedBook(book)) expected.push_back(u.getUserID());
+            }
+            sort(expected.begin(), expected.end());
+            if (l.getBorrowers(book) != expected) return false;
+        }
+        return true;
+    };
+
+    const vector<int>& loans = lib.findUserByID(3)->getBorrowedBookIDs();
+    bool sortedLoans = is_sorted(loans.begin(), loans.end());
+
+    const string snapshotPath = "test_library.snapshot";
+    remove(snapshotPath.c_str());
+    LibrarySnapshot::write(lib, snapshotPath, 1);
+    Library restored;
+    LibrarySnapshot::load(restored, snapshotPath);
+    remove(snapshotPath.c_str());
+
+    if (agrees(lib) && sortedLoans && agrees(restored) && lib.getBorrowers(99).empty()) {
+        testPassed("Reverse borrower index matches a full scan of users");
+    } else {
+        testFailed("Reverse borrower index disagreed with users' loans");
+    }
+}
+
+void testCoBorrowRecommendations() {
+    printTestHeader("Co-Borrowing Recommendations Test");
+
+    Library lib;
+    for (int b = 1; b <= 60; b++) {
+        lib.addBook(Book(b, "Volume " + to_string(b), "Author", "ISBN" + to_string(b), "Reference", 20, 20));
+    }
+    for (int u = 1; u <= 10; u++) {
+        lib.addUser(User(u, "Reader " + to_string(u), "reader" + to_string(u) + "@example.com", "Student"));
+    }
+
+    // Book 1 goes with book 2 five times, with book 3 twice and book 4 once
+    for (int u = 1; u <= 5; u++) {
+        lib.borrowBook(u, 1);
+        lib.borrowBook(u, 2);
+    }
+    for (int u = 6; u <= 7; u++) {
+        lib.borrowBook(u, 3);
+        lib.borrowBook(u, 1);
+    }
+    lib.borrowBook(8, 1);
+    lib.borrowBook(8, 4);
+
+    vector<HeavyHitter<int>> forFirst = lib.recommendBooks(1, 3);
+    vector<HeavyHitter<int>> forSecond = lib.recommendBooks(2, 5);
+    bool ranked = forFirst.size() == 3 && forFirst[0].key == 2 && forFirst[0].count == 5 &&
+                  forFirst[1].key == 3 && forFirst[1].count == 2 && forFirst[2].key == 4 &&
+                  forSecond.size() == 1 && forSecond[0].key == 1 && lib.recommendBooks(59, 5).empty();
+
+    // One reader holding book 10 borrows 45 others: book 10's list stays capped
+    lib.borrowBook(9, 10);
+    for (int b = 11; b <= 55; b++) lib.borrowBook(9, b);
+    bool capped = (int)lib.recommendBooks(10, 100).size() == CoBorrowIndex::maxRecommendations();
+
+    const string snapshotPath = "test_library.snapshot";
+    remove(snapshotPath.c_str());
+    LibrarySnapshot::write(lib, snapshotPath, 1);
+    Library restored;
+    LibrarySnapshot::load(restored, snapshotPath);
+    remove(snapshotPath.c_str());
+
+    vector<HeavyHitter<int>> afterLoad = restored.recommendBooks(1, 3);
+    bool persisted = afterLoad.size() == 3 && afterLoad[0].key == 2 && afterLoad[0].count == 5 &&
+                     afterLoad[1].key == 3 && (int)restored.recommendBooks(10, 100).size() == CoBorrowIndex::maxRecommendations();
+
+    if (ranked && capped && persisted) {
+        testPassed("Co-borrowed books rank by frequency within a capped neighbour list");
+    } else {
+        testFailed("Co-borrowing recommendations were misranked, uncapped or lost on load");
+    }
+}
+
+// Flattens parser events into one string so runs can be compared
+class RecordingHandler : public JsonHandler {
+public:
+    string events;
+
+    void startObject() override { events += "{"; }
+    void endObject() override { events += "}"; }
+    void startArray() override { events += "["; }
+    void endArray() override { events += "]"; }
+    void key(string_view k) override { events += "k:" + string(k) + ";"; }
+    void stringValue(string_view v) override { events += "s:" + string(v) + ";"; }
+    void numberValue(string_view v) override { events += "n:" + string(v) + ";"; }
+    void boolValue(bool v) override { events += v ? "true;" : "false;"; }
+    void nullValue() override { events += "null;"; }
+};
+
+void testStreamingJsonLoader() {
+    printTestHeader("Streaming JSON Loader Test");
+
+    string doc = " {\"a\": [1, -2.5e3, 0, true, false, null], \"q\\\"k\": \"tab\\there \\u00e9 \\ud83d\\ude00\\/\", \"o\": {}} ";
+    string expected = "{k:a;[n:1;n:-2.5e3;n:0;true;false;null;]k:q\"k;s:tab\there \xC3\xA9 \xF0\x9F\x98\x80/;k:o;{}}";
+
+    // Tiny buffers force every token to straddle a refill
+    bool streamed = true;
+    for (size_t bufferSize : {1, 2, 3, 7, 64}) {
+        RecordingHandler recorder;
+        JsonStreamParser parser(recorder, bufferSize);
+        istringstream in(doc);
+        streamed = streamed && parser.parse(in) && recorder.events == expected;
+    }
+
+    bool rejected = true;
+    for (string bad : {"", "{", "[1,]", "{\"a\":1,}", "{\"a\" 1}", "01", "1.", "-", "tru", "\"\\x\"",
+                       "\"\\ud83d\"", "\"a\nb\"", "[1] 2", "{1:2}", "[}"}) {
+        JsonHandler ignore;
+        JsonStreamParser parser(ignore);
+        rejected = rejected && !parser.parse(bad) && !parser.getError().empty();
+    }
+    JsonHandler ignore;
+    JsonStreamParser deep(ignore);
+    bool depthLimited = !deep.parse(string(JsonStreamParser::MAX_DEPTH + 1, '['));
+
+    string catalog = R"({
+      "meta": {"books": [{"bookID": 99, "title": "Not a record"}]},
+      "books": [
+        {"bookID": 1, "title": "The \"Quoted\" Title", "author": "Poe, Edgar",
+         "tags": [{"title": "nested"}], "copies": 4, "availableCopies": 3,
+         "coverImage": "old.jpg", "cover": "new.jpg", "category": "Horror", "type": "Novel"},
+        {"bookID": "2", "title": "No Cover", "author": "Anon", "copies": 2, "availableCopies": 2,
+         "coverImage": "only.jpg"},
+        {"bookID": 3, "author": "Missing title"}
+      ],
+      "users": [
+        {"id": 7, "name": "Ada", "email": "ada@example.com", "role": "Student", "borrowedBooks": [1, 2]}
+      ]
+    })";
+    Library lib;
+    istringstream in(catalog);
+    bool loaded = DataLoader::loadFromStream(lib, in, "catalog");
+
+    Book* first = lib.findBookByID(1);
+    Book* second = lib.findBookByID(2);
+    User* user = lib.findUserByID(7);
+    bool records = loaded && lib.getTotalBooks() == 2 && lib.getTotalUsers() == 1 && !lib.findBookByID(99) &&
+                   first && first->getTitle() == "The \"Quoted\" Title" && first->getCoverImage() == "new.jpg" &&
+                   first->getCopies() == 4 && first->getAvailableCopies() == 3 && first->getCategory() == "Horror" &&
+                   second && second->getCoverImage() == "only.jpg" && second->getType().empty() &&
+                   user && user->getEmail() == "ada@example.com";
+
+    Library partial;
+    istringstream truncated(catalog.substr(0, catalog.find("{\"bookID\": \"2\"")));
+    bool stopsOnError = !DataLoader::loadFromStream(partial, truncated, "truncated") && partial.getTotalBooks() == 1;
+
+    if (streamed && rejected && depthLimited && records && stopsOnError) {
+        testPassed("Streaming parser handles escapes, nesting and malformed input");
+    } else {
+        testFailed("Streaming JSON parser or catalog loader misbehaved");
+    }
+}
+
+void testParallelCatalogIngest() {
+    printTestHeader("Parallel Catalog Ingest Test");
+
+    const string path = "test_parallel_catalog.json";
+    string catalog = "{\"meta\": {\"note\": \"books: [ignored]\"}, \"books\": [\n";
+    for (int id = 1; id <= 1500; id++) {
+        catalog += "{\"bookID\": " + to_string(id) + ", \"title\": \"Tome {" + to_string(id % 97) +
+                   "} \\\"]\\\" " + to_string(id) + "\", \"author\": \"Writer " + to_string(id % 13) +
+                   "\", \"tags\": [{\"x\": [1, 2]}], \"category\": \"Shelf " + to_string(id % 5) +
+                   "\", \"copies\": 3, \"availableCopies\": " + to_string(id % 4) + "}";
+        catalog += id < 1500 ? ",\n" : "\n";
+    }
+    catalog += "], \"users\": [{\"id\": 1, \"name\": \"Ann\", \"email\": \"ann@example.com\", \"role\": \"Staff\"}]}";
+    ofstream(path, ios::binary) << catalog;
+
+    Library sequential;
+    DataLoader::loadFromFile(sequential, path);
+    vector<Book> expected = sequential.getAllBooks();
+
+    // Tiny blocks make records straddle block boundaries; results must not
+    // depend on the thread count
+    bool sameRecords = true;
+    for (int threads : {1, 3, 8}) {
+        vector<Book> books;
+        vector<User> users;
+        bool ok = DataLoader::parseFileParallel(path, threads, books, users, 97);
+        sameRecords = sameRecords && ok && books.size() == 1500 && users.size() == 1 &&
+                      users[0].getEmail() == "ann@example.com";
+        for (size_t i = 0; i < books.size() && sameRecords; i++) {
+            Book* reference = sequential.findBookByID((int)i + 1);
+            sameRecords = books[i].getBookID() == (int)i + 1 && reference &&
+                          books[i].getTitle() == reference->getTitle() &&
+                          books[i].getAuthor() == reference->getAuthor() &&
+                          books[i].getAvailableCopies() == reference->getAvailableCopies();
+        }
+    }
+
+    Library parallel;
+    bool loaded = DataLoader::loadFromFileParallel(parallel, path, 4);
+    vector<Book> bulk = parallel.getAllBooks();
+    bool sameOrder = loaded && bulk.size() == expected.size();
+    for (size_t i = 0; i < bulk.size() && sameOrder; i++) {
+        sameOrder = bulk[i].getBookID() == expected[i].getBookID();
+    }
+    bool indexed = parallel.searchBookByTitle("tome {42}").size() == sequential.searchBookByTitle("tome {42}").size() &&
+                   parallel.searchBookByCategory("shelf 3").size() == 300 &&
+                   parallel.getTotals().availableBooks == sequential.getTotals().availableBooks &&
+                   parallel.findUserByID(1) != nullptr;
+
+    ofstream(path, ios::binary) << catalog.substr(0, catalog.size() / 2);
+    vector<Book> partial;
+    vector<User> noUsers;
+    bool truncatedFails = !DataLoader::parseFileParallel(path, 2, partial, noUsers, 97) &&
+                          !partial.empty() && partial.size() < 1500;
+    Library rejected;
+    bool nothingLoaded = !DataLoader::loadFromFileParallel(rejected, path, 2) && rejected.getTotalBooks() == 0 &&
+                         rejected.findUserByID(1) == nullptr;
+    remove(path.c_str());
+
+    if (sameRecords && sameOrder && indexed && truncatedFails && nothingLoaded) {
+        testPassed("Parallel ingest matches the sequential loader at every thread count");
+    } else {
+        testFailed("Parallel ingest diverged from the sequential loader");
+    }
+}
+
+void testStructuralJsonIndex() {
+    printTestHeader("Structural JSON Index Test");
+
+    // Bytewise reference: offsets of structurals outside strings and of
+    // unescaped quotes
+    auto reference = [](const string& text) {
+        vector<uint32_t> out;
+        bool inString = false;
+        bool escaped = false;
+        for (size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+            if (inString && escaped) {
+                escaped = false;
+            } else if (inString && c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = !inString;
+                out.push_back((uint32_t)i);
+            } else if (!inString && string("{}[]:,").find(c) != string::npos) {
+                out.push_back((uint32_t)i);
+            }
+        }
+        return out;
+    };
+
+    // Random text over the characters that matter. Backslashes and raw
+    // newlines only make sense inside and outside strings respectively
+    const string alphabet = "\"\\{}[]:, a\n";
+    srand(47);
+    bool matches = true;
+    for (int round = 0; round < 300 && matches; round++) {
+        string text;
+        bool inString = false;
+        size_t length = rand() % 300;
+        while (text.size() < length) {
+            char c = alphabet[rand() % alphabet.size()];
+            if ((c == '\\' && !inString) || (c == '\n' && inString)) continue;
+            if (c == '"') inString = !inString;
+            text += c;
+            if (c == '\\') text += "\"\\n:"[rand() % 4];
+        }
+        vector<uint32_t> expected = reference(text);
+
+        vector<uint32_t> simd, scalar, pieces;
+        JsonStructuralIndex::State a, b, c;
+        JsonStructuralIndex::index(text.data(), text.size(), 0, a, simd);
+        JsonStructuralIndex::index(text.data(), text.size(), 0, b, scalar, true);
+        // Uneven pieces carry open strings and pending escapes across calls
+        for (size_t start = 0; start < text.size();) {
+            size_t n = min(text.size() - start, (size_t)(1 + rand() % 80));
+            JsonStructuralIndex::index(text.data() + start, n, (uint32_t)start, c, pieces);
+            start += n;
+        }
+        matches = simd == expected && scalar == expected && pieces == expected &&
+                  a.inString == inString && c.inString == inString && a.controlCharAt == JsonStructuralIndex::NONE;
+    }
+
+    // A backslash as the last byte of a 64-byte block escapes the next block's quote
+    string straddle = "\"" + string(62, 'x') + "\\\"\" ,";
+    vector<uint32_t> straddled;
+    JsonStructuralIndex::State state;
+    JsonStructuralIndex::index(straddle.data(), straddle.size(), 0, state, straddled);
+    bool carried = straddled == vector<uint32_t>{0, 65, 67} && !state.inString;
+
+    string control = "{\"a\": \"x\ty\"}";
+    JsonStructuralIndex::State controlState;
+    vector<uint32_t> ignored;
+    JsonStructuralIndex::index(control.data(), control.size(), 0, controlState, ignored);
+    bool flagsControl = controlState.controlCharAt == 8;
+
+    // Stage 2 decodes escapes and validates values it cannot read in place
+    const string path = "test_structural_catalog.json";
+    ofstream(path, ios::binary) << "{\"books\": [{\"bookID\": 7, \"title\": \"Caf\\u00e9 \\\"Noir\\\"\", "
+                                   "\"copies\": 2.0, \"extra\": [true, null, {\"k\": -1e3}], \"availableCopies\": \"1\"}]}";
+    vector<Book> books;
+    vector<User> users;
+    bool decoded = DataLoader::parseFileParallel(path, 1, books, users) && books.size() == 1 &&
+                   books[0].getTitle() == "Caf\xc3\xa9 \"Noir\"" && books[0].getAvailableCopies() == 1;
+
+    bool rejects = true;
+    for (const string& bad : {string("{\"books\": [{\"bookID\": 7x, \"title\": \"A\"}]}"),
+                              string("{\"books\": [{\"bookID\": 7 \"title\": \"A\"}]}"),
+                              string("{\"books\": [{\"bookID\" 7, \"title\": \"A\"}]}"),
+                              string("{\"books\": [{\"bookID\": 7, \"title\": \"A\\q\"}]}"),
+                              string("{\"books\": [{\"bookID\": 7, \"title\": \"A\tB\"}]}")}) {
+        ofstream(path, ios::binary) << bad;
+        books.clear();
+        rejects = rejects && !DataLoader::parseFileParallel(path, 1, books, users);
+    }
+    remove(path.c_str());
+
+    if (matches && carried && flagsControl && decoded && rejects) {
+        testPassed(string("Structural index matches a bytewise scan") +
+                   (JsonStructuralIndex::simdEnabled() ? " (SSE2 and scalar)" : " (scalar)"));
+    } else {
+        testFailed("Structural index or stage-2 record reader misbehaved");
+    }
+}
+
+void testMappedCatalogInput() {
+    printTestHeader("Mapped Catalog Input Test");
+
+    const string path = "test_mapped_catalog.json";
+    string catalog = "{\"books\": [";
+    for (int id = 1; id <= 300; id++) {
+        catalog += "{\"bookID\": " + to_string(id) + ", \"title\": \"Mapped " + to_string(id) +
+                   (id % 100 == 0 ? " \\u00e9" : "") + "\", \"author\": \"Writer " + to_string(id % 7) +
+                   "\", \"isbn\": \"M-" + to_string(id) + "\", \"coverImage\": \"old.jpg\"" +
+                   (id % 2 ? ", \"cover\": \"new.jpg\"" : "") + ", \"copies\": 2, \"availableCopies\": 1}";
+        catalog += id < 300 ? ", " : "";
+    }
+    catalog += "], \"users\": [{\"id\": 4, \"name\": \"Dee\", \"email\": \"dee@example.com\", \"role\": \"Member\"}]}";
+    ofstream(path, ios::binary) << catalog;
+
+    MappedFile file;
+    bool mapped = file.open(path) && file.text() == catalog && file.contains(file.text().substr(10, 5)) &&
+                  !file.contains(string_view(catalog).substr(10, 5));
+    // Released pages read back from the file unchanged
+    file.release(0, catalog.size());
+    mapped = mapped && file.text() == catalog;
+    file.close();
+
+    MappedFile missing;
+    ofstream("test_mapped_empty.json", ios::binary).flush();
+    MappedFile empty;
+    bool edgeCases = !missing.open("no_such_catalog.json") && empty.open("test_mapped_empty.json") &&
+                     empty.text().empty();
+    remove("test_mapped_empty.json");
+
+    // Unescaped strings are handed out as views into a string_view input
+    struct ViewChecker : JsonHandler {
+        string_view input;
+        int inside = 0;
+        int copied = 0;
+        void stringValue(string_view v) override {
+            (v.data() >= input.data() && v.data() < input.data() + input.size() ? inside : copied)++;
+        }
+    } checker;
+    checker.input = "[\"plain\", \"esc\\u0041ped\", \"also plain\"]";
+    JsonStreamParser viewParser(checker);
+    bool zeroCopy = viewParser.parse(checker.input) && checker.inside == 2 && checker.copied == 1;
+
+    // Both loaders read the mapping; the results must match field for field
+    Library sequential;
+    bool loaded = DataLoader::loadFromFile(sequential, path);
+    vector<Book> books;
+    vector<User> users;
+    loaded = loaded && DataLoader::parseFileParallel(path, 2, books, users, 512) && books.size() == 300;
+    bool sameFields = loaded && sequential.getTotalBooks() == 300 && users.size() == 1 &&
+                      users[0].getRole() == "Member" && sequential.findUserByID(4) != nullptr;
+    for (size_t i = 0; i < books.size() && sameFields; i++) {
+        Book* reference = sequential.findBookByID(books[i].getBookID());
+        sameFields = reference && reference->getTitle() == books[i].getTitle() &&
+                     reference->getISBN() == books[i].getISBN() &&
+                     reference->getCoverImage() == books[i].getCoverImage() &&
+                     books[i].getCoverImage() == (books[i].getBookID() % 2 ? "new.jpg" : "old.jpg");
+    }
+    Book* escaped = sequential.findBookByID(300);
+    sameFields = sameFields && escaped && escaped->getTitle() == "Mapped 300 \xc3\xa9";
+
+    // A loaded copy does not see the file being truncated under it
+    vector<Book> copiedBooks;
+    vector<User> copiedUsers;
+    MappedFile copied;
+    bool copyStable = DataLoader::parseFileParallel(path, 2, copiedBooks, copiedUsers, 512, true) &&
+                      copiedBooks.size() == 300 && copied.load(path);
+    ofstream(path, ios::binary | ios::trunc).flush();
+    copied.release(0, catalog.size());
+    copyStable = copyStable && copied.text() == catalog && copied.contains(copied.text().substr(10, 5));
+    remove(path.c_str());
+
+    if (mapped && edgeCases && zeroCopy && sameFields && copyStable) {
+        testPassed("Catalogs are parsed in place from a read-only mapping");
+    } else {
+        testFailed("Mapped catalog input misbehaved");
+    }
+}
+
+void testCatalogHotReload() {
+    printTestHeader("Catalog Hot Reload Test");
+
+    const string path = "test_watched_catalog.json";
+    auto writeCatalog = [&](const vector<string>& records) {
+        // Written aside and renamed over the original, as deploy tools do
+        string body = "{\"books\": [";
+        for (size_t i = 0; i < records.size(); i++) body += (i ? ", " : "") + records[i];
+        ofstream(path + ".tmp", ios::binary) << body << "]}";
+        rename((path + ".tmp").c_str(), path.c_str());
+    };
+    auto record = [](int id, const string& title, const string& category, int copies) {
+        return "{\"bookID\": " + to_string(id) + ", \"title\": \"" + title + "\", \"author\": \"Reloaded Author\", "
+               "\"category\": \"" + category + "\", \"copies\": " + to_string(copies) +
+               ", \"availableCopies\": " + to_string(copies) + "}";
+    };
+
+    writeCatalog({record(1, "Quiet Harbor", "Sea", 2), record(2, "Paper Moon", "Sky", 1),
+                  record(3, "Glass Orchard", "Land", 1), record(4, "Stone Choir", "Land", 3)});
+    Library library;
+    DataLoader::loadFromFileParallel(library, path, 1);
+    library.addUser(User(50, "Reader", "reader@example.com", "Student"));
+    library.borrowBook(50, 3);
+    library.borrowBook(50, 4);
+
+    // Reloads are not logged; the return below is
+    const string walPath = "test_watched_catalog.wal";
+    remove(walPath.c_str());
+    WriteAheadLog wal(walPath, WalOptions::parse("none"));
+    bool walOpen = wal.open();
+    library.setWriteAheadLog(&wal);
+
+    // An edit made while nothing watched (say, before a snapshot restore) is
+    // found by the startup parse, which diffs the file against the library
+    writeCatalog({record(1, "Quiet Harbor", "Sea", 2), record(2, "Paper Sun", "Sky", 1),
+                  record(3, "Glass Orchard", "Land", 1), record(4, "Stone Choir", "Land", 3)});
+    CatalogWatcher watcher(library, path, 1);
+    bool started = watcher.start() && walOpen;
+    CatalogReloadStats offline;
+    for (int wait = 0; wait < 100 && offline.added + offline.changed + offline.removed == 0; wait++) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        offline = watcher.applyPending();
+    }
+    started = started && offline.changed == 1 && offline.added + offline.removed == 0 &&
+              library.findBookByID(2) && library.findBookByID(2)->getTitle() == "Paper Sun";
+
+    // Retitle 1, drop 2 (free) and 3 (on loan), shrink 4 under its loan, add 5
+    writeCatalog({record(1, "Quiet Lighthouse", "Sea", 2), record(4, "Stone Choir", "Land", 1),
+                  record(5, "Amber Road", "Sky", 4)});
+    CatalogReloadStats stats;
+    for (int wait = 0; wait < 100 && stats.added + stats.changed + stats.removed == 0; wait++) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        stats = watcher.applyPending();
+    }
+
+    Book* retitled = library.findBookByID(1);
+    Book* shrunk = library.findBookByID(4);
+    bool applied = started && wal.getLastLsn() == 0 && stats.added == 1 && stats.changed == 2 && stats.removed == 1 && stats.deferred == 1 &&
+                   retitled && retitled->getTitle() == "Quiet Lighthouse" &&
+                   library.searchBookByTitle("Quiet Harbor").empty() &&
+                   library.searchBookByTitle("Lighthouse").size() == 1 &&
+                   !library.findBookByID(2) && library.findBookByID(5) &&
+                   library.searchBookByCategory("Sky").size() == 1 && library.getTotalBooks() == 4;
+    // Loans and users survive: 3 stays while borrowed, 4 keeps its copy on loan
+    User* reader = library.findUserByID(50);
+    bool loansKept = library.findBookByID(3) && shrunk && shrunk->getCopies() == 1 &&
+                     shrunk->getAvailableCopies() == 0 && reader && reader->getBorrowedBooksCount() == 2 &&
+                     library.getTotals().outstandingLoans == 2;
+
+    // Returning the last copy lets the deferred removal through
+    library.returnBook(50, 3);
+    CatalogReloadStats retry = watcher.applyPending();
+    bool retried = retry.removed == 1 && !library.findBookByID(3) && library.searchBookByCategory("Land").size() == 1 &&
+                   wal.getLastLsn() == 1;
+    // The removed book leaves the borrow rankings and co-borrowing summaries
+    for (const auto& ranked : library.getMostBorrowedBooks(10)) retried = retried && ranked.first != 3;
+    retried = retried && library.recommendBooks(4).empty();
+
+    // A file that does not parse leaves the catalog alone
+    ofstream(path + ".tmp", ios::binary) << "{\"books\": [" << record(6, "Half", "Sea", 1);
+    rename((path + ".tmp").c_str(), path.c_str());
+    this_thread::sleep_for(chrono::milliseconds(CatalogWatcher::SETTLE_MS + 300));
+    CatalogReloadStats broken = watcher.applyPending();
+    bool ignoresBroken = broken.added + broken.changed + broken.removed == 0 && !library.findBookByID(6) &&
+                         library.getTotalBooks() == 3;
+    watcher.stop();
+    library.setWriteAheadLog(nullptr);
+    wal.close();
+    remove(path.c_str());
+    remove(walPath.c_str());
+
+    if (applied && loansKept && retried && ignoresBroken) {
+        testPassed("Catalog changes are applied incrementally without touching loans");
+    } else {
+        testFailed("Catalog hot reload misapplied the file changes");
+    }
+}
+
+void testBulkBookImport() {
+    printTestHeader("Bulk Book Import Test");
+
+    Library library;
+    library.addBook(Book(1, "Existing Title", "Someone", "ISBN-1", "Fiction", 1, 1));
+
+    // Fed three bytes at a time so records and strings straddle the pieces
+    auto feedInPieces = [](BookImporter& importer, const string& data) {
+        for (size_t i = 0; i < data.size(); i += 3) importer.feed(string_view(data).substr(i, 3));
+    };
+
+    string ndjson =
+        "{\"bookID\": 10, \"title\": \"River \\\"Song\\\"\", \"author\": \"Ada North\", \"category\": \"Poetry\", \"copies\": 3}\n"
+        "{\"bookID\": 11, \"title\": \"Salt Lines\", \"author\": \"Ada North\", \"tags\": [\"x\"], \"availableCopies\": 1, \"copies\": 2}\r\n"
+        "\n"
+        "{\"bookID\": 1, \"title\": \"Taken ID\"}\n"
+        "{\"bookID\": 12, \"title\": \"\"}\n"
+        "{\"bookID\": 13, \"title\": \"Broken\"\n"
+        "[1, 2]\n"
+        "{\"bookID\": 14, \"title\": \"Too Many Out\", \"copies\": 1, \"availableCopies\": 2}\n"
+        "{\"bookID\": 10, \"title\": \"Duplicate\"}\n"
+        "{\"bookID\": 15, \"title\": \"No Newline\"}";
+    BookImporter json(library, BookImporter::Format::NDJSON);
+    feedInPieces(json, ndjson);
+    ImportReport jsonReport = json.finish();
+
+    vector<size_t> badLines;
+    for (const auto& e : jsonReport.errors) badLines.push_back(e.record);
+    Book* quoted = library.findBookByID(10);
+    Book* partial = library.findBookByID(11);
+    bool jsonOk = jsonReport.imported == 3 && jsonReport.rejected == 6 &&
+                  badLines == vector<size_t>({4, 5, 6, 7, 8, 9}) &&
+                  quoted && quoted->getTitle() == "River \"Song\"" && quoted->getCopies() == 3 &&
+                  quoted->getAvailableCopies() == 3 && partial && partial->getAvailableCopies() == 1 &&
+                  library.findBookByID(15) && library.findBookByID(1)->getTitle() == "Existing Title" &&
+                  library.searchBookByCategory("Poetry").size() == 1 &&
+                  library.searchBookByAuthor("Ada North").size() == 2;
+
+    string csv =
+        "id,title,author,category,copies,notes\r\n"
+        "20,\"Commas, Quotes \"\"and\"\" Lines\",Bo Lake,Essays,2,\"spans\ntwo lines\"\r\n"
+        "21,Plain Title,Bo Lake,Essays,1,\n"
+        "22,Short Row\n"
+        "x,Bad ID,Bo Lake,Essays,1,\n"
+        "23,Negative,Bo Lake,Essays,-1,\n";
+    BookImporter table(library, BookImporter::Format::CSV);
+    feedInPieces(table, csv);
+    ImportReport csvReport = table.finish();
+
+    Book* commas = library.findBookByID(20);
+    bool csvOk = csvReport.imported == 2 && csvReport.rejected == 3 && csvReport.errors.size() == 3 &&
+                 csvReport.errors[0].record == 3 && csvReport.errors[1].record == 4 &&
+                 csvReport.errors[2].record == 5 &&
+                 commas && commas->getTitle() == "Commas, Quotes \"and\" Lines" &&
+                 library.searchBookByTitle("Plain Title").size() == 1 &&
+                 library.searchBookByCategory("Essays").size() == 2 && library.getTotalBooks() == 6;
+
+    // Several batches, so both addBooks paths run, in descending ID order so
+    // the posting lists are merged rather than appended to
+    BookImporter many(library, BookImporter::Format::NDJSON);
+    for (int id = 999 + 3 * (int)BookImporter::BATCH_SIZE; id >= 1000; id--) {
+        many.feed("{\"bookID\": " + to_string(id) + ", \"title\": \"Batch Book " + to_string(id) +
+                  "\", \"category\": \"Batch\"}\n");
+    }
+    ImportReport manyReport = many.finish();
+    bool batchesOk = manyReport.imported == 3 * BookImporter::BATCH_SIZE && manyReport.rejected == 0 &&
+                     library.searchBookByCategory("Batch").size() == 3 * BookImporter::BATCH_SIZE &&
+                     library.findBookByID(1000) && library.findBookByID(1000)->getTitle() == "Batch Book 1000" &&
+                     library.searchBookByTitle("Batch Book " + to_string(999 + 3 * BookImporter::BATCH_SIZE)).size() == 1 &&
+                     library.searchBookByTitle("Batch Book 512").size() == 10 &&
+                     library.searchBookByTitleFuzzy("Salt Lnes").size() == 1 &&
+                     library.searchBookByTitle("Salt Lines").size() == 1;
+
+    BookImporter::Format format;
+    bool formatsOk = BookImporter::parseFormat("application/x-ndjson; charset=utf-8", format) &&
+                     format == BookImporter::Format::NDJSON &&
+                     BookImporter::parseFormat("text/csv", format) && format == BookImporter::Format::CSV &&
+                     !BookImporter::parseFormat("application/json", format);
+
+    if (jsonOk && csvOk && batchesOk && formatsOk) {
+        testPassed("NDJSON and CSV imports stream, validate and report per record");
+    } else {
+        testFailed("Bulk import mis-parsed or mis-reported records");
+    }
+}
+
 void testStressTestWithManyBooks() {
     printTestHeader("Stress Test with Many Books");
     
@@ -413,6 +1770,279 @@ void testStressTestWithManyBooks() {
     }
 }
 
+void testWriteAheadLogReplay() {
+    printTestHeader("Write-Ahead Log Replay Test");
+
+    const string walPath = "test_library.wal";
+    remove(walPath.c_str());
+
+    {
+        WriteAheadLog wal(walPath, WalOptions::parse("always"));
+        wal.open();
+
+        Library lib;
+        lib.setWriteAheadLog(&wal);
+        lib.addBook(Book(1, "1984", "George Orwell", "ISBN001", "Dystopian", 2, 2));
+        lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+        lib.borrowBook(101, 1);
+        lib.returnBook(101, 1);
+        lib.borrowBook(101, 1);
+    }
+
+    // Simulate a crash in the middle of writing the next record
+    {
+        ofstream torn(walPath, ios::binary | ios::app);
+        torn.write("\x20\x00\x00\x00garb", 8);
+    }
+
+    WriteAheadLog wal(walPath, WalOptions::parse("always"));
+    Library restored;
+    int replayed = wal.open() ? wal.replay(restored) : 0;
+
+    User* user = restored.findUserByID(101);
+    if (replayed == 5 && user != nullptr && user->hasBorrowedBook(1) && restored.getTotalBooks() == 1) {
+        testPassed("WAL replay restores books, users and loans");
+    } else {
+        testFailed("WAL replay incomplete", "Replayed " + to_string(replayed) + " operations");
+    }
+
+    if (wal.getLastLsn() == 5) {
+        testPassed("Torn tail is discarded on open");
+    } else {
+        testFailed("Torn tail handling", "Last LSN " + to_string(wal.getLastLsn()));
+    }
+
+    wal.close();
+    remove(walPath.c_str());
+}
+
+void testWriteAheadLogGroupCommit() {
+    printTestHeader("Write-Ahead Log Group Commit Test");
+
+    const string walPath = "test_group_commit.wal";
+    remove(walPath.c_str());
+
+    WriteAheadLog wal(walPath, WalOptions::parse("always"));
+    wal.open();
+
+    vector<thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&wal, t]() {
+            for (int i = 0; i < 50; i++) {
+                wal.logBorrow(t, i, 0);
+            }
+        });
+    }
+    for (auto& w : writers) {
+        w.join();
+    }
+
+    bool concurrent = wal.getLastLsn() == 200 && wal.getDurableLsn() == 200;
+
+    // With deferred sync a single thread queues several appends and makes
+    // them durable together, as the server does per batch of requests
+    wal.setDeferredSync(true);
+    for (int i = 0; i < 10; i++) {
+        wal.logReturn(1, i);
+    }
+    bool queued = wal.getLastLsn() == 210 && wal.getDurableLsn() == 200;
+    bool synced = wal.sync() && wal.getDurableLsn() == 210;
+    wal.setDeferredSync(false);
+
+    if (concurrent && queued && synced) {
+        testPassed("Concurrent and deferred appends are all durable");
+    } else {
+        testFailed("Concurrent appends lost", "Durable LSN " + to_string(wal.getDurableLsn()));
+    }
+
+    wal.close();
+    remove(walPath.c_str());
+}
+
+void testWriteAheadLogWriteFailure() {
+    printTestHeader("Write-Ahead Log Write Failure Test");
+
+    const string walPath = "test_failing.wal";
+    remove(walPath.c_str());
+
+    Library library;
+    WriteAheadLog wal(walPath, WalOptions::parse("always"));
+    wal.open();
+    library.setWriteAheadLog(&wal);
+    library.addBook(Book(1, "Logged Book", "Writer", "ISBN-1", "Fiction", 1, 1));
+
+    // A batch is one write and one fsync, with a record per book
+    uint64_t beforeBatch = wal.getLastLsn();
+    library.addBooks({Book(10, "Batch A", "Writer", "ISBN-10", "Fiction", 1, 1),
+                      Book(11, "Batch B", "Writer", "ISBN-11", "Fiction", 1, 1)});
+    bool batchLogged = wal.getLastLsn() == beforeBatch + 2 && wal.getDurableLsn() == wal.getLastLsn() &&
+                       library.findBookByID(11);
+
+    auto fileSize = [&walPath]() {
+        struct stat st;
+        return stat(walPath.c_str(), &st) == 0 ? (long)st.st_size : -1L;
+    };
+    long goodSize = fileSize();
+
+    // A file size limit just past the current end makes the next record a short write
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit saved;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    rlimit limited = saved;
+    limited.rlim_cur = (rlim_t)goodSize + 10;
+    setrlimit(RLIMIT_FSIZE, &limited);
+
+    bool refused = false;
+    try {
+        library.addBooks({Book(2, "Torn Book", "Writer", "ISBN-2", "Fiction", 1, 1),
+                          Book(20, "Torn Too", "Writer", "ISBN-20", "Fiction", 1, 1)});
+    } catch (const runtime_error&) {
+        refused = true;
+    }
+    setrlimit(RLIMIT_FSIZE, &saved);
+
+    bool stopped = false;
+    try {
+        library.addUser(User(7, "Reader", "reader@example.com", "Student"));
+    } catch (const runtime_error&) {
+        stopped = true;
+    }
+    bool failedCleanly = refused && stopped && wal.hasFailed() && !library.findBookByID(2) &&
+                         !library.findBookByID(20) && fileSize() == goodSize;
+
+    // A bulk import stops at the refused batch and reports it instead of throwing
+    BookImporter importer(library, BookImporter::Format::NDJSON);
+    for (int id = 100; id < 100 + (int)BookImporter::BATCH_SIZE + 2; id++) {
+        importer.feed("{\"bookID\": " + to_string(id) + ", \"title\": \"Refused\"}\n");
+    }
+    ImportReport importReport = importer.finish();
+    bool importStopped = !importReport.failure.empty() && importReport.imported == 0 &&
+                         importReport.rejected == 0 && !library.findBookByID(100) &&
+                         !library.findBookByID(100 + (int)BookImporter::BATCH_SIZE + 1);
+
+    // A reset (after a snapshot) makes the log usable again
+    bool recovered = wal.reset();
+    library.addBook(Book(3, "After Reset", "Writer", "ISBN-3", "Fiction", 1, 1));
+    recovered = recovered && !wal.hasFailed() && library.findBookByID(3);
+    library.setWriteAheadLog(nullptr);
+    wal.close();
+
+    Library replayed;
+    WriteAheadLog reopened(walPath, WalOptions::parse("none"));
+    reopened.open();
+    int applied = reopened.replay(replayed);
+    reopened.close();
+    remove(walPath.c_str());
+
+    if (batchLogged && failedCleanly && importStopped && recovered && applied == 1 && replayed.findBookByID(3)) {
+        testPassed("A failed write is truncated away and the change refused");
+    } else {
+        testFailed("Write failure left the log or library inconsistent");
+    }
+}
+
+void testSnapshotRoundTrip() {
+    printTestHeader("Snapshot Round Trip Test");
+
+    const string snapshotPath = "test_library.snapshot";
+    remove(snapshotPath.c_str());
+
+    Library lib;
+    lib.addBook(Book(1, "1984", "George Orwell", "ISBN001", "Dystopian", 2, 2));
+    lib.addBook(Book(2, "Animal Farm", "George Orwell", "ISBN002", "Satire", 3, 3));
+    lib.addBook(Book(3, "Emma", "Jane Austen", "ISBN003", "Romance", 1, 1));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lib.borrowBook(101, 2);
+
+    SnapshotInfo written;
+    bool wroteOk = LibrarySnapshot::write(lib, snapshotPath, 42, &written);
+
+    Library restored;
+    SnapshotInfo loaded;
+    bool loadedOk = LibrarySnapshot::load(restored, snapshotPath, &loaded);
+
+    User* user = restored.findUserByID(101);
+    auto byAuthor = restored.searchBookByAuthor("orwell");
+    auto mostBorrowed = restored.getMostBorrowedBooks(1);
+
+    if (wroteOk && loadedOk && loaded.walLsn == 42 && restored.getTotalBooks() == 3 &&
+        byAuthor.size() == 2 && user != nullptr && user->hasBorrowedBook(2) &&
+        !mostBorrowed.empty() && mostBorrowed[0].first == 2) {
+        testPassed("Snapshot restores books, users, loans and borrow counts");
+    } else {
+        testFailed("Snapshot round trip lost state");
+    }
+
+    remove(snapshotPath.c_str());
+}
+
+void testCatalogSegmentOverlay() {
+    printTestHeader("Catalog Segment Overlay Test");
+
+    const string segmentPath = "test_library.catalog";
+    vector<Book> compiled = {
+        Book(1, "1984", "George Orwell", "ISBN001", "Dystopian", 2, 2),
+        Book(2, "Animal Farm", "George Orwell", "ISBN002", "Satire", 3, 3),
+        Book(3, "Emma", "Jane Austen", "ISBN003", "Romance", 1, 1)
+    };
+    bool built = CatalogSegment::build(compiled, segmentPath);
+
+    Library lib;
+    bool attached = built && lib.attachCatalog(segmentPath);
+    lib.addBook(Book(4, "Brave New World", "Aldous Huxley", "ISBN004", "Dystopian", 1, 1));
+    lib.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+
+    Book* fromSegment = lib.findBookByID(2);
+    bool segmentRead = fromSegment != nullptr && fromSegment->getTitle() == "Animal Farm";
+
+    auto dystopian = lib.searchBookByCategory("dystopian");
+    bool merged = dystopian.size() == 2 && dystopian[0].getTitle() == "1984" &&
+                  dystopian[1].getTitle() == "Brave New World";
+
+    bool borrowed = lib.borrowBook(101, 2);
+    Book* edited = lib.findBookByID(2);
+    bool copiedOnWrite = edited != nullptr && edited->getAvailableCopies() == 2;
+
+    vector<Book> all = lib.getAllBooks();
+    bool counted = lib.getTotalBooks() == 4 && all.size() == 4;
+
+    // Indexes are built on first use, so changes made before any query
+    // must still show up in it
+    Library lazy;
+    lazy.attachCatalog(segmentPath);
+    lazy.addUser(User(101, "Alice Smith", "alice@example.com", "Student"));
+    lazy.borrowBook(101, 3);
+    lazy.addBook(Book(5, "Persuasion", "Jane Austen", "ISBN005", "Romance", 1, 1));
+    LibraryTotals totals = lazy.getTotals();
+    int romanceBefore = 0;
+    for (const auto& c : lazy.getCategoryStats()) {
+        if (StringPool::shared().str(c.category) == "Romance") romanceBefore = c.totalBooks;
+    }
+    auto austen = lazy.searchBookByAuthor("austen");
+    auto ranked = lazy.rankBooks("persuasion", 5);
+    bool lazyOk = totals.totalBooks == 4 && totals.borrowedBooks == 1 && romanceBefore == 2 && austen.size() == 2 &&
+                  lazy.searchBookByCategory("romance").size() == 2 && !ranked.empty() &&
+                  ranked[0].bookID == 5 && lazy.suggestTitles("em").size() == 1;
+
+    // A title index entry past the record table is refused at open
+    {
+        fstream patch(segmentPath, ios::in | ios::out | ios::binary);
+        uint32_t bogus = 1000;
+        patch.seekp(64 + 3 * sizeof(CatalogRecord));
+        patch.write((const char*)&bogus, sizeof(bogus));
+    }
+    CatalogSegment corrupt;
+    bool rejectsCorrupt = !corrupt.open(segmentPath);
+
+    if (attached && segmentRead && merged && borrowed && copiedOnWrite && counted && lazyOk && rejectsCorrupt) {
+        testPassed("Segment books are served and edited through the heap overlay");
+    } else {
+        testFailed("Catalog segment overlay returned wrong results");
+    }
+
+    remove(segmentPath.c_str());
+}
+
 void runAllTests() {
     cout << YELLOW << "\n╔════════════════════════════════════════════╗" << RESET << endl;
     cout << YELLOW << "║  Library Management System - Test Suite   ║" << RESET << endl;
@@ -422,21 +2052,51 @@ void runAllTests() {
     testBTreeSearchNotFound();
     testBTreeTraversal();
     testBTreeLargeDataset();
+    testBTreeBulkLoad();
+    testBTreeRemove();
 
     testBookComparison();
+    testBookColdDetails();
+    testPrecomputedSortKeys();
 
     testLibraryAddBooks();
     testLibrarySearchByTitle();
     testLibrarySearchByAuthor();
     testCaseInsensitiveSearch();
+    testTrigramSearch();
+    testRankedFullTextSearch();
+    testAutocompleteTrie();
+    testFuzzyTitleSearch();
+    testQueryPlanner();
+    testStringInterning();
     testLibraryAddUsers();
     testLibraryUserLookupByID();
     testLibraryUserLookupByEmail();
     testLibraryBorrowBook();
     testLibraryReturnBook();
+    testLoanDueDates();
+    testBorrowerReverseIndex();
+    testCoBorrowRecommendations();
+    testStreamingJsonLoader();
+    testParallelCatalogIngest();
+    testStructuralJsonIndex();
+    testMappedCatalogInput();
+    testCatalogHotReload();
+    testBulkBookImport();
     testLibraryStatistics();
+    testRankedCounterTopK();
+    testCategoryIndexCounts();
+    testDashboardTotals();
+    testCirculationSketches();
+    testRollingWindowMetrics();
     testStressTestWithManyBooks();
 
+    testWriteAheadLogReplay();
+    testWriteAheadLogGroupCommit();
+    testWriteAheadLogWriteFailure();
+    testSnapshotRoundTrip();
+    testCatalogSegmentOverlay();
+
     cout << "\n" << YELLOW << "╔════════════════════════════════════════════╗" << RESET << endl;
     cout << YELLOW << "║            TEST SUMMARY                    ║" << RESET << endl;
     cout << YELLOW << "╚════════════════════════════════════════════╝" << RESET << endl;